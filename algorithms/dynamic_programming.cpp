@@ -1,8 +1,18 @@
 #include "dynamic_programming.h"
+#include "sorting.h" // argsort, which orders the pairs of the batches by length
 
+#include "../data_structures/matrix.h"
+#include "../data_structures/simd.h"
+#include "../data_structures/thread_pool.h"
 #include "../data_structures/vector.h"
 
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
 
 uint64_t ghl::fib_dp(unsigned n)
 {
@@ -153,6 +163,137 @@ uint64_t ghl::assembly_line_dp
 	}
 }
 
+namespace
+{
+	/*
+	* Where the DP algorithms write the directions of the row i: row(i), which they fill and then pass to store(i).
+	* Tables indexed by [i][j] (a ghl::matrix, or a vector of vectors) are written in place
+	*/
+	template <typename Directions>
+	class direction_rows
+	{
+	public:
+		direction_rows(Directions& directions, size_t) : m_directions(directions) {}
+
+		ghl::subsequence_direction* row(size_t i) { return &m_directions[i][0]; }
+		void store(size_t) {}
+
+	private:
+		Directions& m_directions;
+	};
+
+	// the packed directions are written in a buffer of one row, which is packed into the row i by store(i)
+	template <>
+	class direction_rows<ghl::packed_matrix<ghl::subsequence_direction>>
+	{
+	public:
+		direction_rows(ghl::packed_matrix<ghl::subsequence_direction>& directions, size_t n) : m_directions(directions), m_row(n)
+		{
+			for (size_t j = 0; j != n; ++j) m_row.push_back(ghl::subsequence_direction::top_left);
+		}
+
+		ghl::subsequence_direction* row(size_t) { return m_row.begin(); }
+		void store(size_t i) { m_directions.store_row(i, m_row.begin()); }
+
+	private:
+		ghl::packed_matrix<ghl::subsequence_direction>& m_directions;
+		ghl::vector<ghl::subsequence_direction> m_row;
+	};
+
+	/*
+	* longest_common_subsequence on directions that already have m+1 rows of n+1 cells (a ghl::matrix, a packed matrix, or a vector of vectors),
+	* where the cell (i, j) is for the first i elements of first and the first j elements of second
+	*/
+	template <typename Directions>
+	int lcs_with_directions(const ghl::vector<char>& first, const ghl::vector<char>& second, Directions& directions)
+	{
+		const size_t m = first.size(), n = second.size();
+
+		// length_matrix[i][j] = length of LCS(first_i, second_j), which is 0 if either is empty
+		ghl::matrix<int> length_matrix(m + 1, n + 1, 0);
+
+		// the row 0 and the column 0 of directions are left top_left
+		direction_rows<Directions> rows(directions, n + 1);
+		for (size_t i = 1; i <= m; ++i)
+		{
+			ghl::subsequence_direction* row = rows.row(i);
+			for (size_t j = 1; j <= n; ++j)
+			{
+				// at this time, [i-1][any], [i][j-1] are all calculated
+
+				if (first[i - 1] == second[j - 1]) // length is length_matrix[i - 1][j - 1] + 1;
+				{
+					length_matrix[i][j] = length_matrix[i - 1][j - 1] + 1;
+					row[j] = ghl::subsequence_direction::top_left;
+				}
+				else
+				{
+					// length is the max of the two
+					if (length_matrix[i - 1][j] >= length_matrix[i][j - 1])
+					{
+						length_matrix[i][j] = length_matrix[i - 1][j];
+						row[j] = ghl::subsequence_direction::top;
+					}
+					else
+					{
+						length_matrix[i][j] = length_matrix[i][j - 1];
+						row[j] = ghl::subsequence_direction::left;
+					}
+				}
+			}
+			rows.store(i);
+		}
+
+		return length_matrix[m][n];
+	}
+
+	/*
+	* print_longest_common_subsequence on the directions of lcs_with_directions,
+	* from the cell (i, j) for the first i elements of first and the first j elements of second
+	*/
+	template <typename Directions>
+	void print_lcs(const ghl::vector<char>& first, const Directions& directions, size_t i, size_t j)
+	{
+		if (0 == i || 0 == j) return;
+
+		switch (directions[i][j])
+		{
+		case ghl::subsequence_direction::top_left:
+			print_lcs(first, directions, i - 1, j - 1);
+			std::cout << first[i - 1];
+			break;
+		case ghl::subsequence_direction::top:
+			print_lcs(first, directions, i - 1, j);
+			break;
+		case ghl::subsequence_direction::left:
+			print_lcs(first, directions, i, j - 1);
+			break;
+		}
+	}
+}
+
+int ghl::longest_common_subsequence
+(
+	const ghl::vector<char>& first,
+	const ghl::vector<char>& second,
+	ghl::matrix<ghl::subsequence_direction>& directions
+)
+{
+	directions = ghl::matrix<ghl::subsequence_direction>(first.size() + 1, second.size() + 1);
+	return lcs_with_directions(first, second, directions);
+}
+
+int ghl::longest_common_subsequence
+(
+	const ghl::vector<char>& first,
+	const ghl::vector<char>& second,
+	ghl::packed_matrix<ghl::subsequence_direction>& directions
+)
+{
+	directions = ghl::packed_matrix<ghl::subsequence_direction>(first.size() + 1, second.size() + 1);
+	return lcs_with_directions(first, second, directions);
+}
+
 int ghl::longest_common_subsequence
 (
 	const ghl::vector<char>& first,
@@ -160,93 +301,315 @@ int ghl::longest_common_subsequence
 	ghl::vector<ghl::vector<ghl::subsequence_direction>>& directions
 )
 {
-	// length_matrix[i][j] = length of LCS(first_i, second_j)
-	ghl::vector<ghl::vector<int>> length_matrix;
+	const size_t m = first.size(), n = second.size();
 
-	auto m = first.size(), n = second.size();
+	directions.resize(m + 1);
+	for (size_t i = 0; i != m + 1; ++i)
+	{
+		// construct the columns that are of size n+1, top_left where lcs_with_directions leaves them
+		directions.emplace_back(n + 1);
+		for (size_t j = 0; j != n + 1; ++j) directions[i].push_back(ghl::subsequence_direction::top_left);
+	}
+
+	return lcs_with_directions(first, second, directions);
+}
 
-	length_matrix.resize(m);
-	for (int i = 0; i != m; ++i)
+void ghl::print_longest_common_subsequence
+(
+	const ghl::vector<char>& first,
+	const ghl::vector<ghl::vector<subsequence_direction>>& directions,
+	size_t i, size_t j
+)
+{
+	print_lcs(first, directions, i, j);
+}
+
+namespace
+{
+	/*
+	* Computes row[j] = the length of the LCS of first[a_begin, a_end) and the first j elements of second[b_begin, b_end),
+	* or, if Reversed, of the two ranges read backwards, for 0 <= j <= b_end - b_begin
+	*/
+	template <bool Reversed>
+	void lcs_last_row
+	(
+		const ghl::vector<char>& first, size_t a_begin, size_t a_end,
+		const ghl::vector<char>& second, size_t b_begin, size_t b_end,
+		int* row
+	)
 	{
-		// construct the columns that are of size n
-		length_matrix.emplace_back(n);
-		length_matrix.increase_size(n);
+		const size_t n = b_end - b_begin;
+		for (size_t j = 0; j != n + 1; ++j) row[j] = 0;
+
+		for (size_t i = 0; i != a_end - a_begin; ++i)
+		{
+			const char a = Reversed ? first[a_end - 1 - i] : first[a_begin + i];
+			int diagonal = 0; // row[j - 1] of the previous row
+			for (size_t j = 1; j != n + 1; ++j)
+			{
+				const char b = Reversed ? second[b_end - j] : second[b_begin + j - 1];
+				const int top = row[j];
+				row[j] = (a == b) ? diagonal + 1 : (top >= row[j - 1] ? top : row[j - 1]);
+				diagonal = top;
+			}
+		}
 	}
 
-	directions.resize(m);
-	for (int i = 0; i != m; ++i)
+	// appends an LCS of first[a_begin, a_end) and second[b_begin, b_end) to lcs, using forward and backward as rows of |second| + 1
+	void hirschberg
+	(
+		const ghl::vector<char>& first, size_t a_begin, size_t a_end,
+		const ghl::vector<char>& second, size_t b_begin, size_t b_end,
+		int* forward, int* backward, ghl::vector<char>& lcs
+	)
 	{
-		// construct the columns that are of size n 
-		directions.emplace_back(n);
-		directions[i].increase_size(n);
+		if (a_begin == a_end || b_begin == b_end) return;
+
+		if (a_end - a_begin == 1)
+		{
+			for (size_t j = b_begin; j != b_end; ++j)
+			{
+				if (first[a_begin] == second[j])
+				{
+					lcs.push_back(first[a_begin]);
+					break;
+				}
+			}
+			return;
+		}
+
+		// the LCS goes through (mid, b_begin + k) for the k that maximizes the lengths of the two halves
+		const size_t mid = a_begin + (a_end - a_begin) / 2, n = b_end - b_begin;
+		lcs_last_row<false>(first, a_begin, mid, second, b_begin, b_end, forward);
+		lcs_last_row<true>(first, mid, a_end, second, b_begin, b_end, backward);
+
+		size_t k = 0;
+		int best = -1;
+		for (size_t j = 0; j != n + 1; ++j)
+		{
+			if (forward[j] + backward[n - j] > best)
+			{
+				best = forward[j] + backward[n - j];
+				k = j;
+			}
+		}
+
+		hirschberg(first, a_begin, mid, second, b_begin, b_begin + k, forward, backward, lcs);
+		hirschberg(first, mid, a_end, second, b_begin + k, b_end, forward, backward, lcs);
 	}
+}
 
-	// now we calculate the lengths and directions
+int ghl::longest_common_subsequence_length(const ghl::vector<char>& first, const ghl::vector<char>& second)
+{
+	// the row goes along the shorter sequence
+	const ghl::vector<char>& rows = first.size() >= second.size() ? first : second;
+	const ghl::vector<char>& columns = first.size() >= second.size() ? second : first;
 
-	// base case:
-	for (int i = 0; i != m; ++i)
+	ghl::vector<int> row(columns.size() + 1);
+	row.increase_size(columns.size() + 1);
+	lcs_last_row<false>(rows, 0, rows.size(), columns, 0, columns.size(), row.begin());
+	return row[columns.size()];
+}
+
+int ghl::longest_common_subsequence_length_bit_parallel(const ghl::vector<char>& first, const ghl::vector<char>& second)
+{
+	// the bits go along the shorter sequence
+	const ghl::vector<char>& bits = first.size() <= second.size() ? first : second;
+	const ghl::vector<char>& steps = first.size() <= second.size() ? second : first;
+
+	const size_t m = bits.size(), num_words = (m + 63) / 64;
+	if (0 == m) return 0;
+
+	// symbol[c] = the index of the match mask of c + 1, or 0 if c is not in bits
+	size_t symbol[256] = {};
+	size_t num_symbols = 0;
+	for (size_t i = 0; i != m; ++i)
 	{
-		length_matrix[i][0] = 0;
+		auto& s = symbol[(unsigned char)bits[i]];
+		if (0 == s) s = ++num_symbols;
 	}
-	for (int j = 0; j != n; ++j)
+
+	// match[(symbol - 1) * num_words + w] = the positions of the symbol in the w^th word of bits
+	ghl::vector<uint64_t> match(num_symbols * num_words);
+	for (size_t k = 0; k != num_symbols * num_words; ++k) match.push_back(0);
+	for (size_t i = 0; i != m; ++i)
 	{
-		length_matrix[0][j] = 0;
+		match[(symbol[(unsigned char)bits[i]] - 1) * num_words + i / 64] |= (uint64_t)1 << (i % 64);
 	}
 
-	// the recursive steps
-	for (int i = 1; i != m; ++i)
+	ghl::vector<uint64_t> v(num_words);
+	for (size_t w = 0; w != num_words; ++w) v.push_back(~(uint64_t)0);
+
+	for (size_t j = 0; j != steps.size(); ++j)
 	{
-		for (int j = 1; j != n; ++j)
+		const size_t s = symbol[(unsigned char)steps[j]];
+		if (0 == s) continue; // matches nothing: the column stays the same
+
+		const uint64_t* mask = match.begin() + (s - 1) * num_words;
+		uint64_t carry = 0;
+		for (size_t w = 0; w != num_words; ++w)
 		{
-			// at this time, [i-1][any], [i][j-1] are all calculated
+			const uint64_t x = v[w], u = x & mask[w];
+			const uint64_t sum = x + u + carry;
+			carry = (sum < x || (sum == x && carry)) ? 1 : 0;
+			v[w] = sum | (x - u);
+		}
+	}
+
+	// the LCS is the number of 0s among the first m bits
+	int length = 0;
+	for (size_t w = 0; w != num_words; ++w)
+	{
+		uint64_t zeros = ~v[w];
+		if (w == num_words - 1 && 0 != m % 64) zeros &= ((uint64_t)1 << (m % 64)) - 1;
+		for (; 0 != zeros; zeros &= zeros - 1) ++length;
+	}
+	return length;
+}
+
+ghl::vector<char> ghl::longest_common_subsequence(const ghl::vector<char>& first, const ghl::vector<char>& second)
+{
+	const size_t n = second.size();
+	ghl::vector<int> forward(n + 1), backward(n + 1);
+	forward.increase_size(n + 1);
+	backward.increase_size(n + 1);
+
+	ghl::vector<char> lcs(first.size() < n ? first.size() : n);
+	hirschberg(first, 0, first.size(), second, 0, n, forward.begin(), backward.begin(), lcs);
+	return lcs;
+}
+
+namespace
+{
+	/*
+	* best_alignment on a score matrix indexed by [i][j] and directions already of m+1 rows of n+1 cells
+	* (ghl::matrix, a packed matrix, or vectors of vectors)
+	*/
+	template <typename Scores, typename Directions>
+	int alignment_with_directions(int d, const Scores& matrix, const ghl::vector<int>& first, const ghl::vector<int>& second, Directions& directions)
+	{
+		const size_t m = first.size(), n = second.size();
+
+		ghl::matrix<int> scores(m + 1, n + 1);
+
+		// now we calculate the lengths and directions
 
-			if (first[i] == second[j]) // length is length_matrix[i - 1][j - 1] + 1;
+		// base case:
+		direction_rows<Directions> rows(directions, n + 1);
+		{
+			for (size_t i = 0; i != m + 1; ++i)
 			{
-				length_matrix[i][j] = length_matrix[i - 1][j - 1] + 1;
-				directions[i][j] = ghl::subsequence_direction::top_left;
+				scores[i][0] = (int)i * d;
 			}
-			else
+			ghl::subsequence_direction* row = rows.row(0);
+			for (size_t j = 0; j != n + 1; ++j)
 			{
-				// length is the max of the two
-				if (length_matrix[i - 1][j] >= length_matrix[i][j - 1])
+				scores[0][j] = (int)j * d;
+				if (0 == j)
 				{
-					length_matrix[i][j] = length_matrix[i - 1][j];
-					directions[i][j] = ghl::subsequence_direction::top;
+					row[j] = ghl::subsequence_direction::top_left;
 				}
 				else
 				{
-					length_matrix[i][j] = length_matrix[i][j - 1];
-					directions[i][j] = ghl::subsequence_direction::left;
+					row[j] = ghl::subsequence_direction::left;
 				}
 			}
+			rows.store(0);
+		}
+
+		// recursive steps:
+
+		{
+			int top_left_score, top_score, left_score;
+
+			for (size_t i = 1; i != m + 1; ++i)
+			{
+				// the base case of the column 0
+				ghl::subsequence_direction* row = rows.row(i);
+				row[0] = ghl::subsequence_direction::top;
+
+				for (size_t j = 1; j != n + 1; ++j)
+				{
+					// at this time, [i-1][any], [i][j-1] are all calculated
+
+					top_left_score = scores[i - 1][j - 1] + matrix[i - 1][j - 1];
+					top_score = scores[i][j - 1] + d;
+					left_score = scores[i - 1][j] + d;
+
+					// find the biggest one among the three
+					int biggest_index = -1, max = 0;
+					if (top_score >= left_score)
+					{
+						if (top_left_score >= top_score)
+						{
+							biggest_index = 1;
+							max = top_left_score;
+						}
+						else
+						{
+							biggest_index = 2;
+							max = top_score;
+						}
+					}
+					else
+					{
+						if (top_left_score >= left_score)
+						{
+							biggest_index = 1;
+							max = top_left_score;
+						}
+						else
+						{
+							biggest_index = 3;
+							max = left_score;
+						}
+					}
+
+					// update the matrices
+					scores[i][j] = max;
+					switch (biggest_index)
+					{
+					case 1:
+						row[j] = ghl::subsequence_direction::top_left;
+						break;
+					case 2:
+						row[j] = ghl::subsequence_direction::top;
+						break;
+					case 3:
+						row[j] = ghl::subsequence_direction::left;
+						break;
+					}
+				}
+				rows.store(i);
+			}
 		}
-	}
 
-	return length_matrix[m - 1][n - 1];
+		return scores[m][n];
+	}
 }
 
-void ghl::print_longest_common_subsequence
+int ghl::best_alignment
 (
-	const ghl::vector<char>& first,
-	const ghl::vector<ghl::vector<subsequence_direction>>& directions,
-	int i, int j
+	int d,
+	const ghl::matrix<int>& matrix,
+	const ghl::vector<int>& first, const ghl::vector<int>& second,
+	ghl::matrix<ghl::subsequence_direction>& directions
 )
 {
-	if (i <= -1 || j <= -1) return;
+	directions = ghl::matrix<ghl::subsequence_direction>(first.size() + 1, second.size() + 1);
+	return alignment_with_directions(d, matrix, first, second, directions);
+}
 
-	switch (directions[i][j])
-	{
-	case ghl::subsequence_direction::top_left:
-		print_longest_common_subsequence(first, directions, i - 1, j - 1);
-		std::cout << first[i];
-		break;
-	case ghl::subsequence_direction::top:
-		print_longest_common_subsequence(first, directions, i-1, j);
-		break;
-	case ghl::subsequence_direction::left:
-		print_longest_common_subsequence(first, directions, i, j-1);
-		break;
-	}
+int ghl::best_alignment
+(
+	int d,
+	const ghl::matrix<int>& matrix,
+	const ghl::vector<int>& first, const ghl::vector<int>& second,
+	ghl::packed_matrix<ghl::subsequence_direction>& directions
+)
+{
+	directions = ghl::packed_matrix<ghl::subsequence_direction>(first.size() + 1, second.size() + 1);
+	return alignment_with_directions(d, matrix, first, second, directions);
 }
 
 int ghl::best_alignment
@@ -257,117 +620,1061 @@ int ghl::best_alignment
 	ghl::vector<ghl::vector<ghl::subsequence_direction>>& directions
 )
 {
-	ghl::vector<ghl::vector<int>> scores;
-
-	auto m = first.size(), n = second.size();
-
-	scores.resize(m+1);
-	for (int i = 0; i != m+1; ++i)
-	{
-		// construct the columns that are of size n+1
-		scores[i].emplace_back(n + 1);
-		scores[i].increase_size(n + 1);
-	}
+	const size_t m = first.size(), n = second.size();
 
 	directions.resize(m+1);
-	for (int i = 0; i != m+1; ++i)
+	for (size_t i = 0; i != m+1; ++i)
 	{
 		// construct the columns that are of size n +1 
 		directions.emplace_back(n+1);
 		directions[i].increase_size(n+1);
 	}
 
-	// now we calculate the lengths and directions
+	return alignment_with_directions(d, matrix, first, second, directions);
+}
+
+namespace
+{
+	// the score of no alignment, low enough to lose every max and high enough not to overflow when a few scores are added to it
+	constexpr int alignment_minus_infinity = INT_MIN / 4;
+
+	/*
+	* Computes the row i >= 1 of the affine gap (Gotoh) matrices, for 1 <= j <= n, given h[0] and e[0] = minus infinity:
+	* f[j] = max(f_prev[j] + extend, h_prev[j] + open + extend), the best ending with a gap in second
+	* e[j] = max(e[j-1] + extend, h[j-1] + open + extend), the best ending with a gap in first
+	* h[j] = max(h_prev[j-1] + matrix_row[j-1], e[j], f[j], floor), the best
+	*/
+	void alignment_row_scalar
+	(
+		const int* matrix_row, const int* h_prev, const int* f_prev, int* h, int* e, int* f,
+		size_t begin, size_t n, int open, int extend, int floor
+	)
+	{
+		for (size_t j = begin; j <= n; ++j)
+		{
+			const int f_extend = f_prev[j] + extend, f_open = h_prev[j] + open + extend;
+			f[j] = f_extend >= f_open ? f_extend : f_open;
+			const int e_extend = e[j - 1] + extend, e_open = h[j - 1] + open + extend;
+			e[j] = e_extend >= e_open ? e_extend : e_open;
+
+			int best = h_prev[j - 1] + matrix_row[j - 1];
+			if (f[j] > best) best = f[j];
+			if (e[j] > best) best = e[j];
+			h[j] = best >= floor ? best : floor;
+		}
+	}
+
+	// the bits of a traceback cell: where h comes from (the first 2 bits), and whether e and f extend a gap
+	constexpr unsigned char traceback_diagonal = 0, traceback_e = 1, traceback_f = 2, traceback_start = 3;
+	constexpr unsigned char traceback_e_extends = 4, traceback_f_extends = 8;
+
+	/*
+	* Computes cells[j] = the traceback bits of the cell j of the row computed by alignment_row, for begin <= j <= n
+	* (the start of a local alignment, where h is 0, only if b_local)
+	*/
+	void traceback_row_scalar
+	(
+		const int* matrix_row, const int* h_prev, const int* h, const int* e, const int* f, unsigned char* cells,
+		size_t begin, size_t n, int open, int extend, bool b_local
+	)
+	{
+		for (size_t j = begin; j <= n; ++j)
+		{
+			unsigned char bits = (b_local && 0 == h[j]) ? traceback_start
+				: h[j] == h_prev[j - 1] + matrix_row[j - 1] ? traceback_diagonal
+				: h[j] == e[j] ? traceback_e : traceback_f;
+			if (e[j] != h[j - 1] + open + extend) bits |= traceback_e_extends;
+			if (f[j] != h_prev[j] + open + extend) bits |= traceback_f_extends;
+			cells[j] = bits;
+		}
+	}
+
+	/*
+	* alignment_row_scalar for 1 <= j <= n, a vector of cells at a time.
+	* e chains every cell to the one before it, which the vectors turn into a prefix maximum: if open <= 0,
+	* with t[j] = max(h_prev[j-1] + matrix_row[j-1], f[j], floor), and t[0] = h[0],
+	* e[j] = open + j*extend + max(t[k] - k*extend) over k < j, and h[j] = max(t[j], e[j]).
+	* A vector of cells keeps the maximum over the cells before it as a carry
+	*/
+#if defined(GHL_AVX2)
+	void alignment_row
+	(
+		const int* matrix_row, const int* h_prev, const int* f_prev, int* h, int* e, int* f,
+		size_t n, int open, int extend, int floor
+	)
+	{
+		const __m256i vextend = _mm256_set1_epi32(extend), vopen_extend = _mm256_set1_epi32(open + extend), vfloor = _mm256_set1_epi32(floor);
+		const __m256i lane_gaps = _mm256_setr_epi32(0, extend, 2 * extend, 3 * extend, 4 * extend, 5 * extend, 6 * extend, 7 * extend);
+		const __m256i open_lane_gaps = _mm256_add_epi32(lane_gaps, _mm256_set1_epi32(open)), vector_gap = _mm256_set1_epi32(8 * extend);
+		const __m256i minus_infinity = _mm256_set1_epi32(alignment_minus_infinity);
+		const __m256i shift1 = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+		const __m256i shift2 = _mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5);
+		const __m256i shift4 = _mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3);
+		const __m256i last = _mm256_set1_epi32(7);
+
+		// max(t[k] + (j-k)*extend) over k < j
+		__m256i carry = _mm256_set1_epi32(h[0] + extend);
+		size_t j = 1;
+		for (; j + 8 <= n + 1; j += 8)
+		{
+			const __m256i top = _mm256_loadu_si256((const __m256i*)(h_prev + j));
+			const __m256i vf = _mm256_max_epi32(_mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(f_prev + j)), vextend), _mm256_add_epi32(top, vopen_extend));
+			_mm256_storeu_si256((__m256i*)(f + j), vf);
+
+			const __m256i diagonal = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(h_prev + j - 1)), _mm256_loadu_si256((const __m256i*)(matrix_row + j - 1)));
+			const __m256i t = _mm256_max_epi32(_mm256_max_epi32(diagonal, vf), vfloor);
+
+			// the prefix maximum of t[k] - k*extend, and the one of the cells before
+			__m256i x = _mm256_sub_epi32(t, lane_gaps);
+			x = _mm256_max_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift1), minus_infinity, 0x01));
+			x = _mm256_max_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift2), minus_infinity, 0x03));
+			x = _mm256_max_epi32(x, _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift4), minus_infinity, 0x0F));
+			const __m256i before = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(x, shift1), minus_infinity, 0x01);
+
+			const __m256i ve = _mm256_add_epi32(_mm256_max_epi32(before, carry), open_lane_gaps);
+			_mm256_storeu_si256((__m256i*)(e + j), ve);
+			_mm256_storeu_si256((__m256i*)(h + j), _mm256_max_epi32(t, ve));
+			carry = _mm256_add_epi32(_mm256_max_epi32(carry, _mm256_permutevar8x32_epi32(x, last)), vector_gap);
+		}
+		alignment_row_scalar(matrix_row, h_prev, f_prev, h, e, f, j, n, open, extend, floor);
+	}
+
+	// traceback_row_scalar for 1 <= j <= n, 8 cells at a time
+	void traceback_row
+	(
+		const int* matrix_row, const int* h_prev, const int* h, const int* e, const int* f, unsigned char* cells,
+		size_t n, int open, int extend, bool b_local
+	)
+	{
+		const __m256i vopen_extend = _mm256_set1_epi32(open + extend), zero = _mm256_setzero_si256();
+		const __m256i from_e = _mm256_set1_epi32(traceback_e), from_f = _mm256_set1_epi32(traceback_f);
+		const __m256i start = _mm256_set1_epi32(b_local ? traceback_start : 0);
+		const __m256i e_extends = _mm256_set1_epi32(traceback_e_extends), f_extends = _mm256_set1_epi32(traceback_f_extends);
+
+		size_t j = 1;
+		for (; j + 8 <= n + 1; j += 8)
+		{
+			const __m256i vh = _mm256_loadu_si256((const __m256i*)(h + j)), ve = _mm256_loadu_si256((const __m256i*)(e + j));
+			const __m256i diagonal = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(h_prev + j - 1)), _mm256_loadu_si256((const __m256i*)(matrix_row + j - 1)));
+			const __m256i e_open = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(h + j - 1)), vopen_extend);
+			const __m256i f_open = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(h_prev + j)), vopen_extend);
+
+			__m256i bits = _mm256_andnot_si256(_mm256_cmpeq_epi32(vh, diagonal), _mm256_blendv_epi8(from_f, from_e, _mm256_cmpeq_epi32(vh, ve)));
+			bits = _mm256_or_si256(bits, _mm256_and_si256(_mm256_cmpeq_epi32(vh, zero), start));
+			bits = _mm256_or_si256(bits, _mm256_andnot_si256(_mm256_cmpeq_epi32(ve, e_open), e_extends));
+			bits = _mm256_or_si256(bits, _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(f + j)), f_open), f_extends));
+
+			// the low bytes of the lanes, 4 from each half
+			const __m256i bytes = _mm256_packus_epi16(_mm256_packus_epi32(bits, bits), zero);
+			const int low = _mm_cvtsi128_si32(_mm256_castsi256_si128(bytes)), high = _mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+			std::memcpy(cells + j, &low, 4);
+			std::memcpy(cells + j + 4, &high, 4);
+		}
+		traceback_row_scalar(matrix_row, h_prev, h, e, f, cells, j, n, open, extend, b_local);
+	}
+#elif defined(GHL_SSE41)
+	void alignment_row
+	(
+		const int* matrix_row, const int* h_prev, const int* f_prev, int* h, int* e, int* f,
+		size_t n, int open, int extend, int floor
+	)
+	{
+		const __m128i vextend = _mm_set1_epi32(extend), vopen_extend = _mm_set1_epi32(open + extend), vfloor = _mm_set1_epi32(floor);
+		const __m128i lane_gaps = _mm_setr_epi32(0, extend, 2 * extend, 3 * extend);
+		const __m128i open_lane_gaps = _mm_add_epi32(lane_gaps, _mm_set1_epi32(open)), vector_gap = _mm_set1_epi32(4 * extend);
+		const __m128i minus_infinity = _mm_set1_epi32(alignment_minus_infinity);
+
+		// max(t[k] + (j-k)*extend) over k < j
+		__m128i carry = _mm_set1_epi32(h[0] + extend);
+		size_t j = 1;
+		for (; j + 4 <= n + 1; j += 4)
+		{
+			const __m128i top = _mm_loadu_si128((const __m128i*)(h_prev + j));
+			const __m128i vf = _mm_max_epi32(_mm_add_epi32(_mm_loadu_si128((const __m128i*)(f_prev + j)), vextend), _mm_add_epi32(top, vopen_extend));
+			_mm_storeu_si128((__m128i*)(f + j), vf);
+
+			const __m128i diagonal = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(h_prev + j - 1)), _mm_loadu_si128((const __m128i*)(matrix_row + j - 1)));
+			const __m128i t = _mm_max_epi32(_mm_max_epi32(diagonal, vf), vfloor);
+
+			// the prefix maximum of t[k] - k*extend, and the one of the cells before
+			__m128i x = _mm_sub_epi32(t, lane_gaps);
+			x = _mm_max_epi32(x, _mm_alignr_epi8(x, minus_infinity, 12));
+			x = _mm_max_epi32(x, _mm_alignr_epi8(x, minus_infinity, 8));
+			const __m128i before = _mm_alignr_epi8(x, minus_infinity, 12);
+
+			const __m128i ve = _mm_add_epi32(_mm_max_epi32(before, carry), open_lane_gaps);
+			_mm_storeu_si128((__m128i*)(e + j), ve);
+			_mm_storeu_si128((__m128i*)(h + j), _mm_max_epi32(t, ve));
+			carry = _mm_add_epi32(_mm_max_epi32(carry, _mm_shuffle_epi32(x, 0xFF)), vector_gap);
+		}
+		alignment_row_scalar(matrix_row, h_prev, f_prev, h, e, f, j, n, open, extend, floor);
+	}
+
+	// traceback_row_scalar for 1 <= j <= n, 4 cells at a time
+	void traceback_row
+	(
+		const int* matrix_row, const int* h_prev, const int* h, const int* e, const int* f, unsigned char* cells,
+		size_t n, int open, int extend, bool b_local
+	)
+	{
+		const __m128i vopen_extend = _mm_set1_epi32(open + extend), zero = _mm_setzero_si128();
+		const __m128i from_e = _mm_set1_epi32(traceback_e), from_f = _mm_set1_epi32(traceback_f);
+		const __m128i start = _mm_set1_epi32(b_local ? traceback_start : 0);
+		const __m128i e_extends = _mm_set1_epi32(traceback_e_extends), f_extends = _mm_set1_epi32(traceback_f_extends);
+
+		size_t j = 1;
+		for (; j + 4 <= n + 1; j += 4)
+		{
+			const __m128i vh = _mm_loadu_si128((const __m128i*)(h + j)), ve = _mm_loadu_si128((const __m128i*)(e + j));
+			const __m128i diagonal = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(h_prev + j - 1)), _mm_loadu_si128((const __m128i*)(matrix_row + j - 1)));
+			const __m128i e_open = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(h + j - 1)), vopen_extend);
+			const __m128i f_open = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(h_prev + j)), vopen_extend);
+
+			__m128i bits = _mm_andnot_si128(_mm_cmpeq_epi32(vh, diagonal), _mm_blendv_epi8(from_f, from_e, _mm_cmpeq_epi32(vh, ve)));
+			bits = _mm_or_si128(bits, _mm_and_si128(_mm_cmpeq_epi32(vh, zero), start));
+			bits = _mm_or_si128(bits, _mm_andnot_si128(_mm_cmpeq_epi32(ve, e_open), e_extends));
+			bits = _mm_or_si128(bits, _mm_andnot_si128(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(f + j)), f_open), f_extends));
+
+			const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(bits, bits), zero));
+			std::memcpy(cells + j, &bytes, 4);
+		}
+		traceback_row_scalar(matrix_row, h_prev, h, e, f, cells, j, n, open, extend, b_local);
+	}
+#else
+	void alignment_row
+	(
+		const int* matrix_row, const int* h_prev, const int* f_prev, int* h, int* e, int* f,
+		size_t n, int open, int extend, int floor
+	)
+	{
+		alignment_row_scalar(matrix_row, h_prev, f_prev, h, e, f, 1, n, open, extend, floor);
+	}
+
+	void traceback_row
+	(
+		const int* matrix_row, const int* h_prev, const int* h, const int* e, const int* f, unsigned char* cells,
+		size_t n, int open, int extend, bool b_local
+	)
+	{
+		traceback_row_scalar(matrix_row, h_prev, h, e, f, cells, 1, n, open, extend, b_local);
+	}
+#endif
+
+	// appends count times op to the operations
+	void append_operation(ghl::vector<char>& reversed_ops, char op, size_t count)
+	{
+		for (size_t k = 0; k != count; ++k) reversed_ops.push_back(op);
+	}
+
+	// @returns the run-length encoding of the operations, which are in reverse order
+	std::string to_cigar(const ghl::vector<char>& reversed_ops)
+	{
+		std::string cigar;
+		for (size_t end = reversed_ops.size(); end != 0; )
+		{
+			const char op = reversed_ops[end - 1];
+			size_t begin = end - 1;
+			while (begin != 0 && reversed_ops[begin - 1] == op) --begin;
+			cigar += std::to_string(end - begin);
+			cigar += op;
+			end = begin;
+		}
+		return cigar;
+	}
 
-	// base case:
+	/*
+	* Follows the traceback bits, bits_of(i, j) for 1 <= i, j, back from the end of result, (result.first_end, result.second_end),
+	* in the state h, e or f, and sets the beginning and the operations of result
+	*/
+	template <typename Bits>
+	void trace_back(Bits bits_of, ghl::alignment_mode mode, ghl::alignment& result)
 	{
-		for (int i = 0; i != m + 1; ++i)
+		ghl::vector<char> reversed_ops(result.first_end + result.second_end);
+		size_t i = result.first_end, j = result.second_end;
+		unsigned char state = traceback_diagonal;
+		while (0 != i && 0 != j)
 		{
-			scores[i][0] = i * d;
-			if (0 == i)
+			const unsigned char bits = bits_of(i, j);
+			if (traceback_e == state)
 			{
-				directions[i][0] = ghl::subsequence_direction::top_left;
+				reversed_ops.push_back('D');
+				if (0 == (bits & traceback_e_extends)) state = traceback_diagonal;
+				--j;
+				continue;
+			}
+			if (traceback_f == state)
+			{
+				reversed_ops.push_back('I');
+				if (0 == (bits & traceback_f_extends)) state = traceback_diagonal;
+				--i;
+				continue;
+			}
+
+			const unsigned char from = bits & 3;
+			if (traceback_start == from) break;
+			if (traceback_diagonal == from)
+			{
+				reversed_ops.push_back('M');
+				--i;
+				--j;
 			}
 			else
 			{
-				directions[i][0] = ghl::subsequence_direction::top;
+				state = from;
 			}
 		}
-		for (int j = 0; j != n + 1; ++j)
+
+		// the rest is the gaps of the first row or column, which local alignments skip, and semi-global ones skip along second
+		if (ghl::alignment_mode::local != mode)
+		{
+			append_operation(reversed_ops, 'I', i);
+			i = 0;
+		}
+		if (ghl::alignment_mode::global == mode)
+		{
+			append_operation(reversed_ops, 'D', j);
+			j = 0;
+		}
+
+		result.first_begin = i;
+		result.second_begin = j;
+		result.cigar = to_cigar(reversed_ops);
+	}
+}
+
+ghl::alignment ghl::align
+(
+	const ghl::vector<int>& matrix,
+	const ghl::vector<int>& first, const ghl::vector<int>& second,
+	gap_penalty gap, alignment_mode mode, bool b_traceback
+)
+{
+	const size_t m = first.size(), n = second.size();
+	const int open = gap.open, extend = gap.extend;
+	const int floor = alignment_mode::local == mode ? 0 : alignment_minus_infinity;
+
+	// the rows i-1 and i of h and f, and the row i of e
+	ghl::vector<int> rows(5 * (n + 1));
+	rows.increase_size(5 * (n + 1));
+	int* h_prev = rows.begin();
+	int* h = h_prev + (n + 1);
+	int* f_prev = h + (n + 1);
+	int* f = f_prev + (n + 1);
+	int* e = f + (n + 1);
+
+	// traceback[(i-1) * n + (j-1)] = the bits of the cell (i, j)
+	ghl::vector<unsigned char> traceback(b_traceback ? m * n : 0);
+	if (b_traceback) traceback.increase_size(m * n);
+
+	// base case: a gap along first, except for the ends that local and semi-global alignments skip
+	h_prev[0] = 0;
+	f_prev[0] = f[0] = alignment_minus_infinity;
+	for (size_t j = 1; j != n + 1; ++j)
+	{
+		h_prev[j] = alignment_mode::global == mode ? open + (int)j * extend : 0;
+		f_prev[j] = alignment_minus_infinity;
+	}
+
+	// local alignments end at their best cell
+	ghl::alignment result;
+	size_t best_i = 0, best_j = 0;
+
+	for (size_t i = 1; i != m + 1; ++i)
+	{
+		h[0] = alignment_mode::local == mode ? 0 : open + (int)i * extend;
+		e[0] = alignment_minus_infinity;
+		const int* matrix_row = matrix.begin() + (i - 1) * n;
+		alignment_row(matrix_row, h_prev, f_prev, h, e, f, n, open, extend, floor);
+
+		if (b_traceback)
+		{
+			traceback_row(matrix_row, h_prev, h, e, f, traceback.begin() + (i - 1) * n - 1, n, open, extend, alignment_mode::local == mode);
+		}
+
+		if (alignment_mode::local == mode)
 		{
-			scores[0][j] = j * d;
-			if (0 == j)
+			// the row rarely holds a new best, so it is searched only if its maximum is one
+			int row_best = result.score;
+			for (size_t j = 1; j != n + 1; ++j) row_best = h[j] > row_best ? h[j] : row_best;
+			if (row_best > result.score)
 			{
-				directions[0][j] = ghl::subsequence_direction::top_left;
+				best_i = i;
+				best_j = 1;
+				while (h[best_j] != row_best) ++best_j;
+				result.score = row_best;
 			}
-			else
+		}
+
+		std::swap(h_prev, h);
+		std::swap(f_prev, f);
+	}
+
+	// global alignments end at the last cell, and semi-global ones at the best cell of the last row
+	if (alignment_mode::local != mode)
+	{
+		best_i = m;
+		best_j = n;
+		if (alignment_mode::semi_global == mode)
+		{
+			for (size_t j = 0; j != n + 1; ++j)
 			{
-				directions[0][j] = ghl::subsequence_direction::left;
+				if (h_prev[j] > h_prev[best_j]) best_j = j;
 			}
 		}
+		result.score = h_prev[best_j];
 	}
+	result.first_end = best_i;
+	result.second_end = best_j;
+	if (!b_traceback) return result;
 
-	// recursive steps:
+	trace_back([&](size_t i, size_t j) { return traceback[(i - 1) * n + (j - 1)]; }, mode, result);
+	return result;
+}
 
+namespace
+{
+	/*
+	* align over the diagonals lowest <= j - i <= highest of the band of the given width,
+	* where the cells of the previous row outside of it are kept at minus infinity.
+	* Sets b_touches_edge to whether the traceback goes through a cell on an edge of the band that is not one of the matrix
+	*/
+	ghl::alignment banded_alignment
+	(
+		const ghl::vector<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second,
+		ghl::gap_penalty gap, ghl::alignment_mode mode, size_t width, int x_drop, bool b_traceback, bool& b_touches_edge
+	)
 	{
-		int top_left_score, top_score, left_score;
+		const size_t m = first.size(), n = second.size();
+		const int open = gap.open, extend = gap.extend;
+		const bool b_local = ghl::alignment_mode::local == mode, b_x_drop = b_local && x_drop > 0;
+		const int floor = b_local ? 0 : alignment_minus_infinity;
+
+		// the band around the diagonals from (0, 0) to (m, n), clipped to the matrix
+		if (width > m + n) width = m + n;
+		const ptrdiff_t offset = (ptrdiff_t)n - (ptrdiff_t)m;
+		ptrdiff_t lowest = (offset < 0 ? offset : 0) - (ptrdiff_t)width, highest = (offset > 0 ? offset : 0) + (ptrdiff_t)width;
+		if (lowest < -(ptrdiff_t)m) lowest = -(ptrdiff_t)m;
+		if (highest > (ptrdiff_t)n) highest = (ptrdiff_t)n;
+		const size_t band_size = (size_t)(highest - lowest + 1);
+
+		// the rows i-1 and i of h and f, and the row i of e
+		ghl::vector<int> rows(5 * (n + 1));
+		rows.increase_size(5 * (n + 1));
+		int* h_prev = rows.begin();
+		int* h = h_prev + (n + 1);
+		int* f_prev = h + (n + 1);
+		int* f = f_prev + (n + 1);
+		int* e = f + (n + 1);
+
+		// traceback[(i-1) * band_size + (j - i - lowest)] = the bits of the cell (i, j)
+		ghl::vector<unsigned char> traceback(b_traceback ? m * band_size : 0);
+		if (b_traceback) traceback.increase_size(m * band_size);
+
+		// base case: the row 0 as in align, and minus infinity right of the band
+		h_prev[0] = 0;
+		f_prev[0] = f[0] = alignment_minus_infinity;
+		for (size_t j = 1; j != n + 1; ++j)
+		{
+			h_prev[j] = (ptrdiff_t)j > highest ? alignment_minus_infinity : ghl::alignment_mode::global == mode ? open + (int)j * extend : 0;
+			f_prev[j] = alignment_minus_infinity;
+		}
 
-		for (int i = 1; i != m + 1; ++i)
+		ghl::alignment result;
+		size_t best_i = 0, best_j = 0;
+		// the columns of the row computed last, and the first of the previous row that X-drop keeps
+		size_t begin = 1, end = (size_t)highest, kept = 1;
+
+		for (size_t i = 1; i != m + 1; ++i)
 		{
-			for (int j = 1; j != n + 1; ++j)
+			const ptrdiff_t row_lowest = (ptrdiff_t)i + lowest, row_highest = (ptrdiff_t)i + highest;
+			begin = row_lowest > (ptrdiff_t)kept ? (size_t)row_lowest : kept;
+			end = row_highest < (ptrdiff_t)n ? (size_t)row_highest : n;
+
+			// the cell left of the row: the first column if it is in the band (and not dropped), or minus infinity
+			const bool b_first_column = 1 == begin && row_lowest <= 0 && !(b_x_drop && 0 < result.score - x_drop);
+			h[begin - 1] = b_first_column ? (b_local ? 0 : open + (int)i * extend) : alignment_minus_infinity;
+			e[begin - 1] = alignment_minus_infinity;
+
+			const size_t shift = begin - 1, count = end + 1 - begin;
+			const int* matrix_row = matrix.begin() + (i - 1) * n + shift;
+			alignment_row(matrix_row, h_prev + shift, f_prev + shift, h + shift, e + shift, f + shift, count, open, extend, floor);
+			if (end < n) h[end + 1] = f[end + 1] = alignment_minus_infinity;
+
+			if (b_traceback)
 			{
-				// at this time, [i-1][any], [i][j-1] are all calculated
+				unsigned char* cells = traceback.begin() + ((ptrdiff_t)((i - 1) * band_size) + (ptrdiff_t)shift - (ptrdiff_t)i - lowest);
+				traceback_row(matrix_row, h_prev + shift, h + shift, e + shift, f + shift, cells, count, open, extend, b_local);
+			}
 
-				top_left_score = scores[i - 1][j - 1] + matrix[i - 1][j - 1];
-				top_score = scores[i][j - 1] + d;
-				left_score = scores[i - 1][j] + d;
+			if (b_local)
+			{
+				int row_best = result.score;
+				for (size_t j = begin; j != end + 1; ++j) row_best = h[j] > row_best ? h[j] : row_best;
+				if (row_best > result.score)
+				{
+					best_i = i;
+					best_j = begin;
+					while (h[best_j] != row_best) ++best_j;
+					result.score = row_best;
+				}
+			}
 
-				// find the biggest one among the three
-				int biggest_index = -1, max = 0;
-				if (top_score >= left_score)
+			if (b_x_drop)
+			{
+				kept = 0;
+				for (size_t j = begin; j != end + 1; ++j)
 				{
-					if (top_left_score >= top_score)
-					{
-						biggest_index = 1;
-						max = top_left_score;
-					}
-					else
-					{
-						biggest_index = 2;
-						max = top_score;
-					}
+					if (h[j] < result.score - x_drop) h[j] = f[j] = alignment_minus_infinity;
+					else if (0 == kept) kept = j;
 				}
-				else
+				if (0 == kept) break;
+			}
+
+			std::swap(h_prev, h);
+			std::swap(f_prev, f);
+		}
+
+		if (ghl::alignment_mode::local != mode)
+		{
+			best_i = m;
+			best_j = n;
+			if (ghl::alignment_mode::semi_global == mode)
+			{
+				// the last row, which always ends at n, from the cell left of it, at minus infinity if it is not in the band
+				for (size_t j = begin - 1; j != end + 1; ++j)
 				{
-					if (top_left_score >= left_score)
-					{
-						biggest_index = 1;
-						max = top_left_score;
-					}
-					else
+					if (h_prev[j] > h_prev[best_j]) best_j = j;
+				}
+			}
+			result.score = h_prev[best_j];
+		}
+		result.first_end = best_i;
+		result.second_end = best_j;
+		if (!b_traceback) return result;
+
+		trace_back([&](size_t i, size_t j)
+		{
+			const ptrdiff_t diagonal = (ptrdiff_t)j - (ptrdiff_t)i;
+			if ((diagonal == lowest && lowest > -(ptrdiff_t)m) || (diagonal == highest && highest < (ptrdiff_t)n)) b_touches_edge = true;
+			return traceback[(i - 1) * band_size + (size_t)(diagonal - lowest)];
+		}, mode, result);
+		return result;
+	}
+}
+
+ghl::alignment ghl::align_banded
+(
+	const ghl::vector<int>& matrix,
+	const ghl::vector<int>& first, const ghl::vector<int>& second,
+	gap_penalty gap, alignment_mode mode, alignment_band band, bool b_traceback
+)
+{
+	// the adaptive band needs the traceback to tell whether the alignment touches its edges
+	for (size_t width = band.width; ; width = 0 == width ? 1 : 2 * width)
+	{
+		bool b_touches_edge = false;
+		ghl::alignment result = banded_alignment(matrix, first, second, gap, mode, width, band.x_drop, b_traceback || band.b_adaptive, b_touches_edge);
+		if (!band.b_adaptive || !b_touches_edge)
+		{
+			if (!b_traceback)
+			{
+				result.first_begin = result.second_begin = 0;
+				result.cigar.clear();
+			}
+			return result;
+		}
+	}
+}
+
+int ghl::best_alignment_vectorized
+(
+	int d,
+	const ghl::vector<int>& matrix,
+	const ghl::vector<int>& first, const ghl::vector<int>& second
+)
+{
+	// a gap of k elements scores k*d whether or not it is open
+	return ghl::align(matrix, first, second, gap_penalty{ 0, d }, alignment_mode::global, false).score;
+}
+
+namespace
+{
+	/*
+	* The operations on the lanes of the batch kernels, a pair of sequences per lane of 32 bits.
+	* Masks have all the bits of a lane set where they are true
+	*/
+#if defined(GHL_AVX2)
+	struct batch_lanes
+	{
+		static constexpr size_t lanes = 8;
+		using vec = __m256i;
+
+		static vec set1(int x) { return _mm256_set1_epi32(x); }
+		static vec load(const int* p) { return _mm256_loadu_si256((const __m256i*)p); }
+		static void store(int* p, vec x) { _mm256_storeu_si256((__m256i*)p, x); }
+		static vec add(vec a, vec b) { return _mm256_add_epi32(a, b); }
+		static vec max(vec a, vec b) { return _mm256_max_epi32(a, b); }
+		static vec equal(vec a, vec b) { return _mm256_cmpeq_epi32(a, b); }
+		static vec greater(vec a, vec b) { return _mm256_cmpgt_epi32(a, b); }
+		static vec bit_and(vec a, vec b) { return _mm256_and_si256(a, b); }
+		static vec bit_or(vec a, vec b) { return _mm256_or_si256(a, b); }
+		// ~mask & x
+		static vec and_not(vec mask, vec x) { return _mm256_andnot_si256(mask, x); }
+		// mask ? a : b
+		static vec select(vec mask, vec a, vec b) { return _mm256_blendv_epi8(b, a, mask); }
+		// table[index] of every lane
+		static vec gather(const int* table, vec index) { return _mm256_i32gather_epi32(table, index, 4); }
+
+		// bytes[k] = the low byte of the lane k
+		static void store_bytes(unsigned char* bytes, vec x)
+		{
+			const __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(x, x), _mm256_setzero_si256());
+			const int low = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed)), high = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+			std::memcpy(bytes, &low, 4);
+			std::memcpy(bytes + 4, &high, 4);
+		}
+	};
+#elif defined(GHL_SSE41)
+	struct batch_lanes
+	{
+		static constexpr size_t lanes = 4;
+		using vec = __m128i;
+
+		static vec set1(int x) { return _mm_set1_epi32(x); }
+		static vec load(const int* p) { return _mm_loadu_si128((const __m128i*)p); }
+		static void store(int* p, vec x) { _mm_storeu_si128((__m128i*)p, x); }
+		static vec add(vec a, vec b) { return _mm_add_epi32(a, b); }
+		static vec max(vec a, vec b) { return _mm_max_epi32(a, b); }
+		static vec equal(vec a, vec b) { return _mm_cmpeq_epi32(a, b); }
+		static vec greater(vec a, vec b) { return _mm_cmpgt_epi32(a, b); }
+		static vec bit_and(vec a, vec b) { return _mm_and_si128(a, b); }
+		static vec bit_or(vec a, vec b) { return _mm_or_si128(a, b); }
+		static vec and_not(vec mask, vec x) { return _mm_andnot_si128(mask, x); }
+		static vec select(vec mask, vec a, vec b) { return _mm_blendv_epi8(b, a, mask); }
+
+		// SSE4.1 has no gather: the lanes are read one by one
+		static vec gather(const int* table, vec index)
+		{
+			return _mm_setr_epi32(table[_mm_cvtsi128_si32(index)], table[_mm_extract_epi32(index, 1)], table[_mm_extract_epi32(index, 2)], table[_mm_extract_epi32(index, 3)]);
+		}
+
+		static void store_bytes(unsigned char* bytes, vec x)
+		{
+			const int packed = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_packus_epi32(x, x), _mm_setzero_si128()));
+			std::memcpy(bytes, &packed, 4);
+		}
+	};
+#else
+	struct batch_lanes
+	{
+		static constexpr size_t lanes = 1;
+		using vec = int;
+
+		static vec set1(int x) { return x; }
+		static vec load(const int* p) { return *p; }
+		static void store(int* p, vec x) { *p = x; }
+		static vec add(vec a, vec b) { return a + b; }
+		static vec max(vec a, vec b) { return a >= b ? a : b; }
+		static vec equal(vec a, vec b) { return a == b ? -1 : 0; }
+		static vec greater(vec a, vec b) { return a > b ? -1 : 0; }
+		static vec bit_and(vec a, vec b) { return a & b; }
+		static vec bit_or(vec a, vec b) { return a | b; }
+		static vec and_not(vec mask, vec x) { return ~mask & x; }
+		static vec select(vec mask, vec a, vec b) { return mask ? a : b; }
+		static vec gather(const int* table, vec index) { return table[index]; }
+		static void store_bytes(unsigned char* bytes, vec x) { *bytes = (unsigned char)x; }
+	};
+#endif
+
+	// @returns the storage of buffer, of trivial elements, reallocated to size elements if it has fewer (which are not kept)
+	template <typename T>
+	T* scratch_of(ghl::vector<T>& buffer, size_t size)
+	{
+		if (buffer.capacity() < size) buffer = ghl::vector<T>(size);
+		buffer.increase_size(size);
+		return buffer.begin();
+	}
+
+	// the buffers of a block of groups of a batch, reused by its groups
+	struct batch_scratch
+	{
+		// firsts[i * lanes + k] = the symbol i of the first sequence of the lane k, and seconds the same for the second ones
+		ghl::vector<int> firsts, seconds;
+		// the lengths of the sequences of the lanes
+		int first_lengths[batch_lanes::lanes], second_lengths[batch_lanes::lanes];
+		// the DP rows of the lanes, cell by cell
+		ghl::vector<int> rows;
+		// traceback[((i-1) * n + (j-1)) * lanes + k] = the bits of the cell (i, j) of the lane k
+		ghl::vector<unsigned char> traceback;
+	};
+
+	/*
+	* Loads the pairs of a group into scratch, padded with 0 to the longest sequences of the group, m and n.
+	* The symbols are read as unsigned, and the ones of the first sequences multiplied by scale
+	*/
+	template <typename T>
+	void load_group
+	(
+		const ghl::sequence_batch<T>& firsts, const ghl::sequence_batch<T>& seconds, const size_t* pairs, size_t count,
+		int scale, batch_scratch& scratch, size_t& m, size_t& n
+	)
+	{
+		using symbol_t = typename std::make_unsigned<T>::type;
+		constexpr size_t lanes = batch_lanes::lanes;
+		m = n = 0;
+		for (size_t k = 0; k != lanes; ++k)
+		{
+			const size_t first_length = k < count ? firsts.offsets[pairs[k] + 1] - firsts.offsets[pairs[k]] : 0;
+			const size_t second_length = k < count ? seconds.offsets[pairs[k] + 1] - seconds.offsets[pairs[k]] : 0;
+			scratch.first_lengths[k] = (int)first_length;
+			scratch.second_lengths[k] = (int)second_length;
+			if (first_length > m) m = first_length;
+			if (second_length > n) n = second_length;
+		}
+
+		int* first_symbols = scratch_of(scratch.firsts, m * lanes);
+		int* second_symbols = scratch_of(scratch.seconds, n * lanes);
+		for (size_t k = 0; k != lanes; ++k)
+		{
+			const T* first = k < count ? firsts.symbols.begin() + firsts.offsets[pairs[k]] : nullptr;
+			const T* second = k < count ? seconds.symbols.begin() + seconds.offsets[pairs[k]] : nullptr;
+			for (size_t i = 0; i != m; ++i) first_symbols[i * lanes + k] = (int)i < scratch.first_lengths[k] ? scale * (int)(symbol_t)first[i] : 0;
+			for (size_t j = 0; j != n; ++j) second_symbols[j * lanes + k] = (int)j < scratch.second_lengths[k] ? (int)(symbol_t)second[j] : 0;
+		}
+	}
+
+	/*
+	* Aligns the pairs loaded in scratch, a pair per lane, the way align does: the cells (i, j) of all the lanes at a time,
+	* with the same recurrences, traceback bits and choice of the end of the alignment.
+	* Sets the scores and the ends of results[0, lanes), and the traceback if b_traceback
+	*/
+	template <typename L>
+	void align_lanes
+	(
+		batch_scratch& scratch, size_t m, size_t n, const int* substitution,
+		ghl::gap_penalty gap, ghl::alignment_mode mode, bool b_traceback, ghl::alignment* results
+	)
+	{
+		using vec = typename L::vec;
+		constexpr size_t lanes = L::lanes;
+		const int open = gap.open, extend = gap.extend;
+		const bool b_local = ghl::alignment_mode::local == mode;
+
+		const vec vextend = L::set1(extend), vopen_extend = L::set1(open + extend);
+		const vec vfloor = L::set1(b_local ? 0 : alignment_minus_infinity), zero = L::set1(0);
+		const vec from_e = L::set1(traceback_e), from_f = L::set1(traceback_f), start = L::set1(b_local ? traceback_start : 0);
+		const vec e_extends = L::set1(traceback_e_extends), f_extends = L::set1(traceback_f_extends);
+		const vec first_lengths = L::load(scratch.first_lengths), second_lengths = L::load(scratch.second_lengths);
+
+		// the rows i-1 and i of h and f
+		int* h_prev = scratch_of(scratch.rows, 4 * (n + 1) * lanes);
+		int* h = h_prev + (n + 1) * lanes;
+		int* f_prev = h + (n + 1) * lanes;
+		int* f = f_prev + (n + 1) * lanes;
+		unsigned char* traceback = b_traceback ? scratch_of(scratch.traceback, m * n * lanes) : nullptr;
+
+		for (size_t j = 0; j != n + 1; ++j)
+		{
+			L::store(h_prev + j * lanes, L::set1(0 != j && ghl::alignment_mode::global == mode ? open + (int)j * extend : 0));
+			L::store(f_prev + j * lanes, L::set1(alignment_minus_infinity));
+		}
+
+		// the ends of the global and semi-global alignments of the lanes whose first sequence ends at row i
+		auto end_in_row = [&](size_t i, const int* row)
+		{
+			if (b_local) return;
+			for (size_t k = 0; k != lanes; ++k)
+			{
+				if ((size_t)scratch.first_lengths[k] != i) continue;
+
+				size_t best_j = scratch.second_lengths[k];
+				if (ghl::alignment_mode::semi_global == mode)
+				{
+					for (size_t j = 0; j != (size_t)scratch.second_lengths[k] + 1; ++j)
 					{
-						biggest_index = 3;
-						max = left_score;
+						if (row[j * lanes + k] > row[best_j * lanes + k]) best_j = j;
 					}
 				}
+				results[k].score = row[best_j * lanes + k];
+				results[k].first_end = i;
+				results[k].second_end = best_j;
+			}
+		};
+		end_in_row(0, h_prev);
+
+		// the best cell of every lane so far, for local alignments
+		vec best = zero, best_i = zero, best_j = zero;
+
+		for (size_t i = 1; i != m + 1; ++i)
+		{
+			vec left = L::set1(b_local ? 0 : open + (int)i * extend), e = L::set1(alignment_minus_infinity);
+			L::store(h, left);
+			vec diagonal_h = L::load(h_prev);
+			const vec symbols = L::load(scratch.firsts.begin() + (i - 1) * lanes);
+			const vec vi = L::set1((int)i), in_row = L::greater(first_lengths, L::set1((int)i - 1));
+
+			for (size_t j = 1; j != n + 1; ++j)
+			{
+				const vec top = L::load(h_prev + j * lanes);
+				const vec vf = L::max(L::add(L::load(f_prev + j * lanes), vextend), L::add(top, vopen_extend));
+				const vec e_open = L::add(left, vopen_extend);
+				e = L::max(L::add(e, vextend), e_open);
+				const vec diagonal = L::add(diagonal_h, L::gather(substitution, L::add(symbols, L::load(scratch.seconds.begin() + (j - 1) * lanes))));
+				const vec vh = L::max(L::max(diagonal, e), L::max(vf, vfloor));
+				L::store(h + j * lanes, vh);
+				L::store(f + j * lanes, vf);
+
+				if (b_traceback)
+				{
+					vec bits = L::and_not(L::equal(vh, diagonal), L::select(L::equal(vh, e), from_e, from_f));
+					bits = L::bit_or(bits, L::bit_and(L::equal(vh, zero), start));
+					bits = L::bit_or(bits, L::and_not(L::equal(e, e_open), e_extends));
+					bits = L::bit_or(bits, L::and_not(L::equal(vf, L::add(top, vopen_extend)), f_extends));
+					L::store_bytes(traceback + ((i - 1) * n + (j - 1)) * lanes, bits);
+				}
+
+				if (b_local)
+				{
+					const vec vj = L::set1((int)j);
+					const vec better = L::bit_and(L::greater(vh, best), L::bit_and(in_row, L::greater(second_lengths, L::set1((int)j - 1))));
+					best = L::select(better, vh, best);
+					best_i = L::select(better, vi, best_i);
+					best_j = L::select(better, vj, best_j);
+				}
+
+				diagonal_h = top;
+				left = vh;
+			}
+
+			end_in_row(i, h);
+			std::swap(h_prev, h);
+			std::swap(f_prev, f);
+		}
+
+		if (b_local)
+		{
+			int scores[lanes], is[lanes], js[lanes];
+			L::store(scores, best);
+			L::store(is, best_i);
+			L::store(js, best_j);
+			for (size_t k = 0; k != lanes; ++k)
+			{
+				results[k].score = scores[k];
+				results[k].first_end = is[k];
+				results[k].second_end = js[k];
+			}
+		}
+	}
+
+	/*
+	* Computes the LCS lengths of the pairs loaded in scratch, a pair per lane, with the recurrence of longest_common_subsequence,
+	* and the direction of every cell (a subsequence_direction) in the traceback if b_traceback
+	*/
+	template <typename L>
+	void lcs_lanes(batch_scratch& scratch, size_t m, size_t n, bool b_traceback, int* lengths)
+	{
+		using vec = typename L::vec;
+		constexpr size_t lanes = L::lanes;
+		const vec one = L::set1(1);
+		const vec top_direction = L::set1((int)ghl::subsequence_direction::top), left_direction = L::set1((int)ghl::subsequence_direction::left);
+		const vec top_left_direction = L::set1((int)ghl::subsequence_direction::top_left);
+
+		int* h_prev = scratch_of(scratch.rows, 2 * (n + 1) * lanes);
+		int* h = h_prev + (n + 1) * lanes;
+		unsigned char* traceback = b_traceback ? scratch_of(scratch.traceback, m * n * lanes) : nullptr;
+		for (size_t j = 0; j != (n + 1) * lanes; ++j) h_prev[j] = 0;
+		for (size_t k = 0; k != lanes; ++k) lengths[k] = 0;
+
+		for (size_t i = 1; i != m + 1; ++i)
+		{
+			vec left = L::set1(0);
+			L::store(h, left);
+			vec diagonal_h = left;
+			const vec symbols = L::load(scratch.firsts.begin() + (i - 1) * lanes);
+			for (size_t j = 1; j != n + 1; ++j)
+			{
+				const vec top = L::load(h_prev + j * lanes);
+				const vec match = L::equal(symbols, L::load(scratch.seconds.begin() + (j - 1) * lanes));
+				const vec from_left = L::greater(left, top);
+				const vec vh = L::select(match, L::add(diagonal_h, one), L::max(top, left));
+				L::store(h + j * lanes, vh);
+				if (b_traceback)
+				{
+					L::store_bytes(traceback + ((i - 1) * n + (j - 1)) * lanes, L::select(match, top_left_direction, L::select(from_left, left_direction, top_direction)));
+				}
+				diagonal_h = top;
+				left = vh;
+			}
+
+			for (size_t k = 0; k != lanes; ++k)
+			{
+				if ((size_t)scratch.first_lengths[k] == i) lengths[k] = h[scratch.second_lengths[k] * lanes + k];
+			}
+			std::swap(h_prev, h);
+		}
+	}
+
+	/*
+	* Runs group(scratch, pairs, count, output, pieces) on pool for every group of the batch: count <= lanes pairs of similar lengths,
+	* pairs[0, count) their indices. The groups go by blocks, which share a batch_scratch and a string output,
+	* where group writes the output of the pair k to [pieces[2k], pieces[2k+1]).
+	* If b_output, the outputs of the pairs are then put together in order in flat, the one of the pair k at [offsets[k], offsets[k+1])
+	*/
+	template <typename T, typename Group>
+	void run_batch
+	(
+		const ghl::sequence_batch<T>& firsts, const ghl::sequence_batch<T>& seconds, ghl::thread_pool& pool,
+		Group group, bool b_output, ghl::vector<char>& flat, ghl::vector<size_t>& offsets
+	)
+	{
+		constexpr size_t lanes = batch_lanes::lanes;
+		const size_t count = firsts.offsets.size() == 0 ? 0 : firsts.offsets.size() - 1;
+
+		// the pairs in order of their lengths, so that the groups pad their sequences little
+		ghl::vector<uint64_t> keys(count);
+		for (size_t k = 0; k != count; ++k)
+		{
+			const uint64_t m = firsts.offsets[k + 1] - firsts.offsets[k], n = seconds.offsets[k + 1] - seconds.offsets[k];
+			keys.push_back(((m < UINT32_MAX ? m : UINT32_MAX) << 32) | (n < UINT32_MAX ? n : UINT32_MAX));
+		}
+		const ghl::vector<size_t> order = ghl::argsort(keys);
+
+		// a few blocks per thread, to balance the groups of different lengths
+		const size_t num_groups = (count + lanes - 1) / lanes;
+		size_t grain = num_groups / (4 * (size_t)pool.num_threads());
+		if (0 == grain) grain = 1;
+		const size_t num_blocks = (num_groups + grain - 1) / grain;
+
+		ghl::vector<std::string> outputs(num_blocks);
+		for (size_t b = 0; b != num_blocks; ++b) outputs.emplace_back();
+		ghl::vector<size_t> pieces(2 * count);
+		pieces.increase_size(2 * count);
+
+		pool.parallel_for(0, num_groups, grain, [&](size_t lo, size_t hi)
+		{
+			batch_scratch scratch;
+			std::string& output = outputs[lo / grain];
+			for (size_t g = lo; g != hi; ++g)
+			{
+				const size_t begin = g * lanes, end = begin + lanes < count ? begin + lanes : count;
+				group(scratch, order.begin() + begin, end - begin, output, pieces.begin());
+			}
+		});
+
+		if (!b_output) return;
+		offsets = ghl::vector<size_t>(count + 1);
+		offsets.push_back(0);
+		for (size_t k = 0; k != count; ++k) offsets.push_back(offsets[k] + pieces[2 * k + 1] - pieces[2 * k]);
+		flat = ghl::vector<char>(offsets[count]);
+		flat.increase_size(offsets[count]);
+		for (size_t position = 0; position != count; ++position)
+		{
+			const size_t k = order[position];
+			std::memcpy(flat.begin() + offsets[k], outputs[position / lanes / grain].data() + pieces[2 * k], pieces[2 * k + 1] - pieces[2 * k]);
+		}
+	}
+}
+
+ghl::batch_alignments ghl::align_batch
+(
+	const sequence_batch<int>& firsts, const sequence_batch<int>& seconds,
+	const ghl::vector<int>& substitution, size_t alphabet_size,
+	gap_penalty gap, alignment_mode mode, ghl::thread_pool& pool, bool b_traceback
+)
+{
+	const size_t count = firsts.offsets.size() == 0 ? 0 : firsts.offsets.size() - 1;
+	batch_alignments result;
+	result.scores = ghl::vector<int>(count);
+	result.scores.increase_size(count);
+	result.ranges = ghl::vector<size_t>(4 * count);
+	result.ranges.increase_size(4 * count);
 
-				// update the matrices
-				scores[i][j] = max;
-				switch (biggest_index)
+	auto group = [&](batch_scratch& scratch, const size_t* pairs, size_t num_pairs, std::string& output, size_t* pieces)
+	{
+		size_t m, n;
+		load_group(firsts, seconds, pairs, num_pairs, (int)alphabet_size, scratch, m, n);
+		ghl::alignment alignments[batch_lanes::lanes];
+		align_lanes<batch_lanes>(scratch, m, n, substitution.begin(), gap, mode, b_traceback, alignments);
+
+		for (size_t k = 0; k != num_pairs; ++k)
+		{
+			ghl::alignment& a = alignments[k];
+			if (b_traceback)
+			{
+				trace_back([&](size_t i, size_t j) { return scratch.traceback[((i - 1) * n + (j - 1)) * batch_lanes::lanes + k]; }, mode, a);
+				pieces[2 * pairs[k]] = output.size();
+				output += a.cigar;
+				pieces[2 * pairs[k] + 1] = output.size();
+			}
+
+			result.scores[pairs[k]] = a.score;
+			size_t* range = result.ranges.begin() + 4 * pairs[k];
+			range[0] = a.first_begin;
+			range[1] = a.first_end;
+			range[2] = a.second_begin;
+			range[3] = a.second_end;
+		}
+	};
+	run_batch(firsts, seconds, pool, group, b_traceback, result.cigars, result.cigar_offsets);
+	return result;
+}
+
+ghl::vector<int> ghl::longest_common_subsequence_batch
+(
+	const sequence_batch<char>& firsts, const sequence_batch<char>& seconds,
+	ghl::thread_pool& pool, sequence_batch<char>* lcs
+)
+{
+	const size_t count = firsts.offsets.size() == 0 ? 0 : firsts.offsets.size() - 1;
+	ghl::vector<int> lengths(count);
+	lengths.increase_size(count);
+
+	auto group = [&](batch_scratch& scratch, const size_t* pairs, size_t num_pairs, std::string& output, size_t* pieces)
+	{
+		size_t m, n;
+		load_group(firsts, seconds, pairs, num_pairs, 1, scratch, m, n);
+		int group_lengths[batch_lanes::lanes];
+		lcs_lanes<batch_lanes>(scratch, m, n, nullptr != lcs, group_lengths);
+
+		for (size_t k = 0; k != num_pairs; ++k)
+		{
+			lengths[pairs[k]] = group_lengths[k];
+			if (nullptr == lcs) continue;
+
+			// the LCS backwards, from the last cell
+			const char* first = firsts.symbols.begin() + firsts.offsets[pairs[k]];
+			const size_t begin = output.size();
+			output.resize(begin + group_lengths[k]);
+			size_t i = scratch.first_lengths[k], j = scratch.second_lengths[k], length = group_lengths[k];
+			while (0 != i && 0 != j)
+			{
+				switch ((ghl::subsequence_direction)scratch.traceback[((i - 1) * n + (j - 1)) * batch_lanes::lanes + k])
 				{
-				case 1:
-					directions[i][j] = ghl::subsequence_direction::top_left;
+				case ghl::subsequence_direction::top_left:
+					output[begin + --length] = first[--i];
+					--j;
 					break;
-				case 2:
-					directions[i][j] = ghl::subsequence_direction::top;
+				case ghl::subsequence_direction::top:
+					--i;
 					break;
-				case 3:
-					directions[i][j] = ghl::subsequence_direction::left;
+				case ghl::subsequence_direction::left:
+					--j;
 					break;
 				}
 			}
+			pieces[2 * pairs[k]] = begin;
+			pieces[2 * pairs[k] + 1] = output.size();
 		}
-	}
+	};
 
-	return 0;
-}
\ No newline at end of file
+	ghl::vector<char> symbols;
+	ghl::vector<size_t> offsets;
+	run_batch(firsts, seconds, pool, group, nullptr != lcs, symbols, offsets);
+	if (nullptr != lcs)
+	{
+		lcs->symbols = std::move(symbols);
+		lcs->offsets = std::move(offsets);
+	}
+	return lengths;
+}
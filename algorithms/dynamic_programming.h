@@ -1,5 +1,9 @@
 #pragma once
 
+#include "../data_structures/matrix.h" // the DP tables
+#include "../data_structures/vector.h" // used by the results of the batch functions
+
+#include <string>
 #include <typeinfo>
 
 /*
@@ -14,8 +18,7 @@ namespace ghl
 	uint64_t fib_dp(unsigned n);
 
 	// forward declaration
-	template <typename T>
-	class vector;
+	class thread_pool;
 
 	/*
 	* Solves the assembly line problem by using dp and stores the steps in argument steps
@@ -43,11 +46,12 @@ namespace ghl
 	};
 
 	/*
-	* Solves the longest common subsequence problem using dynamic programming
+	* Solves the longest common subsequence problem using dynamic programming.
+	* directions[i][j] is for the first i elements of first and the first j elements of second (top_left if either is empty)
 	* 
 	* @param first the first sequence
 	* @param second the second sequence
-	* @param directions the directions that one LCS goes during the construction
+	* @param directions set to the (first.size() + 1) x (second.size() + 1) directions that one LCS goes during the construction
 	* 
 	* @returns the length of LCS(first,second)
 	*/
@@ -58,20 +62,106 @@ namespace ghl
 	);
 
 	/*
-	* Prints the LCS calculated by the above function
+	* Solves the longest common subsequence problem like the above function,
+	* with the directions in a flat table (ghl::matrix) instead of a vector per row
+	*
+	* @param first the first sequence
+	* @param second the second sequence
+	* @param directions set to the (first.size() + 1) x (second.size() + 1) directions that one LCS goes during the construction
+	*
+	* @returns the length of LCS(first,second)
+	*/
+	int longest_common_subsequence
+	(
+		const ghl::vector<char>& first, const ghl::vector<char>& second,
+		ghl::matrix<subsequence_direction>& directions
+	);
+
+	/*
+	* Solves the longest common subsequence problem like the above functions,
+	* with the directions packed in 2 bits each: a quarter of the memory and bandwidth of the matrix of directions
+	*
+	* @param first the first sequence
+	* @param second the second sequence
+	* @param directions set to the (first.size() + 1) x (second.size() + 1) directions that one LCS goes during the construction
+	*
+	* @returns the length of LCS(first,second)
+	*/
+	int longest_common_subsequence
+	(
+		const ghl::vector<char>& first, const ghl::vector<char>& second,
+		ghl::packed_matrix<subsequence_direction>& directions
+	);
+
+	/*
+	* Prints the LCS calculated by the above functions
 	*
 	* @param first the first sequence
 	* @param directions the directions that the calculated LCS goes during the construction
-	* @param i the index of the current place in first
-	* @param j the index of the current place in second
+	* @param i the number of elements of first to print the LCS of (first.size() for the whole LCS)
+	* @param j the number of elements of second to print the LCS of (second.size() for the whole LCS)
 	*/
 	void print_longest_common_subsequence
 	(
 		const ghl::vector<char>& first,
 		const ghl::vector<ghl::vector<subsequence_direction>>& directions,
-		int i, int j
+		size_t i, size_t j
+	);
+
+	// print_longest_common_subsequence for the directions of the flat table
+	void print_longest_common_subsequence
+	(
+		const ghl::vector<char>& first,
+		const ghl::matrix<subsequence_direction>& directions,
+		size_t i, size_t j
+	);
+
+	// print_longest_common_subsequence for the packed directions
+	void print_longest_common_subsequence
+	(
+		const ghl::vector<char>& first,
+		const ghl::packed_matrix<subsequence_direction>& directions,
+		size_t i, size_t j
 	);
 
+	/*
+	* Computes the length of the longest common subsequence in O(m*n) time,
+	* keeping a single row of the length matrix instead of all of it: O(min(m, n)) space
+	*
+	* @param first the first sequence
+	* @param second the second sequence
+	*
+	* @returns the length of LCS(first,second)
+	*/
+	int longest_common_subsequence_length(const ghl::vector<char>& first, const ghl::vector<char>& second);
+
+	/*
+	* Computes the length of the longest common subsequence with the bit-parallel algorithm of Allison-Dix and Hyyro:
+	* a column of the length matrix along the shorter sequence is kept as a bit vector V of its differences
+	* (bit i is 0 iff the length grows at row i), and every element c of the longer sequence updates 64 cells per word with
+	* U = V & match[c], V = (V + U) | (V - U), where match[c] marks the positions of c in the shorter sequence.
+	* The additions carry from word to word. O(m*n/64) time, O(min(m, n) * distinct elements / 64) space
+	*
+	* @param first the first sequence
+	* @param second the second sequence
+	*
+	* @returns the length of LCS(first,second)
+	*/
+	int longest_common_subsequence_length_bit_parallel(const ghl::vector<char>& first, const ghl::vector<char>& second);
+
+	/*
+	* Solves the longest common subsequence problem in O(m+n) space with Hirschberg's algorithm:
+	* the last row of the lengths of the first half of first, against every prefix of second,
+	* and the one of the second half, reversed, against every suffix of second, tell where an LCS crosses the middle row,
+	* which splits the problem in two halves solved recursively. O(m*n) time (about twice that of the full matrix)
+	*
+	* @param first the first sequence
+	* @param second the second sequence
+	*
+	* @returns one LCS of first and second
+	*/
+	ghl::vector<char> longest_common_subsequence(const ghl::vector<char>& first, const ghl::vector<char>& second);
+
 	/*
 	* Solves the best alignment problem using dp
 	* 
@@ -90,4 +180,230 @@ namespace ghl
 		const ghl::vector<int>& first, const ghl::vector<int>& second,
 		ghl::vector<ghl::vector<ghl::subsequence_direction>>& directions
 	);
-}
\ No newline at end of file
+
+	/*
+	* Solves the best alignment problem like the above function,
+	* with the score matrix, the scores and the directions in flat tables (ghl::matrix) instead of a vector per row
+	*
+	* @param d gap_penalty
+	* @param matrix score matrix, first.size() x second.size()
+	* @param first the sequence that is to be matched against
+	* @param second the sequence to match against first
+	* @param directions set to the (first.size() + 1) x (second.size() + 1) directions that the calculated alignment goes during the construction
+	*
+	* @returns the score of the optimal match
+	*/
+	int best_alignment
+	(
+		int d,
+		const ghl::matrix<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second,
+		ghl::matrix<ghl::subsequence_direction>& directions
+	);
+
+	/*
+	* Solves the best alignment problem like the above functions, with the directions packed in 2 bits each
+	*
+	* @param d gap_penalty
+	* @param matrix score matrix, first.size() x second.size()
+	* @param first the sequence that is to be matched against
+	* @param second the sequence to match against first
+	* @param directions set to the (first.size() + 1) x (second.size() + 1) directions that the calculated alignment goes during the construction
+	*
+	* @returns the score of the optimal match
+	*/
+	int best_alignment
+	(
+		int d,
+		const ghl::matrix<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second,
+		ghl::packed_matrix<ghl::subsequence_direction>& directions
+	);
+
+	/*
+	* The alignments of align:
+	* global aligns the whole of both sequences (Needleman-Wunsch),
+	* local the pair of subsequences that score the best (Smith-Waterman), or nothing if every pair scores below 0,
+	* semi_global the whole of first with a subsequence of second: the gaps before and after it in second are free
+	*/
+	enum class alignment_mode : char
+	{
+		global,
+		local,
+		semi_global
+	};
+
+	/*
+	* Affine gap penalties (Gotoh): a gap of k elements scores open + k * extend.
+	* open = 0 gives the linear penalty d = extend of best_alignment. Both are expected to be <= 0
+	*/
+	struct gap_penalty
+	{
+		int open;
+		int extend;
+	};
+
+	/*
+	* An alignment computed by align
+	*/
+	struct alignment
+	{
+		int score = 0;
+		// the aligned ranges of the sequences, [first_begin, first_end) and [second_begin, second_end)
+		size_t first_begin = 0, first_end = 0, second_begin = 0, second_end = 0;
+		/*
+		* The operations from the beginning of the ranges, as runs of a count and an operation: M matches first[i] with second[j],
+		* I skips an element of first (a gap in second), and D one of second (a gap in first), e.g. "3M2I1M"
+		* Empty if align was asked for the score only
+		*/
+		std::string cigar;
+	};
+
+	/*
+	* Computes the best alignment of first and second with affine gaps, in the given mode, in O(m*n) time.
+	* The rows of the Gotoh matrices are computed by a kernel shared by the modes, 8 (AVX2) or 4 (SSE4.1) cells per vector.
+	* The traceback keeps 1 byte per cell, where the best of every cell came from, and is returned as a CIGAR string,
+	* instead of a matrix of directions; without it, align takes O(n) space
+	*
+	* @param matrix score matrix, flat: matrix[i * second.size() + j] = the score of matching first[i] with second[j]
+	* @param first the sequence that is to be matched against
+	* @param second the sequence to match against first
+	* @param gap the penalties of a gap
+	* @param mode global, local or semi-global
+	* @param b_traceback whether to compute the ranges and the operations of the alignment, or only its score (and end)
+	*
+	* @returns the best alignment; the first of the best in row-major order of their ends if there are several
+	*/
+	alignment align
+	(
+		const ghl::vector<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second,
+		gap_penalty gap, alignment_mode mode, bool b_traceback = true
+	);
+
+	/*
+	* The band of align_banded: the diagonals j - i of the cells (i, j) it computes
+	*/
+	struct alignment_band
+	{
+		// the number of diagonals on each side of the ones between (0, 0) and (m, n), min(0, n - m) <= j - i <= max(0, n - m)
+		size_t width;
+		// whether to double width and align again while the alignment touches an edge of the band, until it does not or the band covers the matrix
+		bool b_adaptive = false;
+		/*
+		* X-drop, for local alignments only: if > 0, drops the cells that score more than x_drop below the best so far,
+		* skips the cells left of the first that is kept in every row, and stops at the first row where none is kept
+		*/
+		int x_drop = 0;
+	};
+
+	/*
+	* Computes the best alignment of first and second like align, but only over the cells of the band,
+	* with the same kernels: O(m * band) time, the traceback in O(m * band) space, and O(n) space without it.
+	* The score is the one of align whenever its alignment stays inside the band (always if the band covers the matrix)
+	*
+	* @param matrix score matrix, flat: matrix[i * second.size() + j] = the score of matching first[i] with second[j]
+	* @param first the sequence that is to be matched against
+	* @param second the sequence to match against first
+	* @param gap the penalties of a gap
+	* @param mode global, local or semi-global
+	* @param band the width of the band, whether it grows, and the X-drop
+	* @param b_traceback whether to compute the ranges and the operations of the alignment, or only its score (and end)
+	*
+	* @returns the best alignment inside the band; the first of the best in row-major order of their ends if there are several
+	*/
+	alignment align_banded
+	(
+		const ghl::vector<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second,
+		gap_penalty gap, alignment_mode mode, alignment_band band, bool b_traceback = true
+	);
+
+	/*
+	* Computes the score of the best alignment like best_alignment, without the directions, with SIMD:
+	* the score matrix is filled row by row, 8 (AVX2) or 4 (SSE4.1) cells per vector of 32-bit lanes.
+	* The gap along the row chains every cell to the one before it, which the kernel turns into a prefix maximum:
+	* with t[j] = max(scores[i-1][j-1] + matrix[i-1][j-1], scores[i-1][j] + d),
+	* scores[i][j] - j*d = max(t[k] - k*d) over k <= j, taking log2(lanes) shifts per vector and one carry between vectors.
+	* Equivalent to align(matrix, first, second, { 0, d }, alignment_mode::global, false).score. O(m*n) time, O(n) space
+	*
+	* @param d gap_penalty
+	* @param matrix score matrix, flat: matrix[i * second.size() + j] = the score of matching first[i] with second[j]
+	* @param first the sequence that is to be matched against
+	* @param second the sequence to match against first
+	*
+	* @returns the score of the optimal match
+	*/
+	int best_alignment_vectorized
+	(
+		int d,
+		const ghl::vector<int>& matrix,
+		const ghl::vector<int>& first, const ghl::vector<int>& second
+	);
+
+	/*
+	* Sequences stored back to back, for the batch functions: the k^th is symbols[offsets[k], offsets[k+1]),
+	* where offsets[0] = 0, so offsets has one more element than there are sequences
+	*/
+	template <typename T>
+	struct sequence_batch
+	{
+		ghl::vector<T> symbols;
+		ghl::vector<size_t> offsets;
+	};
+
+	/*
+	* The alignments of the pairs of a batch, computed by align_batch, in flat arrays
+	*/
+	struct batch_alignments
+	{
+		// scores[k] = the score of the pair k
+		ghl::vector<int> scores;
+		// ranges[4k], ..., ranges[4k+3] = first_begin, first_end, second_begin and second_end of the pair k, as in alignment
+		ghl::vector<size_t> ranges;
+		// with the traceback, the CIGAR of the pair k is cigars[cigar_offsets[k], cigar_offsets[k+1]); empty without it
+		ghl::vector<char> cigars;
+		ghl::vector<size_t> cigar_offsets;
+	};
+
+	/*
+	* Computes the alignments of align for the pairs (firsts[k], seconds[k]), scored by a substitution matrix over an alphabet
+	* instead of a matrix per pair (best_alignment is the global mode with gap_penalty{ 0, d }).
+	* The pairs are sorted by length and packed in groups, a pair per lane of a vector (8 with AVX2, 4 with SSE4.1),
+	* which computes the cell (i, j) of all the pairs of the group at once. The groups are shared by the threads of pool,
+	* in blocks whose DP rows and traceback are reused from group to group
+	*
+	* @param firsts the sequences that are to be matched against, of symbols in [0, alphabet_size)
+	* @param seconds the sequences to match against them, as many as firsts
+	* @param substitution flat: substitution[a * alphabet_size + b] = the score of matching the symbol a of a first sequence with the symbol b of a second one
+	* @param alphabet_size the number of symbols
+	* @param gap the penalties of a gap
+	* @param mode global, local or semi-global
+	* @param pool the threads that align the groups
+	* @param b_traceback whether to compute the ranges and the operations of the alignments, or only their scores (and ends)
+	*
+	* @returns the alignments of the pairs, which are the ones of align
+	*/
+	batch_alignments align_batch
+	(
+		const sequence_batch<int>& firsts, const sequence_batch<int>& seconds,
+		const ghl::vector<int>& substitution, size_t alphabet_size,
+		gap_penalty gap, alignment_mode mode, ghl::thread_pool& pool, bool b_traceback = false
+	);
+
+	/*
+	* Computes the lengths of the LCS of the pairs (firsts[k], seconds[k]), packed in groups a pair per lane as in align_batch
+	*
+	* @param firsts the first sequences
+	* @param seconds the second sequences, as many as firsts
+	* @param pool the threads that compute the groups
+	* @param lcs if not null, set to one LCS of every pair
+	*
+	* @returns the lengths of the LCS of the pairs
+	*/
+	ghl::vector<int> longest_common_subsequence_batch
+	(
+		const sequence_batch<char>& firsts, const sequence_batch<char>& seconds,
+		ghl::thread_pool& pool, sequence_batch<char>* lcs = nullptr
+	);
+}
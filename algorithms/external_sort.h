@@ -0,0 +1,459 @@
+/*
+* This file contains the definition of an external merge sort, for files of records that do not fit in memory
+*/
+
+#pragma once
+
+#include "sorting.h"
+#include "../data_structures/vector.h"
+
+#include <cstddef>
+#include <cstdio> // std::remove
+#include <fstream>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace ghl
+{
+	// what external_sort did
+	struct external_sort_stats
+	{
+		size_t num_records = 0;
+		// the number of sorted runs written by the first pass
+		size_t num_runs = 0;
+		// the number of passes over the data, including the one that forms the runs
+		size_t num_passes = 0;
+		// the number of ways of the merges
+		size_t fan_in = 0;
+		size_t bytes_read = 0;
+		size_t bytes_written = 0;
+	};
+
+	namespace detail
+	{
+		/*
+		* A tournament tree over k sources, whose leaves are the sources and whose inner nodes keep the loser of their match,
+		* so that after the winner's source advances, the new winner is found by replaying only the log2(k) matches on its path.
+		*
+		* before(i, j) tells whether the current element of source i goes before that of source j (exhausted sources go last).
+		*/
+		template <typename Before>
+		class loser_tree final
+		{
+		public:
+			loser_tree(size_t k, Before before) : k(k), losers(k + 1), before(before)
+			{
+				losers.increase_size(k + 1);
+
+				// play all matches bottom up, where node n has children 2n and 2n + 1, and the leaf of source i is node k + i
+				ghl::vector<size_t> winners(2 * k);
+				winners.increase_size(2 * k);
+				for (size_t i = 0; i != k; ++i) winners[k + i] = i;
+				for (size_t n = k; n-- > 1; )
+				{
+					const size_t a = winners[2 * n], b = winners[2 * n + 1];
+					const bool b_wins = this->before(b, a);
+					winners[n] = b_wins ? b : a;
+					losers[n] = b_wins ? a : b;
+				}
+				losers[0] = k > 1 ? winners[1] : 0;
+			}
+
+			// the source whose element goes first
+			size_t winner() const { return losers[0]; }
+
+			// finds the new winner after the current element of winner() has changed
+			void replay()
+			{
+				size_t s = losers[0];
+				for (size_t n = (s + k) / 2; n >= 1; n /= 2)
+				{
+					if (before(losers[n], s)) std::swap(losers[n], s);
+				}
+				losers[0] = s;
+			}
+
+		private:
+			size_t k;
+			// losers[0] is the winner of the whole tree
+			ghl::vector<size_t> losers;
+			Before before;
+		};
+
+		/*
+		* Reads num_records records of a file from an offset, a block at a time,
+		* reading the next block in the background while the current one is consumed (double buffering)
+		*/
+		template <typename R>
+		class run_reader final
+		{
+		public:
+			run_reader(const std::string& path, size_t offset, size_t num_records, size_t block_records) :
+				in(path, std::ios::binary), remaining(num_records), buffers(2 * block_records), block_records(block_records)
+			{
+				buffers.increase_size(2 * block_records);
+				in.seekg((std::streamoff)(offset * sizeof(R)));
+				start_read();
+				next_block();
+			}
+
+			run_reader(const run_reader&) = delete;
+			run_reader& operator=(const run_reader&) = delete;
+
+			~run_reader() { if (pending.valid()) pending.wait(); }
+
+		public:
+			bool empty() const { return pos == size; }
+			const R& head() const { return current[pos]; }
+
+			void pop()
+			{
+				if (++pos == size) next_block();
+			}
+
+			bool failed() const { return b_failed; }
+			size_t bytes_read() const { return m_bytes_read; }
+
+		private:
+			// starts reading the next block into the buffer that is not current
+			void start_read()
+			{
+				if (0 == remaining) return;
+
+				const size_t count = remaining < block_records ? remaining : block_records;
+				remaining -= count;
+				R* target = (current == buffers.begin()) ? buffers.begin() + block_records : buffers.begin();
+				pending = std::async(std::launch::async, [this, target, count]()
+				{
+					in.read((char*)target, (std::streamsize)(count * sizeof(R)));
+					return in ? count : 0;
+				});
+				next = target;
+			}
+
+			// waits for the block being read, makes it current, and starts reading the one after it
+			void next_block()
+			{
+				pos = size = 0;
+				if (!pending.valid()) return;
+
+				size = pending.get();
+				if (0 == size) { b_failed = true; return; }
+				m_bytes_read += size * sizeof(R);
+				current = next;
+				start_read();
+			}
+
+		private:
+			std::ifstream in;
+			size_t remaining;
+			ghl::vector<R> buffers;
+			size_t block_records;
+
+			R* current = nullptr;
+			R* next = nullptr;
+			size_t pos = 0, size = 0;
+			std::future<size_t> pending;
+
+			bool b_failed = false;
+			size_t m_bytes_read = 0;
+		};
+
+		/*
+		* Appends records to a file a block at a time,
+		* writing the full block in the background while the next one is filled (double buffering)
+		*/
+		template <typename R>
+		class run_writer final
+		{
+		public:
+			run_writer(const std::string& path, size_t block_records) :
+				out(path, std::ios::binary | std::ios::trunc), buffers(2 * block_records), block_records(block_records)
+			{
+				buffers.increase_size(2 * block_records);
+				current = buffers.begin();
+			}
+
+			run_writer(const run_writer&) = delete;
+			run_writer& operator=(const run_writer&) = delete;
+
+			~run_writer() { finish(); }
+
+		public:
+			void push(const R& r)
+			{
+				current[size++] = r;
+				if (block_records == size) flush();
+			}
+
+			/*
+			* Writes the records of [begin, end) in the background, without copying them into the blocks,
+			* after the previous writes are done. They must stay unchanged until the next call.
+			*/
+			void write(const R* begin, const R* end)
+			{
+				flush();
+				wait();
+				const size_t count = end - begin;
+				pending = std::async(std::launch::async, [this, begin, count]() { write_block(begin, count); });
+			}
+
+			// writes what is left, and @returns false iff any write failed
+			bool finish()
+			{
+				flush();
+				wait();
+				if (out.is_open()) out.close();
+				return !b_failed;
+			}
+
+			size_t bytes_written() const { return m_bytes_written; }
+
+		private:
+			void flush()
+			{
+				if (0 == size) return;
+
+				wait();
+				const R* block = current;
+				const size_t count = size;
+				pending = std::async(std::launch::async, [this, block, count]() { write_block(block, count); });
+				current = (current == buffers.begin()) ? buffers.begin() + block_records : buffers.begin();
+				size = 0;
+			}
+
+			void wait()
+			{
+				if (pending.valid()) pending.get();
+			}
+
+			void write_block(const R* block, size_t count)
+			{
+				out.write((const char*)block, (std::streamsize)(count * sizeof(R)));
+				if (!out) b_failed = true;
+				m_bytes_written += count * sizeof(R);
+			}
+
+		private:
+			std::ofstream out;
+			ghl::vector<R> buffers;
+			size_t block_records;
+
+			R* current = nullptr;
+			size_t size = 0;
+			std::future<void> pending;
+
+			bool b_failed = false;
+			size_t m_bytes_written = 0;
+		};
+
+		// a run of a file: num_records sorted records from offset
+		struct file_run
+		{
+			std::string path;
+			size_t offset = 0;
+			size_t num_records = 0;
+		};
+
+		/*
+		* Merges the runs [first, last) of runs into the file path with a loser tree
+		*
+		* @returns false iff any read or write failed
+		*/
+		template <typename R>
+		bool merge_file_runs(const file_run* first, const file_run* last, const std::string& path, size_t block_records, external_sort_stats& stats)
+		{
+			const size_t k = last - first;
+
+			// the readers are allocated one by one, as they are neither copyable nor movable
+			ghl::vector<run_reader<R>*> readers(k);
+			for (const file_run* run = first; run != last; ++run)
+			{
+				readers.push_back(new run_reader<R>(run->path, run->offset, run->num_records, block_records));
+			}
+
+			// ties go to the earlier run
+			auto before = [&readers](size_t i, size_t j)
+			{
+				if (readers[j]->empty()) return !readers[i]->empty() || i < j;
+				if (readers[i]->empty()) return false;
+				if (readers[i]->head() < readers[j]->head()) return true;
+				return !(readers[j]->head() < readers[i]->head()) && i < j;
+			};
+			loser_tree<decltype(before)> tree(k, before);
+
+			bool b_ok = true;
+			{
+				run_writer<R> writer(path, block_records);
+				while (0 != k && !readers[tree.winner()]->empty())
+				{
+					run_reader<R>& reader = *readers[tree.winner()];
+					writer.push(reader.head());
+					reader.pop();
+					tree.replay();
+				}
+				b_ok = writer.finish();
+				stats.bytes_written += writer.bytes_written();
+			}
+
+			for (size_t i = 0; i != k; ++i)
+			{
+				b_ok = b_ok && !readers[i]->failed();
+				stats.bytes_read += readers[i]->bytes_read();
+				delete readers[i];
+			}
+			return b_ok;
+		}
+
+		/*
+		* Removes the temporary files of external_sort when it returns, whether it succeeds or fails:
+		* the file the runs are formed in, which exists even if no run was written, and the files of the runs left
+		*/
+		class run_files_remover final
+		{
+		public:
+			run_files_remover(const std::string& first_path, const ghl::vector<file_run>& runs) : first_path(first_path), runs(runs) {}
+
+			run_files_remover(const run_files_remover&) = delete;
+			run_files_remover& operator=(const run_files_remover&) = delete;
+
+			~run_files_remover()
+			{
+				std::remove(first_path.c_str());
+				for (size_t i = 0; i != runs.size(); ++i)
+				{
+					if (runs[i].path != first_path && (0 == i || runs[i].path != runs[i - 1].path)) std::remove(runs[i].path.c_str());
+				}
+			}
+
+		private:
+			const std::string& first_path;
+			const ghl::vector<file_run>& runs;
+		};
+	}
+
+	/*
+	* Sorts the binary file input_path of records of type R into output_path, using about memory_bytes of memory:
+	* 1. runs of memory_bytes / 2 records are read, sorted by introsort, and written into one temporary file,
+	*    the next run being read while the previous one is written
+	* 2. groups of up to fan_in runs are merged by a loser tree into a new temporary file, until at most fan_in runs are left,
+	*    which are merged into output_path.
+	*    Every run is read, and the output written, a block at a time with double buffering,
+	*    and fan_in is as large as the memory allows for that (up to 1024 runs with blocks of 1 MB)
+	*
+	* Temporary files are named after output_path, and are removed when done. Bytes past the last whole record of the input are ignored.
+	* Not stable. O(n log n) comparisons, and 1 + ceil(log_fan_in(runs)) passes over the data.
+	*
+	* Requirements:
+	* 1. R is trivially copyable (records are read and written as they are in memory), and has an operator<
+	*
+	* @param stats if not null, receives the numbers of records, runs, passes and bytes read and written
+	* @returns false iff a file could not be read or written
+	*/
+	template <typename R>
+	bool external_sort(const std::string& input_path, const std::string& output_path, size_t memory_bytes, external_sort_stats* stats = nullptr)
+	{
+		static_assert(std::is_trivially_copyable<R>::value, "records are read and written as raw bytes");
+
+		external_sort_stats s;
+
+		size_t num_records = 0;
+		{
+			std::ifstream in(input_path, std::ios::binary | std::ios::ate);
+			if (!in) return false;
+			num_records = (size_t)in.tellg() / sizeof(R);
+		}
+		s.num_records = num_records;
+
+		// two runs are in memory while forming runs: one being sorted and one being written
+		size_t run_records = memory_bytes / 2 / sizeof(R);
+		if (run_records < 1) run_records = 1;
+
+		// every run being merged takes two blocks, as does the output
+		size_t block_records = ((size_t)1 << 20) / sizeof(R);
+		if (block_records < 1) block_records = 1;
+		size_t fan_in = memory_bytes / (2 * block_records * sizeof(R));
+		if (fan_in > 1025) fan_in = 1025;
+		if (fan_in < 3)
+		{
+			fan_in = 3;
+			block_records = memory_bytes / (2 * fan_in * sizeof(R));
+			if (block_records < 1) block_records = 1;
+		}
+		--fan_in; // the output
+		s.fan_in = fan_in;
+
+		// 1. form the runs
+		const std::string runs_path = output_path + ".runs0";
+		ghl::vector<detail::file_run> runs(num_records / run_records + 1);
+		detail::run_files_remover remover(runs_path, runs);
+		{
+			std::ifstream in(input_path, std::ios::binary);
+			ghl::vector<R> buffers(2 * run_records);
+			buffers.increase_size(2 * run_records);
+			R* current = buffers.begin();
+
+			detail::run_writer<R> writer(runs_path, 1); // which writes whole runs, and needs no blocks
+			for (size_t offset = 0; offset < num_records; offset += run_records)
+			{
+				const size_t count = (num_records - offset < run_records) ? num_records - offset : run_records;
+				in.read((char*)current, (std::streamsize)(count * sizeof(R)));
+				if (!in) return false;
+				s.bytes_read += count * sizeof(R);
+
+				introsort(current, current + count);
+				// waits for the previous run to be written, whose buffer is then free for the next one
+				writer.write(current, current + count);
+
+				detail::file_run run;
+				run.path = runs_path;
+				run.offset = offset;
+				run.num_records = count;
+				runs.push_back(run);
+				current = (current == buffers.begin()) ? buffers.begin() + run_records : buffers.begin();
+			}
+			if (!writer.finish()) return false;
+			s.bytes_written += writer.bytes_written();
+		}
+		s.num_runs = runs.size();
+		s.num_passes = 1;
+
+		// 2. merge groups of fan_in runs until they can be merged into the output at once
+		bool b_ok = true;
+		size_t pass = 0;
+		while (b_ok && runs.size() > fan_in)
+		{
+			const std::string merged_path = output_path + ".runs" + std::to_string(++pass);
+			ghl::vector<detail::file_run> merged(runs.size() / fan_in + 1);
+			for (size_t i = 0; b_ok && i < runs.size(); i += fan_in)
+			{
+				const size_t last = (i + fan_in < runs.size()) ? i + fan_in : runs.size();
+				const std::string group_path = merged_path + "." + std::to_string(merged.size());
+				b_ok = detail::merge_file_runs<R>(runs.begin() + i, runs.begin() + last, group_path, block_records, s);
+
+				detail::file_run run;
+				run.path = group_path;
+				for (size_t j = i; j != last; ++j) run.num_records += runs[j].num_records;
+				merged.push_back(run);
+			}
+
+			for (size_t i = 0; i != runs.size(); ++i)
+			{
+				if (0 == i || runs[i].path != runs[i - 1].path) std::remove(runs[i].path.c_str());
+			}
+			runs = std::move(merged);
+			++s.num_passes;
+		}
+
+		if (b_ok)
+		{
+			b_ok = detail::merge_file_runs<R>(runs.begin(), runs.end(), output_path, block_records, s);
+			++s.num_passes;
+		}
+
+		if (stats) *stats = s;
+		return b_ok;
+	}
+}
@@ -5,10 +5,22 @@
 #pragma once
 
 #include "../data_structures/graph.h"
+#include "../data_structures/csr_graph.h"
 #include "../data_structures/queue.h"
+#include "../data_structures/vector.h"
+#include "../data_structures/simd.h"
+#include "sorting.h"
 
 // for inf
 #include <limits>
+// used by gorder_order
+#include <queue>
+// used by multilevel_partition
+#include <list>
+// used by count_triangles
+#include <thread>
+#include <atomic>
+#include <memory>
 
 namespace ghl
 {
@@ -44,6 +56,939 @@ namespace ghl
 		
 	}
 
+	/*
+	* Performs breadth first search on an indexed graph (see ghl::indexed_vertex_ref) from source
+	* 
+	* G: a graph whose vertices are indices, which provides num_vertices() and for_each_neighbor(), e.g. ghl::dynamic_graph_snapshot
+	* @param d where d[v] = the number of edges on a shortest path from source to v, or bfs_attr::inf if v is unreachable (assumed to be empty when passed in)
+	*/
+	template <typename G>
+	void indexed_breadth_first_search(const G& graph, size_t source, ghl::vector<unsigned>& d)
+	{
+		const size_t n = graph.num_vertices();
+
+		d.resize(n);
+		for (size_t i = 0; i != n; ++i) d.push_back(bfs_attr::inf);
+
+		if (source >= n) return;
+
+		// every vertex is enqueued at most once, so an array of n works as the queue
+		ghl::vector<size_t> q(n);
+		size_t head = 0;
+
+		d[source] = 0;
+		q.push_back(source);
+
+		while (head != q.size())
+		{
+			const size_t v = q[head++];
+			const unsigned next_d = d[v] + 1;
+
+			graph.for_each_neighbor(v, [&](size_t u, float)
+			{
+				if (bfs_attr::inf == d[u]) // white
+				{
+					d[u] = next_d;
+					q.push_back(u);
+				}
+			});
+		}
+	}
+
+	/*
+	* Calculates the PageRank of every vertex of an indexed graph (see ghl::indexed_vertex_ref) by power iteration
+	* 
+	* The rank of a vertex without out edges is distributed evenly to all vertices.
+	* 
+	* G: a graph whose vertices are indices, which provides num_vertices() and for_each_neighbor(), e.g. ghl::dynamic_graph_snapshot
+	* @param ranks where ranks[v] = the rank of v, which sum up to 1 (assumed to be empty when passed in)
+	* @param damping the probability of following an edge instead of jumping to a random vertex
+	* @param iterations the number of iterations to do
+	*/
+	template <typename G>
+	void indexed_page_rank(const G& graph, ghl::vector<double>& ranks, double damping = 0.85, unsigned iterations = 20)
+	{
+		const size_t n = graph.num_vertices();
+		if (0 == n) return;
+
+		ghl::vector<size_t> outdeg(n);
+		ghl::vector<double> next(n);
+		ranks.resize(n);
+		for (size_t v = 0; v != n; ++v)
+		{
+			size_t deg = 0;
+			graph.for_each_neighbor(v, [&deg](size_t, float) { ++deg; });
+			outdeg.push_back(deg);
+
+			ranks.push_back(1.0 / n);
+			next.push_back(0.0);
+		}
+
+		for (unsigned it = 0; it != iterations; ++it)
+		{
+			double dangling = 0.0;
+			for (size_t v = 0; v != n; ++v)
+			{
+				next[v] = 0.0;
+				if (0 == outdeg[v]) dangling += ranks[v];
+			}
+
+			// push the rank of every vertex along its out edges
+			for (size_t v = 0; v != n; ++v)
+			{
+				if (0 != outdeg[v])
+				{
+					const double share = ranks[v] / outdeg[v];
+					graph.for_each_neighbor(v, [&](size_t u, float) { next[u] += share; });
+				}
+			}
+
+			const double base = (1.0 - damping) / n + damping * dangling / n;
+			for (size_t v = 0; v != n; ++v)
+			{
+				ranks[v] = base + damping * next[v];
+			}
+		}
+	}
+
+	/*
+	* The following are vertex reordering passes for indexed graphs (see ghl::indexed_vertex_ref).
+	* Each of them produces new_index, where new_index[v] = the new index of v, which is a permutation of [0, num_vertices()).
+	* Pass it to csr_graph::relabeled() to get a graph whose adj lists are placed (and refer to vertices) in a more cache-friendly order.
+	*/
+
+	/*
+	* Orders the vertices by degree in descending order (ties are kept in their original order),
+	* so that the hubs, which are visited the most, are packed together.
+	* 
+	* O(V + max degree)
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor()
+	* @param new_index assumed to be empty when passed in
+	*/
+	template <typename G>
+	void degree_sort_order(const G& graph, ghl::vector<size_t>& new_index)
+	{
+		const size_t n = graph.num_vertices();
+
+		ghl::vector<size_t> deg(n);
+		size_t max_deg = 0;
+		for (size_t v = 0; v != n; ++v)
+		{
+			size_t d = 0;
+			graph.for_each_neighbor(v, [&d](size_t, float) { ++d; });
+			deg.push_back(d);
+			if (d > max_deg) max_deg = d;
+		}
+
+		// counting sort, where the bucket of degree d is at max_deg - d
+		ghl::vector<size_t> starts(max_deg + 2);
+		for (size_t d = 0; d != max_deg + 2; ++d) starts.push_back(0);
+		for (size_t v = 0; v != n; ++v) ++starts[max_deg - deg[v] + 1];
+		for (size_t d = 0; d != max_deg + 1; ++d) starts[d + 1] += starts[d];
+
+		new_index.resize(n);
+		new_index.increase_size(n);
+		for (size_t v = 0; v != n; ++v) new_index[v] = starts[max_deg - deg[v]]++;
+	}
+
+	/*
+	* Orders the vertices by the (reverse) Cuthill-McKee algorithm:
+	* vertices are numbered in breadth first order starting from a vertex of the minimal degree in each component,
+	* and the unvisited neighbors of a vertex are numbered in ascending order of their degrees.
+	* This keeps the indices of adj vertices close to each other (i.e. reduces the bandwidth of the adjacency matrix).
+	* 
+	* O(V + E log(max degree))
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor()
+	* @param new_index assumed to be empty when passed in
+	* @param b_reverse reverses the numbering (RCM), which usually gives a lower profile
+	*/
+	template <typename G>
+	void cuthill_mckee_order(const G& graph, ghl::vector<size_t>& new_index, bool b_reverse = true)
+	{
+		const size_t n = graph.num_vertices();
+
+		// ordered by degree then by index, which is used to sort the neighbors
+		struct deg_and_index
+		{
+			deg_and_index() {}
+			deg_and_index(size_t d, size_t i) : deg(d), v(i) {}
+
+			bool operator<(const deg_and_index& r) const { return deg < r.deg || (deg == r.deg && v < r.v); }
+
+			size_t deg = 0, v = 0;
+		};
+
+		ghl::vector<size_t> deg(n);
+		for (size_t v = 0; v != n; ++v)
+		{
+			size_t d = 0;
+			graph.for_each_neighbor(v, [&d](size_t, float) { ++d; });
+			deg.push_back(d);
+		}
+
+		// the roots of the components are tried in ascending order of degree
+		ghl::vector<size_t> by_degree;
+		degree_sort_order(graph, by_degree);
+
+		ghl::vector<bool> visited(n);
+		for (size_t v = 0; v != n; ++v) visited.push_back(false);
+
+		// the breadth first order, which is also used as the queue
+		ghl::vector<size_t> order(n);
+		order.increase_size(n);
+		for (size_t v = 0; v != n; ++v) order[n - 1 - by_degree[v]] = v;
+		ghl::vector<size_t> roots(order.begin(), order.end());
+		order = ghl::vector<size_t>(n);
+
+		ghl::vector<deg_and_index> children;
+		size_t head = 0;
+		for (size_t r = 0; r != n; ++r)
+		{
+			const size_t root = roots[r];
+			if (visited[root]) continue;
+
+			visited[root] = true;
+			order.push_back(root);
+
+			while (head != order.size())
+			{
+				const size_t v = order[head++];
+
+				children.clear();
+				graph.for_each_neighbor(v, [&](size_t u, float)
+				{
+					if (!visited[u])
+					{
+						visited[u] = true;
+						children.emplace_back(deg[u], u);
+					}
+				});
+
+				if (children.size() >= 2)
+				{
+					ghl::merge_sort(children);
+				}
+				for (const auto& c : children) order.push_back(c.v);
+			}
+		}
+
+		new_index.resize(n);
+		new_index.increase_size(n);
+		for (size_t i = 0; i != n; ++i) new_index[order[i]] = b_reverse ? n - 1 - i : i;
+	}
+
+	/*
+	* Orders the vertices greedily in the way of Gorder:
+	* the next vertex is always the one that has the most relations with the last window placed vertices,
+	* where u and v are related once for each edge between them and once for each common in-neighbor of them (i.e. they are siblings).
+	* This places vertices that are accessed together close to each other.
+	* 
+	* In-neighbors whose outdegree exceeds sqrt(V) are not used to find siblings, which otherwise would relate almost all vertices.
+	* 
+	* O(window * (sum over v of the number of siblings found) * log E)
+	* 
+	* G: an indexed graph, which provides num_vertices(), is_undirected(), and for_each_neighbor()
+	* @param new_index assumed to be empty when passed in
+	* @param window the number of the last placed vertices considered
+	*/
+	template <typename G>
+	void gorder_order(const G& graph, ghl::vector<size_t>& new_index, size_t window = 5)
+	{
+		const csr_graph out(graph);
+		const csr_graph in = out.transposed();
+		const size_t n = out.num_vertices();
+		if (0 == n) return;
+
+		size_t max_sibling_deg = 1;
+		while (max_sibling_deg * max_sibling_deg < n) ++max_sibling_deg;
+
+		ghl::vector<long long> key(n);
+		ghl::vector<bool> placed(n);
+		for (size_t v = 0; v != n; ++v) { key.push_back(0); placed.push_back(false); }
+
+		// a max heap of (key, v), where an entry is stale if v is placed or its key has changed since
+		std::priority_queue<std::pair<long long, size_t>> q;
+
+		auto change = [&](size_t u, long long delta)
+		{
+			if (!placed[u])
+			{
+				key[u] += delta;
+				q.emplace(key[u], u);
+			}
+		};
+		// adds (delta = 1) or removes (delta = -1) v from the window
+		auto update = [&](size_t v, long long delta)
+		{
+			for (auto i = out.adj_begin(v), e = out.adj_end(v); i != e; ++i) change(i->v, delta);
+			for (auto i = in.adj_begin(v), e = in.adj_end(v); i != e; ++i)
+			{
+				const size_t w = i->v;
+				if (!out.is_undirected()) change(w, delta);
+
+				if (out.degree(w) <= max_sibling_deg)
+				{
+					for (auto j = out.adj_begin(w), f = out.adj_end(w); j != f; ++j)
+					{
+						if (j->v != v) change(j->v, delta);
+					}
+				}
+			}
+		};
+
+		// when no vertex is related to the window, the one of the largest degree is chosen
+		ghl::vector<size_t> by_degree;
+		degree_sort_order(out, by_degree);
+		ghl::vector<size_t> fallback(n);
+		fallback.increase_size(n);
+		for (size_t v = 0; v != n; ++v) fallback[by_degree[v]] = v;
+		size_t next_fallback = 0;
+
+		ghl::vector<size_t> order(n);
+		for (size_t i = 0; i != n; ++i)
+		{
+			size_t v = n;
+			while (!q.empty())
+			{
+				auto top = q.top(); q.pop();
+				if (!placed[top.second] && key[top.second] == top.first && top.first > 0)
+				{
+					v = top.second;
+					break;
+				}
+			}
+			if (n == v)
+			{
+				while (placed[fallback[next_fallback]]) ++next_fallback;
+				v = fallback[next_fallback];
+			}
+
+			placed[v] = true;
+			order.push_back(v);
+			update(v, 1);
+
+			if (i >= window)
+			{
+				update(order[i - window], -1);
+			}
+		}
+
+		new_index.resize(n);
+		new_index.increase_size(n);
+		for (size_t i = 0; i != n; ++i) new_index[order[i]] = i;
+	}
+
+	/*
+	* A symmetric graph with weighted vertices and edges in the CSR format. 
+	* Used by multilevel_partition for the graphs of all levels.
+	*/
+	struct multilevel_partition_graph
+	{
+		size_t num_vertices() const { return vertex_weights.size(); }
+
+		// the adj list of v is adj[offsets[v], offsets[v+1]), where edge_weights[i] is the weight of the edge to adj[i]
+		ghl::vector<size_t> offsets;
+		ghl::vector<size_t> adj;
+		ghl::vector<long long> edge_weights;
+		ghl::vector<long long> vertex_weights;
+
+		/*
+		* Builds the graph whose vertex c consists of all v where group[v] = c (in [0, num_groups)),
+		* merging the weights of the vertices of each group and of the edges between each pair of groups.
+		* Edges inside a group are dropped.
+		*/
+		multilevel_partition_graph contracted(const ghl::vector<size_t>& group, size_t num_groups) const
+		{
+			const size_t n = num_vertices();
+			multilevel_partition_graph res;
+
+			// members of the groups, found by counting sort
+			ghl::vector<size_t> starts(num_groups + 1);
+			for (size_t c = 0; c != num_groups + 1; ++c) starts.push_back(0);
+			for (size_t v = 0; v != n; ++v) ++starts[group[v] + 1];
+			for (size_t c = 0; c != num_groups; ++c) starts[c + 1] += starts[c];
+			ghl::vector<size_t> members(n);
+			members.increase_size(n);
+			{
+				ghl::vector<size_t> next(starts.begin(), starts.end());
+				for (size_t v = 0; v != n; ++v) members[next[group[v]]++] = v;
+			}
+
+			// slot[c] = the position of the edge to c in the list being built, or n if there is none
+			ghl::vector<size_t> slot(num_groups);
+			for (size_t c = 0; c != num_groups; ++c) slot.push_back(n);
+
+			res.offsets.resize(num_groups + 1);
+			res.adj.resize(adj.size());
+			res.edge_weights.resize(adj.size());
+			res.vertex_weights.resize(num_groups);
+
+			res.offsets.push_back(0);
+			for (size_t c = 0; c != num_groups; ++c)
+			{
+				const size_t list_begin = res.adj.size();
+				long long w = 0;
+				for (size_t m = starts[c]; m != starts[c + 1]; ++m)
+				{
+					const size_t v = members[m];
+					w += vertex_weights[v];
+					for (size_t i = offsets[v]; i != offsets[v + 1]; ++i)
+					{
+						const size_t d = group[adj[i]];
+						if (d == c) continue;
+
+						if (n == slot[d])
+						{
+							slot[d] = res.adj.size();
+							res.adj.push_back(d);
+							res.edge_weights.push_back(edge_weights[i]);
+						}
+						else
+						{
+							res.edge_weights[slot[d]] += edge_weights[i];
+						}
+					}
+				}
+				for (size_t i = list_begin; i != res.adj.size(); ++i) slot[res.adj[i]] = n;
+
+				res.vertex_weights.push_back(w);
+				res.offsets.push_back(res.adj.size());
+			}
+
+			return res;
+		}
+	};
+
+	/*
+	* Partitions the vertices of an indexed graph into k parts of roughly equal sizes with few edges between the parts,
+	* by the multilevel scheme:
+	* 1. coarsening: contracts the graph repeatedly by merging each vertex with its unmatched neighbor of the heaviest edge (heavy edge matching),
+	*    until it has no more than 20k vertices or stops shrinking
+	* 2. initial partitioning: cuts the breadth first order of the coarsest graph into k pieces of equal weights
+	* 3. uncoarsening: projects the parts back level by level, and refines them on each level by greedily moving boundary vertices 
+	*    to the part they have the most edges to, as long as no part becomes heavier than imbalance * V / k
+	* 
+	* Directions and weights of the edges are ignored.
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor()
+	* @param k the number of parts (>= 1)
+	* @param part where part[v] = the part (in [0, k)) v belongs to (assumed to be empty when passed in)
+	* @param imbalance the max ratio of the size of a part to V / k (>= 1)
+	*/
+	template <typename G>
+	void multilevel_partition(const G& graph, unsigned k, ghl::vector<unsigned>& part, double imbalance = 1.03)
+	{
+		const size_t n = graph.num_vertices();
+		part.resize(n);
+		if (0 == n) return;
+		if (k <= 1)
+		{
+			for (size_t v = 0; v != n; ++v) part.push_back(0);
+			return;
+		}
+
+		// the finest level is the graph made symmetric, without self loops
+		multilevel_partition_graph finest;
+		{
+			// every vertex is its own group, which merges parallel edges and the two directions of an edge
+			multilevel_partition_graph raw;
+			size_t num_refs = 0;
+			ghl::vector<size_t> deg(n);
+			for (size_t v = 0; v != n; ++v) deg.push_back(0);
+			for (size_t v = 0; v != n; ++v)
+			{
+				graph.for_each_neighbor(v, [&](size_t u, float) { if (u != v) { ++deg[v]; ++deg[u]; num_refs += 2; } });
+			}
+
+			raw.offsets.resize(n + 1);
+			raw.offsets.push_back(0);
+			for (size_t v = 0; v != n; ++v) raw.offsets.push_back(raw.offsets[v] + deg[v]);
+
+			raw.adj.resize(num_refs);
+			raw.adj.increase_size(num_refs);
+			raw.edge_weights.resize(num_refs);
+			raw.vertex_weights.resize(n);
+			for (size_t i = 0; i != num_refs; ++i) raw.edge_weights.push_back(1);
+			for (size_t v = 0; v != n; ++v) raw.vertex_weights.push_back(1);
+
+			ghl::vector<size_t> next(raw.offsets.begin(), raw.offsets.end());
+			for (size_t v = 0; v != n; ++v)
+			{
+				graph.for_each_neighbor(v, [&](size_t u, float) { if (u != v) { raw.adj[next[v]++] = u; raw.adj[next[u]++] = v; } });
+			}
+
+			ghl::vector<size_t> identity(n);
+			for (size_t v = 0; v != n; ++v) identity.push_back(v);
+			finest = raw.contracted(identity, n);
+		}
+
+		// levels[0] is the finest one, and maps[l][v] = the vertex of levels[l+1] that v of levels[l] is merged into
+		std::list<multilevel_partition_graph> levels;
+		std::list<ghl::vector<size_t>> maps;
+		levels.push_back(std::move(finest));
+
+		// a simple LCG, so that the matching is not biased by the order of the indices
+		uint64_t seed = 0x9E3779B97F4A7C15ull;
+		auto random = [&seed]() { seed = seed * 6364136223846793005ull + 1442695040888963407ull; return seed >> 33; };
+
+		const size_t coarsest_size = 20 * (size_t)k;
+		while (levels.back().num_vertices() > coarsest_size)
+		{
+			const auto& g = levels.back();
+			const size_t gn = g.num_vertices();
+
+			// visit the vertices in a random order
+			ghl::vector<size_t> visit(gn);
+			for (size_t v = 0; v != gn; ++v) visit.push_back(v);
+			for (size_t i = gn - 1; i > 0; --i)
+			{
+				size_t j = random() % (i + 1);
+				size_t t = visit[i]; visit[i] = visit[j]; visit[j] = t;
+			}
+
+			ghl::vector<size_t> group(gn);
+			for (size_t v = 0; v != gn; ++v) group.push_back(gn);
+			size_t num_groups = 0;
+			for (size_t i = 0; i != gn; ++i)
+			{
+				const size_t v = visit[i];
+				if (gn != group[v]) continue;
+
+				size_t mate = v;
+				long long heaviest = 0;
+				for (size_t j = g.offsets[v]; j != g.offsets[v + 1]; ++j)
+				{
+					if (gn == group[g.adj[j]] && g.edge_weights[j] > heaviest)
+					{
+						heaviest = g.edge_weights[j];
+						mate = g.adj[j];
+					}
+				}
+
+				group[v] = group[mate] = num_groups++;
+			}
+
+			// stop if the graph barely shrinks (e.g. a star)
+			if (num_groups * 20 > gn * 19) break;
+
+			levels.push_back(g.contracted(group, num_groups));
+			maps.push_back(std::move(group));
+		}
+
+		long long total_weight = 0;
+		for (const auto& w : levels.front().vertex_weights) total_weight += w;
+		const long long max_weight = (long long)(imbalance * total_weight / k) + 1;
+
+		// initial partitioning of the coarsest level
+		ghl::vector<unsigned> curr;
+		{
+			const auto& g = levels.back();
+			const size_t gn = g.num_vertices();
+
+			ghl::vector<size_t> order(gn);
+			ghl::vector<bool> visited(gn);
+			for (size_t v = 0; v != gn; ++v) visited.push_back(false);
+			size_t head = 0;
+			for (size_t r = 0; r != gn; ++r)
+			{
+				if (visited[r]) continue;
+				visited[r] = true;
+				order.push_back(r);
+				while (head != order.size())
+				{
+					const size_t v = order[head++];
+					for (size_t j = g.offsets[v]; j != g.offsets[v + 1]; ++j)
+					{
+						if (!visited[g.adj[j]])
+						{
+							visited[g.adj[j]] = true;
+							order.push_back(g.adj[j]);
+						}
+					}
+				}
+			}
+
+			curr.resize(gn);
+			curr.increase_size(gn);
+			long long acc = 0;
+			for (size_t i = 0; i != gn; ++i)
+			{
+				const size_t v = order[i];
+				// the part whose range of weights contains the middle of v's weight
+				unsigned p = (unsigned)(((2 * acc + g.vertex_weights[v]) * (long long)k) / (2 * total_weight));
+				curr[v] = p < k ? p : k - 1;
+				acc += g.vertex_weights[v];
+			}
+		}
+
+		// refines curr on g by moving vertices greedily
+		ghl::vector<long long> conn(k);
+		for (unsigned p = 0; p != k; ++p) conn.push_back(0);
+		auto refine = [&](const multilevel_partition_graph& g)
+		{
+			const size_t gn = g.num_vertices();
+
+			ghl::vector<long long> part_weights(k);
+			for (unsigned p = 0; p != k; ++p) part_weights.push_back(0);
+			for (size_t v = 0; v != gn; ++v) part_weights[curr[v]] += g.vertex_weights[v];
+
+			for (int pass = 0; pass != 4; ++pass)
+			{
+				size_t moved = 0;
+				for (size_t v = 0; v != gn; ++v)
+				{
+					const unsigned from = curr[v];
+					const long long w = g.vertex_weights[v];
+
+					for (size_t j = g.offsets[v]; j != g.offsets[v + 1]; ++j) conn[curr[g.adj[j]]] += g.edge_weights[j];
+
+					// an overweight part gives vertices away even without gains
+					unsigned best = from;
+					long long best_gain = part_weights[from] > max_weight ? -conn[from] - 1 : 0;
+					for (size_t j = g.offsets[v]; j != g.offsets[v + 1]; ++j)
+					{
+						const unsigned to = curr[g.adj[j]];
+						if (to == from || part_weights[to] + w > max_weight) continue;
+
+						const long long gain = conn[to] - conn[from];
+						if (gain > best_gain || (gain == best_gain && best != from && part_weights[to] < part_weights[best]))
+						{
+							best = to;
+							best_gain = gain;
+						}
+					}
+
+					for (size_t j = g.offsets[v]; j != g.offsets[v + 1]; ++j) conn[curr[g.adj[j]]] = 0;
+
+					if (best != from && (best_gain > 0 || part_weights[from] > max_weight))
+					{
+						part_weights[from] -= w;
+						part_weights[best] += w;
+						curr[v] = best;
+						++moved;
+					}
+				}
+				if (0 == moved) break;
+			}
+		};
+
+		// uncoarsening
+		auto level = levels.rbegin();
+		auto map = maps.rbegin();
+		refine(*level);
+		for (; map != maps.rend(); ++map)
+		{
+			++level;
+			const size_t gn = level->num_vertices();
+
+			ghl::vector<unsigned> finer(gn);
+			for (size_t v = 0; v != gn; ++v) finer.push_back(curr[(*map)[v]]);
+			curr = std::move(finer);
+
+			refine(*level);
+		}
+
+		for (size_t v = 0; v != n; ++v) part.push_back(curr[v]);
+	}
+
+	/*
+	* @returns the number of edges whose endpoints are in different parts. 
+	* 
+	* G: an indexed graph, which provides num_vertices(), is_undirected(), and for_each_neighbor()
+	* @param part where part[v] = the part v belongs to
+	*/
+	template <typename G>
+	size_t edge_cut(const G& graph, const ghl::vector<unsigned>& part)
+	{
+		size_t cut = 0;
+		for (size_t v = 0; v != graph.num_vertices(); ++v)
+		{
+			graph.for_each_neighbor(v, [&](size_t u, float) { if (part[u] != part[v]) ++cut; });
+		}
+		// all edges are visited twice for undirected graph
+		return graph.is_undirected() ? cut / 2 : cut;
+	}
+
+	/*
+	* Builds the simple undirected graph underlying an indexed graph:
+	* directions, weights, self loops, and parallel edges are dropped, and each adj list is sorted in ascending order.
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor()
+	* @param offsets where the adj list of v is adj[offsets[v], offsets[v+1]) (assumed to be empty when passed in)
+	* @param adj (assumed to be empty when passed in)
+	*/
+	template <typename G>
+	void simple_undirected_adjacency(const G& graph, ghl::vector<size_t>& offsets, ghl::vector<size_t>& adj)
+	{
+		const size_t n = graph.num_vertices();
+
+		// counting sort the refs (in both directions) by their targets, and then stably by their sources,
+		// which sorts every list
+		ghl::vector<size_t> counts(n + 1);
+		for (size_t v = 0; v != n + 1; ++v) counts.push_back(0);
+		size_t num_refs = 0;
+		for (size_t v = 0; v != n; ++v)
+		{
+			graph.for_each_neighbor(v, [&](size_t u, float) { if (u != v) { ++counts[u + 1]; ++counts[v + 1]; num_refs += 2; } });
+		}
+		for (size_t v = 0; v != n; ++v) counts[v + 1] += counts[v];
+
+		// by_target[i] = the source of the i^th ref in the order of targets
+		ghl::vector<size_t> by_target(num_refs);
+		by_target.increase_size(num_refs);
+		{
+			ghl::vector<size_t> next(counts.begin(), counts.end());
+			for (size_t v = 0; v != n; ++v)
+			{
+				graph.for_each_neighbor(v, [&](size_t u, float) { if (u != v) { by_target[next[u]++] = v; by_target[next[v]++] = u; } });
+			}
+		}
+
+		// the source counts are the same as the target counts, as every ref is added in both directions
+		ghl::vector<size_t> next(counts.begin(), counts.end());
+		adj.resize(num_refs);
+		adj.increase_size(num_refs);
+		for (size_t t = 0; t != n; ++t)
+		{
+			for (size_t i = counts[t]; i != counts[t + 1]; ++i) adj[next[by_target[i]]++] = t;
+		}
+
+		// remove the duplicates of every list in place
+		offsets.resize(n + 1);
+		offsets.push_back(0);
+		size_t size = 0;
+		for (size_t v = 0; v != n; ++v)
+		{
+			const size_t list_begin = size;
+			for (size_t i = counts[v]; i != counts[v + 1]; ++i)
+			{
+				if (size == list_begin || adj[size - 1] != adj[i]) adj[size++] = adj[i];
+			}
+			offsets.push_back(size);
+		}
+		while (adj.size() != size) adj.remove_back();
+	}
+
+	/*
+	* @returns the number of elements in both a[0, na) and b[0, nb), which are sorted in ascending order and have no duplicates
+	* 
+	* Uses SSE2 to compare 4 elements of a against 4 of b at a time if available.
+	*/
+	inline uint64_t sorted_intersection_size(const uint32_t* a, size_t na, const uint32_t* b, size_t nb)
+	{
+		uint64_t res = 0;
+		size_t i = 0, j = 0;
+
+#ifdef GHL_SSE2
+		// the number of 1s in a 4 bit mask
+		static constexpr int bits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+		while (i + 4 <= na && j + 4 <= nb)
+		{
+			const __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+			const __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+
+			// compare va with all 4 rotations of vb
+			__m128i m = _mm_cmpeq_epi32(va, vb);
+			m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1))));
+			m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))));
+			m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))));
+			res += bits[_mm_movemask_ps(_mm_castsi128_ps(m))];
+
+			// skip the block(s) whose largest element is the smaller one
+			const uint32_t a_max = a[i + 3], b_max = b[j + 3];
+			if (a_max <= b_max) i += 4;
+			if (b_max <= a_max) j += 4;
+		}
+#endif
+
+		// merge the rest
+		while (i < na && j < nb)
+		{
+			if (a[i] < b[j]) ++i;
+			else if (b[j] < a[i]) ++j;
+			else { ++res; ++i; ++j; }
+		}
+
+		return res;
+	}
+
+	/*
+	* Counts the triangles (sets of 3 vertices that are pairwise adj) in the simple undirected graph underlying an indexed graph.
+	* 
+	* Each edge is directed from the endpoint of the lower degree to the one of the higher degree (ties are broken by the indices),
+	* so that each triangle is found exactly once, as the intersection of the sorted out lists of the two lower endpoints,
+	* and no out list is longer than sqrt(2E). O(E^1.5)
+	* 
+	* The vertices are distributed to num_threads threads in chunks.
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor(), which has fewer than 2^32 vertices
+	* @param num_threads the number of threads to use. 0 means std::thread::hardware_concurrency()
+	*/
+	template <typename G>
+	uint64_t count_triangles(const G& graph, unsigned num_threads = 0)
+	{
+		ghl::vector<size_t> offsets, adj;
+		simple_undirected_adjacency(graph, offsets, adj);
+		const size_t n = graph.num_vertices();
+
+		// rank[v] < rank[u] iff v has the lower degree (or the lower index when the degrees are the same)
+		ghl::vector<size_t> rank(n);
+		{
+			// counting sort by degree, which is stable, so ties are broken by the indices
+			size_t max_deg = 0;
+			for (size_t v = 0; v != n; ++v) if (offsets[v + 1] - offsets[v] > max_deg) max_deg = offsets[v + 1] - offsets[v];
+
+			ghl::vector<size_t> starts(max_deg + 2);
+			for (size_t d = 0; d != max_deg + 2; ++d) starts.push_back(0);
+			for (size_t v = 0; v != n; ++v) ++starts[offsets[v + 1] - offsets[v] + 1];
+			for (size_t d = 0; d != max_deg + 1; ++d) starts[d + 1] += starts[d];
+			rank.increase_size(n);
+			for (size_t v = 0; v != n; ++v) rank[v] = starts[offsets[v + 1] - offsets[v]]++;
+		}
+
+		// the out lists in the rank space, which are sorted in ascending order
+		ghl::vector<size_t> out_offsets(n + 1);
+		ghl::vector<uint32_t> out;
+		{
+			ghl::vector<size_t> counts(n + 1);
+			for (size_t r = 0; r != n + 1; ++r) counts.push_back(0);
+			for (size_t v = 0; v != n; ++v)
+			{
+				for (size_t i = offsets[v]; i != offsets[v + 1]; ++i) if (rank[v] < rank[adj[i]]) ++counts[rank[v] + 1];
+			}
+			for (size_t r = 0; r != n; ++r) counts[r + 1] += counts[r];
+			for (size_t r = 0; r != n + 1; ++r) out_offsets.push_back(counts[r]);
+
+			// fill the lists in ascending order of the targets' ranks
+			ghl::vector<size_t> by_rank(n);
+			by_rank.increase_size(n);
+			for (size_t v = 0; v != n; ++v) by_rank[rank[v]] = v;
+
+			out.resize(adj.size() / 2);
+			out.increase_size(adj.size() / 2);
+			for (size_t r = 0; r != n; ++r)
+			{
+				const size_t u = by_rank[r];
+				for (size_t i = offsets[u]; i != offsets[u + 1]; ++i)
+				{
+					const size_t s = rank[adj[i]];
+					if (s < r) out[counts[s]++] = (uint32_t)r;
+				}
+			}
+		}
+
+		if (0 == num_threads) num_threads = std::thread::hardware_concurrency();
+		if (0 == num_threads) num_threads = 1;
+
+		// threads take chunks of vertices until none is left, as the work per vertex is very uneven
+		const size_t chunk = 256;
+		std::atomic<size_t> next_chunk(0);
+		std::atomic<uint64_t> total(0);
+		auto work = [&]()
+		{
+			uint64_t count = 0;
+			for (size_t begin = next_chunk.fetch_add(chunk); begin < n; begin = next_chunk.fetch_add(chunk))
+			{
+				const size_t end = begin + chunk < n ? begin + chunk : n;
+				for (size_t v = begin; v != end; ++v)
+				{
+					const uint32_t* v_out = out.begin() + out_offsets[v];
+					const size_t v_size = out_offsets[v + 1] - out_offsets[v];
+					for (size_t i = 0; i != v_size; ++i)
+					{
+						const size_t u = v_out[i];
+						count += sorted_intersection_size(v_out + i + 1, v_size - i - 1, out.begin() + out_offsets[u], out_offsets[u + 1] - out_offsets[u]);
+					}
+				}
+			}
+			total += count;
+		};
+
+		// std::thread is not copyable, which ghl::vector requires
+		std::unique_ptr<std::thread[]> threads(new std::thread[num_threads - 1]);
+		for (unsigned t = 0; t + 1 < num_threads; ++t) threads[t] = std::thread(work);
+		work();
+		for (unsigned t = 0; t + 1 < num_threads; ++t) threads[t].join();
+
+		return total;
+	}
+
+	/*
+	* Calculates the core number of every vertex of the simple undirected graph underlying an indexed graph,
+	* where the core number of v is the largest k such that v is in the k-core (the maximal subgraph whose vertices all have degrees >= k).
+	* 
+	* Uses the bucket algorithm of Batagelj and Zaversnik: repeatedly removes a vertex of the minimal degree, 
+	* whose degree at the time is its core number. O(V + E)
+	* 
+	* G: an indexed graph, which provides num_vertices() and for_each_neighbor()
+	* @param core where core[v] = the core number of v (assumed to be empty when passed in)
+	* 
+	* @returns the largest core number (the degeneracy of the graph)
+	*/
+	template <typename G>
+	size_t k_core_decomposition(const G& graph, ghl::vector<size_t>& core)
+	{
+		ghl::vector<size_t> offsets, adj;
+		simple_undirected_adjacency(graph, offsets, adj);
+		const size_t n = graph.num_vertices();
+
+		core.resize(n);
+		size_t max_deg = 0;
+		for (size_t v = 0; v != n; ++v)
+		{
+			core.push_back(offsets[v + 1] - offsets[v]); // the current degree until v is removed
+			if (core[v] > max_deg) max_deg = core[v];
+		}
+
+		// vertices sorted by current degree, where pos[v] is the position of v,
+		// and bin[d] is the position of the first vertex of degree d
+		ghl::vector<size_t> bin(max_deg + 1), sorted(n), pos(n);
+		for (size_t d = 0; d != max_deg + 1; ++d) bin.push_back(0);
+		for (size_t v = 0; v != n; ++v) ++bin[core[v]];
+		{
+			size_t start = 0;
+			for (size_t d = 0; d != max_deg + 1; ++d) { size_t num = bin[d]; bin[d] = start; start += num; }
+		}
+		sorted.increase_size(n);
+		pos.increase_size(n);
+		for (size_t v = 0; v != n; ++v)
+		{
+			pos[v] = bin[core[v]]++;
+			sorted[pos[v]] = v;
+		}
+		for (size_t d = max_deg; d > 0; --d) bin[d] = bin[d - 1];
+		if (0 != n) bin[0] = 0;
+
+		size_t degeneracy = 0;
+		for (size_t i = 0; i != n; ++i)
+		{
+			const size_t v = sorted[i];
+			if (core[v] > degeneracy) degeneracy = core[v];
+
+			for (size_t j = offsets[v]; j != offsets[v + 1]; ++j)
+			{
+				const size_t u = adj[j];
+				if (core[u] > core[v])
+				{
+					// move u to the front of its bin, and then shrink the bin by one, which decreases its degree
+					const size_t du = core[u], pu = pos[u], pw = bin[du], w = sorted[pw];
+					if (u != w)
+					{
+						pos[u] = pw; sorted[pw] = u;
+						pos[w] = pu; sorted[pu] = w;
+					}
+					++bin[du];
+					--core[u];
+				}
+			}
+		}
+
+		return degeneracy;
+	}
+
 	/*
 	* Performs Prim's algorithm on graph (assumed to be simple and connected) with base_vertex, 
 	* whose output is written to tree (assumed to be empty when passed in)
@@ -1,9 +1,140 @@
 #pragma once
 
 #include "../data_structures/vector.h" // used for storing copied elements in merge_sort
+#include "../data_structures/thread_pool.h" // used by the parallel sorts
+#include "sorting_network.h" // the base case of introsort and merge_sort for keys of 32 and 64 bits
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <type_traits>
+#include <utility>
+#include <algorithm> // std::iter_swap, std::reverse
+#include <functional> // std::less, std::greater, which the fast paths recognize
 
 namespace ghl
 {
+	/*
+	* Every sort takes a comparison comp and a projection proj, and sorts the elements in the order of comp(proj(a), proj(b)).
+	* By default comp is operator< and proj the identity, so the elements are sorted in ascending order.
+	* proj may also be a pointer to a data member, to sort records by one of their fields.
+	*
+	* If proj yields an arithmetic key and comp is operator<, std::less or std::greater, the sorts take their fast paths for arithmetic keys:
+	* the sorting networks for elements that are their own keys, the branchless partition of introsort and introselect,
+	* and radix_sort for merge_sort and argsort of records by a key, if it is an integer (but not a bool), a float or a double.
+	*/
+	namespace detail
+	{
+		// the default comparison of the sorts, which is operator<
+		struct less
+		{
+			template <typename A, typename B>
+			bool operator()(const A& a, const B& b) const { return a < b; }
+		};
+
+		// the default projection of the sorts and key of radix_sort: the element itself
+		struct identity
+		{
+			template <typename A>
+			const A& operator()(const A& a) const { return a; }
+		};
+
+		// @returns proj(a)
+		template <typename Proj, typename A>
+		auto project(const Proj& proj, const A& a) -> decltype(proj(a))
+		{
+			return proj(a);
+		}
+
+		// @returns the data member of a that member points to
+		template <typename M, typename C, typename A>
+		const M& project(M C::* member, const A& a)
+		{
+			return a.*member;
+		}
+
+		// compares elements by comp on their projections
+		template <typename Compare, typename Proj>
+		struct projected_comparison
+		{
+			Compare comp;
+			Proj proj;
+
+			template <typename A, typename B>
+			bool operator()(const A& a, const B& b) const { return comp(project(proj, a), project(proj, b)); }
+		};
+
+		// @returns the comparison of the elements that the sorts use, which is comp itself if proj is the identity
+		template <typename Compare, typename Proj>
+		projected_comparison<Compare, Proj> make_comparison(Compare comp, Proj proj)
+		{
+			return { comp, proj };
+		}
+
+		template <typename Compare>
+		Compare make_comparison(Compare comp, identity)
+		{
+			return comp;
+		}
+
+		// whether radix_sort can sort keys of type K (see radix_key_traits): integers but bools, floats and doubles
+		template <typename K>
+		struct is_radix_key : std::integral_constant<bool,
+			(std::is_integral<K>::value && !std::is_same<K, bool>::value) || std::is_same<K, float>::value || std::is_same<K, double>::value> {};
+
+		// 1 if Compare is known to be operator< on keys of type K, -1 if it is known to be operator>, and 0 otherwise
+		template <typename Compare, typename K>
+		struct comparison_order : std::integral_constant<int, 0> {};
+
+		template <typename K>
+		struct comparison_order<less, K> : std::integral_constant<int, 1> {};
+
+		template <typename K>
+		struct comparison_order<std::less<K>, K> : std::integral_constant<int, 1> {};
+
+		template <typename K>
+		struct comparison_order<std::less<>, K> : std::integral_constant<int, 1> {};
+
+		template <typename K>
+		struct comparison_order<std::greater<K>, K> : std::integral_constant<int, -1> {};
+
+		template <typename K>
+		struct comparison_order<std::greater<>, K> : std::integral_constant<int, -1> {};
+
+		/*
+		* What the sorts know of the comparison Compare (made by make_comparison) of elements of type V:
+		* whether it compares projections, the type of the keys it compares, and their order (see comparison_order)
+		*/
+		template <typename Compare, typename V>
+		struct comparison_traits
+		{
+			static constexpr bool projected = false;
+			using key_t = V;
+			static constexpr int order = comparison_order<Compare, V>::value;
+			// the keys are arithmetic and compared by < or >, which is cheap and has no side effects
+			static constexpr bool arithmetic = std::is_arithmetic<key_t>::value && 0 != order;
+			// and radix_sort can sort them
+			static constexpr bool radix = is_radix_key<key_t>::value && 0 != order;
+		};
+
+		template <typename Compare, typename Proj, typename V>
+		struct comparison_traits<projected_comparison<Compare, Proj>, V>
+		{
+			static constexpr bool projected = true;
+			using key_t = std::remove_cv_t<std::remove_reference_t<decltype(project(std::declval<const Proj&>(), std::declval<const V&>()))>>;
+			static constexpr int order = comparison_order<Compare, key_t>::value;
+			static constexpr bool arithmetic = std::is_arithmetic<key_t>::value && 0 != order;
+			static constexpr bool radix = is_radix_key<key_t>::value && 0 != order;
+		};
+
+		// whether T is a list with begin() and end(), which tells the overloads of the sorts for lists from the ones for iterators
+		template <typename T, typename = void>
+		struct is_list : std::false_type {};
+
+		template <typename T>
+		struct is_list<T, decltype((void)std::declval<T&>().begin())> : std::true_type {};
+	}
+
 	/*
 	* The list is divided into left subseq and right subseq
 	* The minimal element of the right seq BUBBLEs to the left seq
@@ -14,12 +145,14 @@ namespace ghl
 	* 
 	* Requirements:
 	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
-	* 2. the type of the object must have an operator<
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
 	* 3. the type of the object must be Cpp17CopyConstructible, Cpp17CopyAssignable
 	*/
-	template <typename T>
-	void bubble_sort(T begin, T end)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void bubble_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
 	{
+		auto before = detail::make_comparison(comp, proj);
+
 		// left subseq: [begin, leftBound) (the empty set if leftBound = begin)
 		// right subseq: [leftBound, end)
 
@@ -36,7 +169,7 @@ namespace ghl
 				*/
 				for (; rightMinIndex >= leftBound; --rightMinIndex)
 				{
-					if (*(rightMinIndex + 1) < *rightMinIndex) // the one to the right of the min is smaller than the min
+					if (before(*(rightMinIndex + 1), *rightMinIndex)) // the one to the right of the min is smaller than the min
 					{
 						// swap the two
 						auto temp = *(rightMinIndex + 1); // Cpp17CopyConstructible
@@ -50,12 +183,12 @@ namespace ghl
 
 	/*
 	* Overloading to bubble_sort
-	* Equivalent to bubble_sort(list.begin(), list.end());
+	* Equivalent to bubble_sort(list.begin(), list.end(), comp, proj);
 	*/
-	template <typename T>
-	void bubble_sort(T & list)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void bubble_sort(T & list, Compare comp = Compare(), Proj proj = Proj())
 	{
-		bubble_sort(list.begin(), list.end());
+		bubble_sort(list.begin(), list.end(), comp, proj);
 	}
 
 	/*
@@ -66,12 +199,14 @@ namespace ghl
 	* 
 	* Requirements:
 	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
-	* 2. the type of the object must have an operator<
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
 	* 3. the type of the object must be Cpp17CopyAssignable
 	*/
-	template <typename T>
-	void insertion_sort(T begin, T end)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void insertion_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
 	{
+		auto before = detail::make_comparison(comp, proj);
+
 		// left subseq: [begin, leftBound) (the empty set if leftBound = begin)
 		// right subseq: [leftBound, end)
 
@@ -87,7 +222,7 @@ namespace ghl
 				{
 					for (auto i = leftBound - 1; /* will decide when to break in the loop */ ; --i) // iterate through left subseq
 					{
-						if (*i < firstRight) // insert the element after i if *i is the first that < it
+						if (before(*i, firstRight)) // insert the element after i if *i is the first that < it
 						{
 							// move all elements in range (i,leftBound) one step forward (thus *leftBound is overwritten)
 							if (leftBound != i+1) // (i,leftBound) is not empty
@@ -173,6 +308,16 @@ namespace ghl
 		}
 	}
 
+	/*
+	* Overloading to insertion_sort
+	* Equivalent to insertion_sort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void insertion_sort(T& list, Compare comp, Proj proj = Proj())
+	{
+		insertion_sort(list.begin(), list.end(), comp, proj);
+	}
+
 	/*
 	* Selects the minimal element of the right subsequence and arranges it on the left
 	*
@@ -182,12 +327,14 @@ namespace ghl
 	* 
 	* Requirements:
 	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
-	* 2. the type of the object must have an operator<
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
 	* 3. the type of the object must be Cpp17CopyConstructible, Cpp17CopyAssignable
 	*/
-	template <typename T>
-	void selection_sort(T begin, T end)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void selection_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
 	{
+		auto before = detail::make_comparison(comp, proj);
+
 		// left subseq: [begin, leftBound) (the empty set if leftBound = begin)
 		// right subseq: [leftBound, end)
 
@@ -200,7 +347,7 @@ namespace ghl
 				auto rightMin = *rightMinIndex;
 				for (auto i = leftBound; i != end; ++i) // find the minimal of right subseq by iteration
 				{
-					if (*i < rightMin)
+					if (before(*i, rightMin))
 					{
 						rightMin = *i;
 						rightMinIndex = i;
@@ -221,106 +368,2086 @@ namespace ghl
 
 	/*
 	* Overloading to selection_sort
-	* Equivalent to selection_sort(list.begin(), list.end());
+	* Equivalent to selection_sort(list.begin(), list.end(), comp, proj);
 	*/
-	template <typename T>
-	void selection_sort(T & list)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void selection_sort(T & list, Compare comp = Compare(), Proj proj = Proj())
 	{
-		selection_sort(list.begin(), list.end());
+		selection_sort(list.begin(), list.end(), comp, proj);
 	}
 
-	/*
-	* Merges two sublists that are divided in merge_sort below
-	*/
-	template <typename T>
-	void merge(T begin, T mid, T end)
+	namespace detail
 	{
-		// copy right and left
-		ghl::vector<std::remove_reference_t<decltype(*begin)>> lCpy(begin, mid);
-		ghl::vector<std::remove_reference_t<decltype(*begin)>> rCpy(mid, end);
+		/*
+		* Whether the short ranges of T are sorted by network_sort, which only sorts elements that are their own keys,
+		* compared by operator< (or operator>, by reversing what it sorts).
+		* The stable sorts only use it for integers, as it orders -0 and +0, which compare equal.
+		*/
+		template <typename T, typename Compare, bool b_stable>
+		struct use_sorting_network
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<T>())>>;
+			using traits = comparison_traits<Compare, value_t>;
+			static constexpr bool value = !traits::projected && 0 != traits::order && has_sorting_network<T>::value && (!b_stable || std::is_integral<value_t>::value);
+		};
+
+		// the overload of sort_by_network for ranges without a network, which is never called
+		template <typename Compare, typename T>
+		void sort_by_network(T, T, std::false_type) {}
+
+		// sorts [begin, end) by network_sort in the order of Compare. Only called if use_sorting_network (the last parameter is its value)
+		template <typename Compare, typename T>
+		void sort_by_network(T begin, T end, std::true_type)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			network_sort(begin, end, std::true_type());
+			if (comparison_traits<Compare, value_t>::order < 0) std::reverse(begin, end);
+		}
+
+		/*
+		* Insertion sort that moves instead of copying, as the base case of introsort and merge_sort.
+		* Stable, as an element is only moved past greater ones
+		*/
+		template <typename T, typename Compare>
+		void insertion_sort_moves(T begin, T end, Compare comp)
+		{
+			if (begin == end) return;
+
+			for (T cur = begin + 1; cur != end; ++cur)
+			{
+				T sift = cur, sift_1 = cur - 1;
+				if (comp(*sift, *sift_1))
+				{
+					auto tmp = std::move(*sift);
+					do { *sift-- = std::move(*sift_1); } while (sift != begin && comp(tmp, *--sift_1));
+					*sift = std::move(tmp);
+				}
+			}
+		}
 
-		auto lIter = lCpy.begin(), rIter = rCpy.begin();
-		auto lEnd = lCpy.end(), rEnd = rCpy.end();
-		T i = begin;
 
-		for (; lIter != lEnd && rIter != rEnd; ++i) // loop until either of the two is empty
+		// ranges of at most this size are insertion sorted by merge_sort
+		constexpr ptrdiff_t merge_sort_insertion_threshold = 32;
+		// ranges of at most this size are sorted by network_sort in merge_sort, if use_sorting_network
+		constexpr ptrdiff_t merge_sort_network_threshold = 64;
+		static_assert(merge_sort_network_threshold <= (ptrdiff_t)network_max_size<int64_t*>(), "the network has to hold the range");
+		// the number of times in a row a run has to win before the merge starts galloping
+		constexpr size_t min_gallop = 7;
+
+		/*
+		* @returns the first position in [begin, end) whose element is not before(), where before() is true for a prefix of the range,
+		* found by exponential search from begin (or from end if b_from_end), followed by a binary search.
+		* So it takes O(log d) comparisons, where d is the distance of the position from where the search starts.
+		*/
+		template <typename T, typename Pred>
+		T gallop(T begin, T end, Pred before, bool b_from_end)
 		{
-			if (*lIter < *rIter) // the miminal of left is the smallest, move it to the next place
+			const ptrdiff_t size = end - begin;
+			ptrdiff_t lo = 0, hi = size; // the position is in [lo, hi]
+
+			if (!b_from_end)
+			{
+				for (ptrdiff_t p = 0; p < size; p = 2 * p + 1)
+				{
+					if (!before(*(begin + p))) { hi = p; break; }
+					lo = p + 1;
+				}
+			}
+			else
+			{
+				for (ptrdiff_t d = 1; d <= size; d = 2 * d + 1)
+				{
+					if (before(*(begin + (size - d)))) { lo = size - d + 1; break; }
+					hi = size - d;
+				}
+			}
+
+			while (lo < hi)
 			{
-				*i = *lIter;
-				++lIter;
+				const ptrdiff_t m = lo + (hi - lo) / 2;
+				if (before(*(begin + m))) lo = m + 1;
+				else hi = m;
 			}
-			else // the miminal of right is the smallest, move it to the next place
+			return begin + lo;
+		}
+
+		/*
+		* Merges [begin, mid) and [mid, end) where the left one is the shorter, by moving it into buffer, and merging forwards.
+		* Gallops when one side keeps winning.
+		*/
+		template <typename T, typename Buffer, typename Compare>
+		void merge_lo(T begin, T mid, T end, Buffer& buffer, Compare comp)
+		{
+			buffer.resize(mid - begin); // does nothing if it is large enough, as it should be
+			for (T i = begin; i != mid; ++i) buffer.emplace_back(std::move(*i));
+
+			auto l = buffer.begin(), l_end = buffer.end();
+			T r = mid, out = begin;
+			size_t l_wins = 0, r_wins = 0;
+
+			while (l != l_end && r != end)
 			{
-				*i = *rIter;
-				++rIter;
+				// ties are won by the left, which keeps the merge stable
+				if (comp(*r, *l)) { *out++ = std::move(*r++); ++r_wins; l_wins = 0; }
+				else { *out++ = std::move(*l++); ++l_wins; r_wins = 0; }
+
+				if (l_wins >= min_gallop && l != l_end && r != end)
+				{
+					// move all left elements that are not greater than *r at once
+					const auto& key = *r;
+					auto stop = gallop(l, l_end, [&](const auto& e) { return !comp(key, e); }, false);
+					while (l != stop) *out++ = std::move(*l++);
+					l_wins = 0;
+				}
+				else if (r_wins >= min_gallop && l != l_end && r != end)
+				{
+					// move all right elements that are less than *l at once
+					const auto& key = *l;
+					T stop = gallop(r, end, [&](const auto& e) { return comp(e, key); }, false);
+					while (r != stop) *out++ = std::move(*r++);
+					r_wins = 0;
+				}
 			}
+
+			// the rest of the right run is already in place
+			while (l != l_end) *out++ = std::move(*l++);
+			buffer.clear();
 		}
 
-		if (lIter == lEnd) // lCpy is empty
+		/*
+		* Merges [begin, mid) and [mid, end) where the right one is the shorter, by moving it into buffer, and merging backwards.
+		* Gallops when one side keeps winning.
+		*/
+		template <typename T, typename Buffer, typename Compare>
+		void merge_hi(T begin, T mid, T end, Buffer& buffer, Compare comp)
 		{
-			// copy the remaining of rCpy
-			while (rIter != rEnd)
+			buffer.resize(end - mid); // does nothing if it is large enough, as it should be
+			for (T i = mid; i != end; ++i) buffer.emplace_back(std::move(*i));
+
+			// l and r are one past the next elements to be merged
+			auto r_begin = buffer.begin(), r = buffer.end();
+			T l = mid, out = end;
+			size_t l_wins = 0, r_wins = 0;
+
+			while (l != begin && r != r_begin)
 			{
-				*i = *rIter;
-				++i;
-				++rIter;
+				// ties are won by the right, which goes last, keeping the merge stable
+				if (comp(*(r - 1), *(l - 1))) { *--out = std::move(*--l); ++l_wins; r_wins = 0; }
+				else { *--out = std::move(*--r); ++r_wins; l_wins = 0; }
+
+				if (l_wins >= min_gallop && l != begin && r != r_begin)
+				{
+					// move all left elements that are greater than *(r - 1) at once
+					const auto& key = *(r - 1);
+					T stop = gallop(begin, l, [&](const auto& e) { return !comp(key, e); }, true);
+					while (l != stop) *--out = std::move(*--l);
+					l_wins = 0;
+				}
+				else if (r_wins >= min_gallop && l != begin && r != r_begin)
+				{
+					// move all right elements that are not less than *(l - 1) at once
+					const auto& key = *(l - 1);
+					auto stop = gallop(r_begin, r, [&](const auto& e) { return comp(e, key); }, true);
+					while (r != stop) *--out = std::move(*--r);
+					r_wins = 0;
+				}
 			}
+
+			// the rest of the left run is already in place
+			while (r != r_begin) *--out = std::move(*--r);
+			buffer.clear();
+		}
+
+		/*
+		* Stably merges the sorted [begin, mid) and [mid, end) using buffer,
+		* which is empty and has a capacity of at least the length of the shorter run
+		*/
+		template <typename T, typename Buffer, typename Compare>
+		void merge_runs(T begin, T mid, T end, Buffer& buffer, Compare comp)
+		{
+			if (begin == mid || mid == end || !comp(*mid, *(mid - 1))) return; // already in order
+
+			// the left elements not greater than the first right one, and the right elements not less than the last left one, are in place
+			const auto& first_right = *mid;
+			begin = gallop(begin, mid, [&](const auto& e) { return !comp(first_right, e); }, false);
+			const auto& last_left = *(mid - 1);
+			end = gallop(mid, end, [&](const auto& e) { return comp(e, last_left); }, true);
+
+			if (mid - begin <= end - mid) merge_lo(begin, mid, end, buffer, comp);
+			else merge_hi(begin, mid, end, buffer, comp);
 		}
-		else // rCpy is empty
+
+		template <typename T, typename Buffer, typename Compare>
+		void merge_sort(T begin, T end, Buffer& buffer, Compare comp)
 		{
-			// copy the remaining of lCpy
-			while (lIter != lEnd)
+			constexpr bool network = use_sorting_network<T, Compare, true>::value;
+			if (network && end - begin <= merge_sort_network_threshold)
 			{
-				*i = *lIter;
-				++i;
-				++lIter;
+				sort_by_network<Compare>(begin, end, std::integral_constant<bool, network>());
+				return;
 			}
+			if (end - begin <= merge_sort_insertion_threshold)
+			{
+				insertion_sort_moves(begin, end, comp);
+				return;
+			}
+
+			T mid = begin + (end - begin) / 2;
+			merge_sort(begin, mid, buffer, comp);
+			merge_sort(mid, end, buffer, comp);
+			merge_runs(begin, mid, end, buffer, comp);
+		}
+
+		template <typename T, typename Key>
+		void radix_sort(T begin, T end, Key key, bool b_descending);
+
+		template <typename T, typename Key>
+		void indirect_radix_sort(T begin, T end, Key key, bool b_descending);
+
+		// elements of at least this size are sorted by key through argsort, which moves them once, instead of radix_sort, which moves them once per pass
+		constexpr size_t indirect_sort_min_bytes = 128;
+
+		// radix sorts [begin, end) by key, directly or (for large elements, the last parameter) indirectly
+		template <typename T, typename Key>
+		void radix_sort(T begin, T end, Key key, bool b_descending, std::false_type)
+		{
+			radix_sort(begin, end, key, b_descending);
+		}
+
+		template <typename T, typename Key>
+		void radix_sort(T begin, T end, Key key, bool b_descending, std::true_type)
+		{
+			indirect_radix_sort(begin, end, key, b_descending);
+		}
+
+		// merge sorts [begin, mid) and [mid, end) by comp, and merges them
+		template <typename T, typename Compare, typename Proj>
+		void merge_sort(T begin, T mid, T end, Compare comp, Proj, std::false_type)
+		{
+			const ptrdiff_t l_size = mid - begin, r_size = end - mid;
+			const ptrdiff_t larger = l_size > r_size ? l_size : r_size, shorter = l_size > r_size ? r_size : l_size;
+
+			// the merges of each side take up to half of it, and the final merge takes the shorter side
+			ghl::vector<std::remove_reference_t<decltype(*begin)>> buffer(shorter > larger / 2 + 1 ? shorter : larger / 2 + 1);
+			merge_sort(begin, mid, buffer, comp);
+			merge_sort(mid, end, buffer, comp);
+			merge_runs(begin, mid, end, buffer, comp);
+		}
+
+		/*
+		* Radix sorts [begin, end) by the arithmetic keys proj yields, which gives the same order as merge sorting them, as both are stable.
+		* Large elements are radix sorted indirectly, by their keys and indices.
+		*/
+		template <typename T, typename Compare, typename Proj>
+		void merge_sort(T begin, T, T end, Compare, Proj proj, std::true_type)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			auto key = [proj](const value_t& x) { return project(proj, x); };
+			radix_sort(begin, end, key, comparison_traits<Compare, value_t>::order < 0, std::integral_constant<bool, sizeof(value_t) >= indirect_sort_min_bytes>());
 		}
 	}
 
 	/*
-	* Recursively merge sorts two consecutive sublists in ascending order.
-	* The two sublists are [begin, mid) and [mid, end), respectively.
+	* Stably merges two sorted consecutive sublists [begin, mid) and [mid, end) in place,
+	* moving the shorter one into a buffer (the only allocation), and galloping when one of them keeps winning.
 	*
-	* If any of the sublist's size is 1 (i.e. < 2), then the sublist is trivially sorted, and that's when the recursion ends.
-	* 
 	* Requirements:
 	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
-	* 2. the type of the object must have an operator<
-	* 3. the type of the object must be Cpp17CopyConstructible, Cpp17CopyAssignable, Cpp17MoveConstructible (required by ghl::vector)
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
 	*/
-	template <typename T>
-	void merge_sort(T begin, T mid, T end)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void merge(T begin, T mid, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		const ptrdiff_t shorter = (mid - begin < end - mid) ? mid - begin : end - mid;
+		ghl::vector<std::remove_reference_t<decltype(*begin)>> buffer(shorter);
+		detail::merge_runs(begin, mid, end, buffer, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Merge sorts two consecutive sublists [begin, mid) and [mid, end) in ascending order, and then merges them.
+	*
+	* Top-down, with ranges of at most 32 elements insertion sorted. All merges share one buffer of half the size of the list,
+	* which is allocated once, and elements are moved instead of copied.
+	* Merging is skipped when the two halves are already in order, and gallops on long runs (as in TimSort),
+	* which makes presorted input much faster.
+	* Records sorted by a key radix_sort takes (proj is not the identity, see the top of this file) are radix sorted instead, with a buffer of n elements,
+	* or if they take 128 bytes or more, their keys and indices are, and then the records are moved into place once (see indirect_sort).
+	*
+	* Stable. O(n log n)
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void merge_sort(T begin, T mid, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		auto before = detail::make_comparison(comp, proj);
+		using traits = detail::comparison_traits<decltype(before), std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>>;
+		detail::merge_sort(begin, mid, end, before, proj, std::integral_constant<bool, traits::projected && traits::radix>());
+	}
+
+	/*
+	* Overloading to merge_sort,
+	* equivalent to merge_sort(list.begin(), list.begin() + (list.end() - list.begin()) / 2, list.end(), comp, proj)
+	* iff list.end() - list.begin() >= 2
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void merge_sort(T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		if (list.end() - list.begin() >= 2)
+		{
+			merge_sort(list.begin(), list.begin() + (list.end() - list.begin()) / 2, list.end(), comp, proj);
+		}
+	}
+
+	namespace detail
 	{
-		auto lSize = mid - begin, rSize = end - mid;
-		if (lSize >= 2)
+		// the shortest run that natural_merge_sort merges, shorter ones being extended by binary insertion (the minrun of TimSort)
+		constexpr ptrdiff_t natural_merge_min_run = 32;
+
+		/*
+		* @returns the length that natural_merge_sort extends the runs of n elements to:
+		* n itself if n < 64, and otherwise a length in [32, 64] such that n / result is a power of 2, or slightly less than one,
+		* so that runs of that length merge in balanced pairs
+		*/
+		inline ptrdiff_t natural_merge_min_run_of(ptrdiff_t n)
+		{
+			ptrdiff_t odd = 0; // becomes 1 if any bit shifted out is 1
+			while (n >= 2 * natural_merge_min_run)
+			{
+				odd |= n & 1;
+				n >>= 1;
+			}
+			return n + odd;
+		}
+
+		/*
+		* Insertion sorts [begin, end), whose prefix [begin, sorted_end) is already sorted, finding where every element goes by binary search.
+		* Each element goes after the elements equal to it, which keeps it stable. O(n log n) comparisons, O(n^2) moves
+		*/
+		template <typename T, typename Compare>
+		void binary_insertion_sort(T begin, T sorted_end, T end, Compare comp)
 		{
-			// if lSize is even, then the two are evenly divided
-			// otherwise, left sublist is one element less than right
-			merge_sort(begin, begin + lSize / 2, mid);
+			for (T cur = sorted_end; cur != end; ++cur)
+			{
+				// the first element greater than *cur
+				T lo = begin, hi = cur;
+				while (lo < hi)
+				{
+					T m = lo + (hi - lo) / 2;
+					if (comp(*cur, *m)) hi = m;
+					else lo = m + 1;
+				}
+				if (lo == cur) continue;
+
+				auto tmp = std::move(*cur);
+				for (T i = cur; i != lo; --i) *i = std::move(*(i - 1));
+				*lo = std::move(tmp);
+			}
 		}
-		if (rSize >= 2)
+
+		/*
+		* @returns the end of the run that starts at begin: the longest non-descending prefix of [begin, end),
+		* or the longest strictly descending one, which is reversed (it has no equal elements, so reversing it keeps the sort stable)
+		*/
+		template <typename T, typename Compare>
+		T count_run(T begin, T end, Compare comp)
 		{
-			// if rSize is even, then the two are evenly divided
-			// otherwise, left sublist is one element less than right
-			merge_sort(mid, mid + rSize / 2, end);
+			T run_end = begin + 1;
+			if (run_end == end) return end;
+
+			if (comp(*run_end, *begin))
+			{
+				while (++run_end != end && comp(*run_end, *(run_end - 1)));
+				std::reverse(begin, run_end);
+			}
+			else
+			{
+				while (++run_end != end && !comp(*run_end, *(run_end - 1)));
+			}
+			return run_end;
 		}
 
-		merge(begin, mid, end);
+		template <typename T, typename Compare>
+		void natural_merge_sort(T begin, T end, Compare comp)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+
+			const ptrdiff_t n = end - begin;
+			if (n < 2) return;
+			const ptrdiff_t min_run = natural_merge_min_run_of(n);
+
+			struct run
+			{
+				T begin;
+				ptrdiff_t size;
+			};
+			// the runs not merged yet, from the first to the last, whose sizes keep the invariants of TimSort
+			ghl::vector<run> runs(64);
+			ghl::vector<value_t> buffer(n / 2 + 1);
+
+			// merges the runs i and i + 1
+			auto merge_at = [&](size_t i)
+			{
+				const run next = runs[i + 1];
+				merge_runs(runs[i].begin, next.begin, next.begin + next.size, buffer, comp);
+				runs[i].size += next.size;
+				for (size_t j = i + 1; j + 1 < runs.size(); ++j) runs[j] = runs[j + 1];
+				runs.remove_back();
+			};
+
+			for (T cur = begin; cur != end; )
+			{
+				T run_end = count_run(cur, end, comp);
+				if (run_end - cur < min_run)
+				{
+					const T extended = (end - cur <= min_run) ? end : cur + min_run;
+					binary_insertion_sort(cur, run_end, extended, comp);
+					run_end = extended;
+				}
+
+				if (runs.size() == runs.capacity()) runs.resize(2 * runs.capacity());
+				runs.push_back(run{ cur, run_end - cur });
+				cur = run_end;
+
+				// merge until, for the last runs A, B, C: |A| > |B| + |C| and |B| > |C| (with the fix of de Gouw et al.
+				// that also checks the run before A), which keeps the stack O(log n) deep and the merges balanced
+				while (runs.size() > 1)
+				{
+					size_t i = runs.size() - 2;
+					if ((i > 0 && runs[i - 1].size <= runs[i].size + runs[i + 1].size) || (i > 1 && runs[i - 2].size <= runs[i - 1].size + runs[i].size))
+					{
+						if (runs[i - 1].size < runs[i + 1].size) --i;
+					}
+					else if (runs[i].size > runs[i + 1].size)
+					{
+						break;
+					}
+					merge_at(i);
+				}
+			}
+
+			while (runs.size() > 1)
+			{
+				size_t i = runs.size() - 2;
+				if (i > 0 && runs[i - 1].size < runs[i + 1].size) --i;
+				merge_at(i);
+			}
+		}
 	}
 
 	/*
-	* Overloading to merge_sort,
-	* equivalent to merge_sort(list.begin(), list.begin() + (list.end() - list.begin()) / 2, list.end())
-	* iff list.end() - list.begin() >= 2
+	* Adaptive natural merge sort (TimSort):
+	* 1. the list is cut into its natural runs, non-descending or strictly descending (which are reversed),
+	*    and runs shorter than minrun (32 to 64 elements) are extended to it by binary insertion sort
+	* 2. the runs are pushed on a stack and merged while their lengths break the invariants of TimSort,
+	*    which keeps the merges balanced, and merges the rest at the end
+	* 3. the merges skip the prefix and suffix already in place, move the shorter run into a buffer, and gallop when a run keeps winning
+	*
+	* So sorted and reversed lists take n - 1 comparisons and no merge, and lists made of a few sorted runs (e.g. appended logs)
+	* take O(n log(runs)).
+	*
+	* Stable. O(n log n) in the worst case, with a buffer of n / 2 elements.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
 	*/
-	template <typename T>
-	void merge_sort(T& list)
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void natural_merge_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
 	{
-		if (list.end() - list.begin() >= 2)
+		detail::natural_merge_sort(begin, end, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to natural_merge_sort
+	* Equivalent to natural_merge_sort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void natural_merge_sort(T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		natural_merge_sort(list.begin(), list.end(), comp, proj);
+	}
+
+	namespace detail
+	{
+		// ranges smaller than this are insertion sorted by introsort
+		constexpr ptrdiff_t insertion_sort_threshold = 24;
+		// ranges of at most this size are sorted by network_sort in introsort, if use_sorting_network
+		constexpr ptrdiff_t introsort_network_threshold = 64;
+		static_assert(introsort_network_threshold <= (ptrdiff_t)network_max_size<int64_t*>(), "the network has to hold the range");
+		// ranges larger than this take the pivot from the median of 3 medians of 3 (ninther), instead of the median of 3
+		constexpr ptrdiff_t ninther_threshold = 128;
+		// the number of moves after which partial_insertion_sort gives up
+		constexpr size_t partial_insertion_sort_limit = 8;
+		// the number of elements classified at a time by partition_right_branchless
+		constexpr size_t partition_block_size = 64;
+
+		/*
+		* Same as insertion_sort_moves, but assumes that *(begin - 1) is not greater than any element of [begin, end),
+		* so that the inner loop need not check for begin
+		*/
+		template <typename T, typename Compare>
+		void unguarded_insertion_sort(T begin, T end, Compare comp)
+		{
+			if (begin == end) return;
+
+			for (T cur = begin + 1; cur != end; ++cur)
+			{
+				T sift = cur, sift_1 = cur - 1;
+				if (comp(*sift, *sift_1))
+				{
+					auto tmp = std::move(*sift);
+					do { *sift-- = std::move(*sift_1); } while (comp(tmp, *--sift_1));
+					*sift = std::move(tmp);
+				}
+			}
+		}
+
+		/*
+		* Insertion sorts [begin, end), but gives up as soon as more than partial_insertion_sort_limit elements have been moved.
+		*
+		* @returns true iff the range is sorted
+		*/
+		template <typename T, typename Compare>
+		bool partial_insertion_sort(T begin, T end, Compare comp)
+		{
+			if (begin == end) return true;
+
+			size_t moves = 0;
+			for (T cur = begin + 1; cur != end; ++cur)
+			{
+				T sift = cur, sift_1 = cur - 1;
+				if (comp(*sift, *sift_1))
+				{
+					auto tmp = std::move(*sift);
+					do { *sift-- = std::move(*sift_1); } while (sift != begin && comp(tmp, *--sift_1));
+					*sift = std::move(tmp);
+
+					moves += cur - sift;
+					if (moves > partial_insertion_sort_limit) return false;
+				}
+			}
+			return true;
+		}
+
+		// sorts *a, *b
+		template <typename T, typename Compare>
+		void sort2(T a, T b, Compare comp)
+		{
+			if (comp(*b, *a)) std::iter_swap(a, b);
+		}
+
+		// sorts *a, *b, *c
+		template <typename T, typename Compare>
+		void sort3(T a, T b, T c, Compare comp)
+		{
+			sort2(a, b, comp);
+			sort2(b, c, comp);
+			sort2(a, b, comp);
+		}
+
+		/*
+		* Moves *(begin + i) down the max heap [begin, begin + size) until it is not less than its children
+		*/
+		template <typename T, typename Compare>
+		void sift_down(T begin, ptrdiff_t i, ptrdiff_t size, Compare comp)
+		{
+			auto tmp = std::move(*(begin + i));
+			for (ptrdiff_t child = 2 * i + 1; child < size; child = 2 * i + 1)
+			{
+				if (child + 1 < size && comp(*(begin + child), *(begin + (child + 1)))) ++child; // the larger child
+				if (!comp(tmp, *(begin + child))) break;
+
+				*(begin + i) = std::move(*(begin + child));
+				i = child;
+			}
+			*(begin + i) = std::move(tmp);
+		}
+
+		template <typename T, typename Compare>
+		void heap_sort(T begin, T end, Compare comp)
+		{
+			const ptrdiff_t size = end - begin;
+
+			for (ptrdiff_t i = size / 2; i > 0; --i) sift_down(begin, i - 1, size, comp);
+			for (ptrdiff_t last = size - 1; last > 0; --last)
+			{
+				std::iter_swap(begin, begin + last);
+				sift_down(begin, 0, last, comp);
+			}
+		}
+
+		/*
+		* Partitions [begin, end) around the pivot *begin into the elements < pivot, the pivot, and the elements >= pivot.
+		* Assumes that the median of 3 has been taken, so that both scans are stopped by an element on the other side.
+		*
+		* @returns the final position of the pivot, and whether the range was already partitioned (no element was swapped)
+		*/
+		template <typename T, typename Compare>
+		std::pair<T, bool> partition_right(T begin, T end, Compare comp)
+		{
+			auto pivot = std::move(*begin);
+			T first = begin, last = end;
+
+			// find the first element >= pivot, and the last element < pivot
+			while (comp(*++first, pivot));
+			if (first - 1 == begin) while (first < last && !comp(*--last, pivot));
+			else while (!comp(*--last, pivot));
+
+			const bool already_partitioned = first >= last;
+
+			// swap the misplaced pairs
+			while (first < last)
+			{
+				std::iter_swap(first, last);
+				while (comp(*++first, pivot));
+				while (!comp(*--last, pivot));
+			}
+
+			T pivot_pos = first - 1;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return std::make_pair(pivot_pos, already_partitioned);
+		}
+
+		/*
+		* Swaps num pairs of misplaced elements found by partition_right_branchless,
+		* which are first + offsets_l[i] and last - offsets_r[i].
+		* Unless use_swaps, the pairs are rotated in one cycle, which moves each element once instead of three times.
+		*/
+		template <typename T>
+		void swap_offsets(T first, T last, const unsigned char* offsets_l, const unsigned char* offsets_r, size_t num, bool use_swaps)
 		{
-			merge_sort(list.begin(), list.begin() + (list.end() - list.begin()) / 2, list.end());
+			if (use_swaps)
+			{
+				// the numbers of misplaced elements on both sides are the same, so the cycle would not be closed
+				for (size_t i = 0; i != num; ++i) std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+			}
+			else if (0 != num)
+			{
+				T l = first + offsets_l[0], r = last - offsets_r[0];
+				auto tmp = std::move(*l);
+				*l = std::move(*r);
+				for (size_t i = 1; i != num; ++i)
+				{
+					l = first + offsets_l[i]; *r = std::move(*l);
+					r = last - offsets_r[i]; *l = std::move(*r);
+				}
+				*r = std::move(tmp);
+			}
 		}
+
+		/*
+		* Same as partition_right, but classifies blocks of elements without branching on the comparisons,
+		* writing the offsets of the misplaced elements into small buffers (as in BlockQuicksort),
+		* which avoids the branch mispredictions of partition_right on random input.
+		*
+		* Only used for arithmetic types with the default comparison, for which comparisons are cheap and have no side effects.
+		*/
+		template <typename T, typename Compare>
+		std::pair<T, bool> partition_right_branchless(T begin, T end, Compare comp)
+		{
+			auto pivot = std::move(*begin);
+			T first = begin, last = end;
+
+			while (comp(*++first, pivot));
+			if (first - 1 == begin) while (first < last && !comp(*--last, pivot));
+			else while (!comp(*--last, pivot));
+
+			const bool already_partitioned = first >= last;
+			if (!already_partitioned)
+			{
+				std::iter_swap(first, last);
+				++first;
+
+				// [first, last) is unknown. The misplaced elements of the left block are offsets_l_base + offsets_l[start_l, start_l + num_l),
+				// and the ones of the right block are offsets_r_base - offsets_r[start_r, start_r + num_r)
+				unsigned char offsets_l[partition_block_size], offsets_r[partition_block_size];
+				T offsets_l_base = first, offsets_r_base = last;
+				size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+				while (first < last)
+				{
+					// fill the empty block(s), splitting the unknown elements if both are empty
+					const size_t num_unknown = last - first;
+					const size_t left_split = 0 == num_l ? (0 == num_r ? num_unknown / 2 : num_unknown) : 0;
+					const size_t right_split = 0 == num_r ? num_unknown - left_split : 0;
+
+					const size_t left_count = left_split < partition_block_size ? left_split : partition_block_size;
+					for (size_t i = 0; i != left_count; ++i)
+					{
+						offsets_l[num_l] = (unsigned char)i;
+						num_l += !comp(*first, pivot);
+						++first;
+					}
+
+					const size_t right_count = right_split < partition_block_size ? right_split : partition_block_size;
+					for (size_t i = 0; i != right_count; ++i)
+					{
+						offsets_r[num_r] = (unsigned char)(i + 1);
+						num_r += comp(*--last, pivot);
+					}
+
+					// swap as many pairs as possible, and start a new block on the side(s) that have run out
+					const size_t num = num_l < num_r ? num_l : num_r;
+					swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, num, num_l == num_r);
+					num_l -= num; num_r -= num;
+					start_l += num; start_r += num;
+					if (0 == num_l) { start_l = 0; offsets_l_base = first; }
+					if (0 == num_r) { start_r = 0; offsets_r_base = last; }
+				}
+
+				// move the misplaced elements that are left to the middle
+				if (0 != num_l)
+				{
+					while (num_l--) std::iter_swap(offsets_l_base + offsets_l[start_l + num_l], --last);
+					first = last;
+				}
+				if (0 != num_r)
+				{
+					while (num_r--) { std::iter_swap(offsets_r_base - offsets_r[start_r + num_r], first); ++first; }
+					last = first;
+				}
+			}
+
+			T pivot_pos = first - 1;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return std::make_pair(pivot_pos, already_partitioned);
+		}
+
+		/*
+		* Partitions [begin, end) around the pivot *begin into the elements <= pivot and the elements > pivot.
+		* Used when the pivot equals an element left of begin, i.e. when there are many equal elements,
+		* which puts all of them in their final places at once.
+		*
+		* @returns the final position of the pivot
+		*/
+		template <typename T, typename Compare>
+		T partition_left(T begin, T end, Compare comp)
+		{
+			auto pivot = std::move(*begin);
+			T first = begin, last = end;
+
+			while (comp(pivot, *--last));
+			if (last + 1 == end) while (first < last && !comp(pivot, *++first));
+			else while (!comp(pivot, *++first));
+
+			while (first < last)
+			{
+				std::iter_swap(first, last);
+				while (comp(pivot, *--last));
+				while (!comp(pivot, *++first));
+			}
+
+			T pivot_pos = last;
+			*begin = std::move(*pivot_pos);
+			*pivot_pos = std::move(pivot);
+			return pivot_pos;
+		}
+
+		/*
+		* Moves the pivot of [begin, end), of at least insertion_sort_threshold elements, to begin:
+		* the median of 3, or the median of 3 medians of 3 (ninther) for large ranges.
+		* The elements it is taken from are sorted in place, so both ends hold an element on each side of it.
+		*/
+		template <typename T, typename Compare>
+		void choose_pivot(T begin, T end, Compare comp)
+		{
+			const ptrdiff_t size = end - begin, half = size / 2;
+			if (size > ninther_threshold)
+			{
+				sort3(begin, begin + half, end - 1, comp);
+				sort3(begin + 1, begin + (half - 1), end - 2, comp);
+				sort3(begin + 2, begin + (half + 1), end - 3, comp);
+				sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+				std::iter_swap(begin, begin + half);
+			}
+			else
+			{
+				sort3(begin + half, begin, end - 1, comp);
+			}
+		}
+
+		/*
+		* The loop of introsort, which recurses into the left part and iterates on the right part.
+		*
+		* @param bad_allowed the number of highly unbalanced partitions allowed before falling back to heap sort
+		* @param leftmost false iff there is an element left of begin that is not greater than any element of the range
+		*/
+		template <bool Branchless, typename T, typename Compare>
+		void introsort_loop(T begin, T end, Compare comp, int bad_allowed, bool leftmost)
+		{
+			constexpr bool network = use_sorting_network<T, Compare, false>::value;
+			while (true)
+			{
+				const ptrdiff_t size = end - begin;
+
+				if (network && size <= introsort_network_threshold)
+				{
+					sort_by_network<Compare>(begin, end, std::integral_constant<bool, network>());
+					return;
+				}
+				if (size < insertion_sort_threshold)
+				{
+					if (leftmost) insertion_sort_moves(begin, end, comp);
+					else unguarded_insertion_sort(begin, end, comp);
+					return;
+				}
+
+				choose_pivot(begin, end, comp);
+
+				// the pivot equals the element left of the range, so no element is less than it:
+				// put all elements equal to it on the left, where they are done
+				if (!leftmost && !comp(*(begin - 1), *begin))
+				{
+					begin = partition_left(begin, end, comp) + 1;
+					continue;
+				}
+
+				auto part = Branchless ? partition_right_branchless(begin, end, comp) : partition_right(begin, end, comp);
+				const T pivot_pos = part.first;
+				const ptrdiff_t l_size = pivot_pos - begin, r_size = end - (pivot_pos + 1);
+
+				if (l_size < size / 8 || r_size < size / 8) // highly unbalanced
+				{
+					if (0 == --bad_allowed)
+					{
+						heap_sort(begin, end, comp);
+						return;
+					}
+
+					// break the patterns that made the pivot bad by swapping some elements of both parts
+					if (l_size >= insertion_sort_threshold)
+					{
+						std::iter_swap(begin, begin + l_size / 4);
+						std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+						if (l_size > ninther_threshold)
+						{
+							std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+							std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+							std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+							std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+						}
+					}
+					if (r_size >= insertion_sort_threshold)
+					{
+						std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+						std::iter_swap(end - 1, end - r_size / 4);
+						if (r_size > ninther_threshold)
+						{
+							std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+							std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+							std::iter_swap(end - 2, end - (1 + r_size / 4));
+							std::iter_swap(end - 3, end - (2 + r_size / 4));
+						}
+					}
+				}
+				else if (part.second && partial_insertion_sort(begin, pivot_pos, comp) && partial_insertion_sort(pivot_pos + 1, end, comp))
+				{
+					// already partitioned and both parts turned out to be (nearly) sorted, which makes sorted input O(n)
+					return;
+				}
+
+				introsort_loop<Branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+				begin = pivot_pos + 1;
+				leftmost = false;
+			}
+		}
+
+		/*
+		* Sorts [begin, end) by comp, using the branchless partition
+		* if the elements are arithmetic and compared by the default comparison
+		*/
+		template <typename T, typename Compare>
+		void introsort(T begin, T end, Compare comp)
+		{
+			const ptrdiff_t size = end - begin;
+			if (size < 2) return;
+
+			// floor(log2(size))
+			int log_size = 0;
+			for (ptrdiff_t s = size; s > 1; s >>= 1) ++log_size;
+
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			constexpr bool branchless = comparison_traits<Compare, value_t>::arithmetic;
+			introsort_loop<branchless>(begin, end, comp, log_size, true);
+		}
+	}
+
+	/*
+	* Sorts by repeatedly moving the maximal element of a max heap built in place to the end of the list.
+	* Not stable. O(n log n) in the worst case without any extra memory.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void heap_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		detail::heap_sort(begin, end, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to heap_sort
+	* Equivalent to heap_sort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void heap_sort(T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		heap_sort(list.begin(), list.end(), comp, proj);
+	}
+
+	/*
+	* Pattern-defeating quicksort (pdqsort), an introsort:
+	* 1. the pivot is the median of 3, or of 3 medians of 3 (ninther) for large ranges
+	* 2. ranges of fewer than 24 elements are insertion sorted
+	* 3. after too many highly unbalanced partitions, the patterns are broken by swapping some elements,
+	*    and heap sort takes over if they keep happening, which bounds the worst case to O(n log n)
+	* 4. many equal elements are put into place at once, and a range that was already partitioned is tried with insertion sort,
+	*    which makes inputs that are sorted, reversed, or have few distinct values O(n)
+	* 5. arithmetic keys compared by < or > are partitioned without branching on the comparisons
+	*
+	* Not stable. O(log n) extra memory (the stack).
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void introsort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		detail::introsort(begin, end, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to introsort
+	* Equivalent to introsort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void introsort(T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		introsort(list.begin(), list.end(), comp, proj);
+	}
+
+	namespace detail
+	{
+		// partial_sort takes the heap only if the sorted prefix is smaller than this fraction of the range, and nth_element and introsort otherwise
+		constexpr ptrdiff_t partial_sort_heap_ratio = 8;
+
+		/*
+		* Sorts the smallest middle - begin elements of [begin, end) into [begin, middle) by keeping them in a max heap:
+		* every later element less than the top of the heap replaces it. O(n log k), and O(n) comparisons if most elements are rejected
+		*/
+		template <typename T, typename Compare>
+		void heap_partial_sort(T begin, T middle, T end, Compare comp)
+		{
+			const ptrdiff_t k = middle - begin;
+			if (0 == k) return;
+
+			for (ptrdiff_t i = k / 2; i > 0; --i) sift_down(begin, i - 1, k, comp);
+			for (T it = middle; it != end; ++it)
+			{
+				if (comp(*it, *begin))
+				{
+					std::iter_swap(it, begin);
+					sift_down(begin, 0, k, comp);
+				}
+			}
+			for (ptrdiff_t last = k - 1; last > 0; --last)
+			{
+				std::iter_swap(begin, begin + last);
+				sift_down(begin, 0, last, comp);
+			}
+		}
+
+		/*
+		* Introselect: the partitioning of introsort, going on only into the part that holds nth.
+		* After log2(n) highly unbalanced partitions, it falls back to heap_partial_sort, which bounds the worst case to O(n log n).
+		*/
+		template <bool Branchless, typename T, typename Compare>
+		void introselect(T begin, T nth, T end, Compare comp)
+		{
+			constexpr bool network = use_sorting_network<T, Compare, false>::value;
+
+			int bad_allowed = 0;
+			for (ptrdiff_t s = end - begin; s > 1; s >>= 1) ++bad_allowed;
+			bool leftmost = true;
+
+			while (true)
+			{
+				const ptrdiff_t size = end - begin;
+
+				if (network && size <= introsort_network_threshold)
+				{
+					sort_by_network<Compare>(begin, end, std::integral_constant<bool, network>());
+					return;
+				}
+				if (size < insertion_sort_threshold)
+				{
+					if (leftmost) insertion_sort_moves(begin, end, comp);
+					else unguarded_insertion_sort(begin, end, comp);
+					return;
+				}
+
+				choose_pivot(begin, end, comp);
+
+				// all elements up to the end of the left part equal the element left of the range
+				if (!leftmost && !comp(*(begin - 1), *begin))
+				{
+					begin = partition_left(begin, end, comp) + 1;
+					if (nth < begin) return;
+					continue;
+				}
+
+				auto part = Branchless ? partition_right_branchless(begin, end, comp) : partition_right(begin, end, comp);
+				const T pivot_pos = part.first;
+				const ptrdiff_t l_size = pivot_pos - begin, r_size = end - (pivot_pos + 1);
+
+				if (pivot_pos == nth) return;
+				if ((l_size < size / 8 || r_size < size / 8) && 0 == --bad_allowed)
+				{
+					if (nth < pivot_pos) heap_partial_sort(begin, nth + 1, pivot_pos, comp);
+					else heap_partial_sort(pivot_pos + 1, nth + 1, end, comp);
+					return;
+				}
+
+				if (nth < pivot_pos)
+				{
+					end = pivot_pos;
+				}
+				else
+				{
+					begin = pivot_pos + 1;
+					leftmost = false;
+				}
+			}
+		}
+
+		template <typename T, typename Compare>
+		void nth_element(T begin, T nth, T end, Compare comp)
+		{
+			if (end - begin < 2 || nth == end) return;
+
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			constexpr bool branchless = comparison_traits<Compare, value_t>::arithmetic;
+			introselect<branchless>(begin, nth, end, comp);
+		}
+
+		template <typename T, typename Compare>
+		void partial_sort(T begin, T middle, T end, Compare comp)
+		{
+			if (middle == begin) return;
+
+			if ((middle - begin) * partial_sort_heap_ratio < end - begin)
+			{
+				heap_partial_sort(begin, middle, end, comp);
+			}
+			else
+			{
+				// O(n + k log k)
+				detail::nth_element(begin, middle, end, comp);
+				introsort(begin, middle, comp);
+			}
+		}
+	}
+
+	/*
+	* Rearranges [begin, end) so that *nth is the element that would be there if the range were sorted,
+	* no element before nth is greater than it, and no element after it is less than it.
+	*
+	* Introselect: quickselect with the pivots of introsort (median of 3, or ninther), which only partitions the part holding nth,
+	* falling back to a heap after too many highly unbalanced partitions. Many equal elements are put into place at once.
+	*
+	* Not stable. O(n) on average, O(n log n) in the worst case, without any extra memory.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void nth_element(T begin, T nth, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		detail::nth_element(begin, nth, end, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to nth_element
+	* Equivalent to nth_element(list.begin(), list.begin() + n, list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void nth_element(T& list, size_t n, Compare comp = Compare(), Proj proj = Proj())
+	{
+		ghl::nth_element(list.begin(), list.begin() + n, list.end(), comp, proj);
+	}
+
+	/*
+	* Sorts the smallest middle - begin elements of [begin, end) into [begin, middle), leaving the rest in [middle, end) in no particular order.
+	* 1. if the prefix is short (less than 1/8 of the range), it is kept in a max heap while the rest of the range is scanned,
+	*    which rejects most elements with a single comparison, and is then heap sorted: O(n log k)
+	* 2. otherwise the range is partitioned by nth_element and the prefix is introsorted: O(n + k log k)
+	*
+	* Not stable. No extra memory besides the stack of introsort.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void partial_sort(T begin, T middle, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		detail::partial_sort(begin, middle, end, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to partial_sort
+	* Equivalent to partial_sort(list.begin(), list.begin() + k, list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void partial_sort(T& list, size_t k, Compare comp = Compare(), Proj proj = Proj())
+	{
+		ghl::partial_sort(list.begin(), list.begin() + k, list.end(), comp, proj);
+	}
+
+	namespace detail
+	{
+		// reverses the order of a comparison
+		template <typename Compare>
+		struct reverse_comparison
+		{
+			Compare comp;
+
+			template <typename A, typename B>
+			bool operator()(const A& a, const B& b) const { return comp(b, a); }
+		};
+
+		// @returns the first element of [begin, end) that goes after threshold by comp
+		template <typename T, typename V, typename Compare>
+		T find_after(T begin, T end, const V& threshold, Compare comp)
+		{
+			while (begin != end && !comp(threshold, *begin)) ++begin;
+			return begin;
+		}
+
+		/*
+		* Overloads of find_after for arrays of arithmetic keys compared by operator<,
+		* which compare a vector of keys at a time with the threshold, and stop at the first vector that has a key greater than it.
+		* NaNs are skipped, as by the scalar version.
+		*/
+#ifdef GHL_SSE2
+		inline const float* find_after(const float* begin, const float* end, const float& threshold, less comp)
+		{
+#ifdef GHL_AVX2
+			const __m256 t8 = _mm256_set1_ps(threshold);
+			while (end - begin >= 8 && 0 == _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(begin), t8, _CMP_GT_OQ))) begin += 8;
+#endif
+			const __m128 t = _mm_set1_ps(threshold);
+			while (end - begin >= 4 && 0 == _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(begin), t))) begin += 4;
+			return find_after<const float*>(begin, end, threshold, comp);
+		}
+
+		inline const double* find_after(const double* begin, const double* end, const double& threshold, less comp)
+		{
+#ifdef GHL_AVX2
+			const __m256d t4 = _mm256_set1_pd(threshold);
+			while (end - begin >= 4 && 0 == _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(begin), t4, _CMP_GT_OQ))) begin += 4;
+#endif
+			const __m128d t = _mm_set1_pd(threshold);
+			while (end - begin >= 2 && 0 == _mm_movemask_pd(_mm_cmpgt_pd(_mm_loadu_pd(begin), t))) begin += 2;
+			return find_after<const double*>(begin, end, threshold, comp);
+		}
+
+		inline const int32_t* find_after(const int32_t* begin, const int32_t* end, const int32_t& threshold, less comp)
+		{
+#ifdef GHL_AVX2
+			const __m256i t8 = _mm256_set1_epi32(threshold);
+			while (end - begin >= 8 && 0 == _mm256_movemask_epi8(_mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)begin), t8))) begin += 8;
+#endif
+			const __m128i t = _mm_set1_epi32(threshold);
+			while (end - begin >= 4 && 0 == _mm_movemask_epi8(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)begin), t))) begin += 4;
+			return find_after<const int32_t*>(begin, end, threshold, comp);
+		}
+#endif
+
+#ifdef GHL_AVX2
+		inline const int64_t* find_after(const int64_t* begin, const int64_t* end, const int64_t& threshold, less comp)
+		{
+			const __m256i t = _mm256_set1_epi64x(threshold);
+			while (end - begin >= 4 && 0 == _mm256_movemask_epi8(_mm256_cmpgt_epi64(_mm256_loadu_si256((const __m256i*)begin), t))) begin += 4;
+			return find_after<const int64_t*>(begin, end, threshold, comp);
+		}
+#endif
+	}
+
+	/*
+	* A streaming accumulator of the k greatest elements pushed into it, by comp(proj(a), proj(b)) (operator< by default),
+	* such as the top 100 scores of a stream of millions, in O(k) memory.
+	*
+	* The elements are kept in a min heap, whose top, the least of them, is the threshold that a new element has to beat
+	* once there are k of them. Most elements of a long stream do not, and cost a single comparison.
+	* Arrays of floats, doubles and 32-bit integers (and 64-bit ones with AVX2) compared by operator< (detail::less) are scanned for the next element
+	* that beats the threshold a vector at a time with SSE2/AVX2.
+	*
+	* Ties with the threshold are rejected, so of equal elements the first ones pushed are kept.
+	*
+	* Requirements:
+	* 1. V must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of V
+	*/
+	template <typename V, typename Compare = detail::less, typename Proj = detail::identity>
+	class top_k final
+	{
+	public:
+		explicit top_k(size_t k, Compare comp = Compare(), Proj proj = Proj()) : k(k), heap(k), comp{ detail::make_comparison(comp, proj) } {}
+
+	public:
+		void push(const V& x)
+		{
+			if (0 == k) return;
+
+			if (heap.size() < k)
+			{
+				heap.push_back(x);
+				if (heap.size() == k)
+				{
+					for (size_t i = k / 2; i > 0; --i) detail::sift_down(heap.begin(), (ptrdiff_t)i - 1, (ptrdiff_t)k, comp);
+				}
+			}
+			else if (comp.comp(heap[0], x))
+			{
+				heap[0] = x;
+				detail::sift_down(heap.begin(), 0, (ptrdiff_t)k, comp);
+			}
+		}
+
+		/*
+		* Pushes the elements of [begin, end)
+		*
+		* Requirements:
+		* 1. T is a LegacyInputIterator whose elements convert to V
+		*/
+		template <typename T>
+		void push(T begin, T end)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			push_range(begin, end, std::integral_constant<bool, std::is_pointer<T>::value && std::is_same<value_t, V>::value>());
+		}
+
+		// the number of elements kept, which is k once k elements have been pushed
+		size_t size() const { return heap.size(); }
+
+		// the least element kept, which a new element has to beat once size() == k. Requires size() != 0
+		const V& threshold() const { return heap[0]; }
+
+		// @returns the elements kept, from the greatest to the least
+		ghl::vector<V> sorted() const
+		{
+			ghl::vector<V> res(heap);
+			detail::heap_sort(res.begin(), res.end(), comp);
+			return res;
+		}
+
+		void clear()
+		{
+			while (!heap.empty()) heap.remove_back();
+		}
+
+	private:
+		template <typename T>
+		void push_range(T begin, T end, std::false_type)
+		{
+			for (; begin != end; ++begin) push(*begin);
+		}
+
+		// skips the elements that do not beat the threshold by find_after, which has vectorized overloads
+		template <typename T>
+		void push_range(T begin, T end, std::true_type)
+		{
+			const V* first = begin;
+			const V* last = end;
+			while (first != last && heap.size() < k) push(*first++);
+			while (0 != k && first != last)
+			{
+				first = detail::find_after(first, last, heap[0], comp.comp);
+				if (first == last) break;
+				push(*first++);
+			}
+		}
+
+	private:
+		size_t k;
+		// a heap of the elements kept, once it has k of them, whose top is the least
+		ghl::vector<V> heap;
+		detail::reverse_comparison<decltype(detail::make_comparison(std::declval<Compare>(), std::declval<Proj>()))> comp;
+	};
+
+	namespace detail
+	{
+		/*
+		* @returns the number of elements of a[0, m) among the first k elements of the stable merge of a[0, m) and b[0, n) (ties are taken from a),
+		* by binary search. The rest of the k elements are b[0, k - result).
+		*/
+		template <typename A, typename B, typename Compare>
+		ptrdiff_t co_rank(ptrdiff_t k, A a, ptrdiff_t m, B b, ptrdiff_t n, Compare comp)
+		{
+			ptrdiff_t lo = k > n ? k - n : 0, hi = k < m ? k : m;
+			while (lo < hi)
+			{
+				const ptrdiff_t i = lo + (hi - lo) / 2, j = k - i;
+				// a[i] is not greater than b[j - 1], so it is among the first k as well
+				if (j > 0 && !comp(*(b + (j - 1)), *(a + i))) lo = i + 1;
+				else hi = i;
+			}
+			return lo;
+		}
+
+		/*
+		* Stably merges [a, a + m) and [b, b + n) into out by moving, in parallel:
+		* the output is cut into blocks of grain elements, and the inputs of each block are found by co_rank.
+		* All blocks are co-ranked before any element is moved, and each block only reads its own inputs,
+		* as the others may have been moved from already.
+		*/
+		template <typename T, typename U, typename Compare>
+		void parallel_merge(T a, ptrdiff_t m, T b, ptrdiff_t n, U out, thread_pool& pool, size_t grain, Compare comp)
+		{
+			const size_t total = (size_t)(m + n);
+			const size_t num_blocks = (total + grain - 1) / grain;
+			ghl::vector<ptrdiff_t> ranks(num_blocks + 1); // ranks[block] = co_rank(block * grain)
+			ranks.increase_size(num_blocks + 1);
+			ranks[num_blocks] = m;
+			pool.parallel_for(0, num_blocks, 64, [&](size_t lo, size_t hi)
+			{
+				for (size_t block = lo; block != hi; ++block) ranks[block] = co_rank((ptrdiff_t)(block * grain), a, m, b, n, comp);
+			});
+
+			pool.parallel_for(0, num_blocks, 1, [&](size_t lo, size_t hi)
+			{
+				for (size_t block = lo; block != hi; ++block)
+				{
+					const size_t first = block * grain, last = block + 1 == num_blocks ? total : first + grain;
+					ptrdiff_t i = ranks[block], j = (ptrdiff_t)first - i;
+					const ptrdiff_t i_end = ranks[block + 1], j_end = (ptrdiff_t)last - i_end;
+					for (size_t k = first; k != last; ++k)
+					{
+						if (j == j_end || (i != i_end && !comp(*(b + j), *(a + i)))) *(out + k) = std::move(*(a + i++));
+						else *(out + k) = std::move(*(b + j++));
+					}
+				}
+			});
+		}
+
+		/*
+		* Sorts the n elements of src, leaving the result in dst if b_to_dst, or in src otherwise.
+		* The halves are sorted in parallel into the other array, and then merged back in parallel.
+		*/
+		template <typename T, typename U, typename Compare>
+		void parallel_merge_sort(T src, U dst, ptrdiff_t n, bool b_to_dst, thread_pool& pool, size_t grain, Compare comp)
+		{
+			if ((size_t)n <= grain)
+			{
+				ghl::vector<std::remove_reference_t<decltype(*src)>> buffer(n / 2 + 1);
+				merge_sort(src, src + n, buffer, comp);
+				if (b_to_dst)
+				{
+					for (ptrdiff_t i = 0; i != n; ++i) *(dst + i) = std::move(*(src + i));
+				}
+				return;
+			}
+
+			const ptrdiff_t half = n / 2;
+			{
+				task_group group(pool);
+				group.run([=, &pool]() { parallel_merge_sort(src, dst, half, !b_to_dst, pool, grain, comp); });
+				parallel_merge_sort(src + half, dst + half, n - half, !b_to_dst, pool, grain, comp);
+				group.wait();
+			}
+
+			if (b_to_dst) parallel_merge(src, half, src + half, n - half, dst, pool, grain, comp);
+			else parallel_merge(dst, half, dst + half, n - half, src, pool, grain, comp);
+		}
+
+		template <typename T, typename Compare>
+		void parallel_sample_sort(T begin, T end, thread_pool& pool, size_t grain, Compare comp)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+
+			const size_t n = end - begin;
+			if (n <= grain)
+			{
+				introsort(begin, end, comp);
+				return;
+			}
+
+			// a few buckets per thread, so that uneven buckets are balanced out, but none smaller than grain
+			size_t num_buckets = 4 * pool.num_threads();
+			if (num_buckets > n / grain) num_buckets = n / grain;
+			if (num_buckets < 2) num_buckets = 2;
+
+			// pick num_buckets - 1 splitters from a sorted sample that is evenly spread over the input
+			const size_t oversampling = 32;
+			const size_t num_samples = num_buckets * oversampling;
+			ghl::vector<value_t> samples(num_samples);
+			for (size_t i = 0; i != num_samples; ++i) samples.push_back(*(begin + (i * n / num_samples)));
+			introsort(samples.begin(), samples.end(), comp);
+			ghl::vector<value_t> splitters(num_buckets - 1);
+			for (size_t b = 1; b != num_buckets; ++b) splitters.push_back(samples[b * oversampling]);
+
+			// the bucket of an element is the number of splitters not greater than it,
+			// so the elements equal to a splitter all go to the same bucket
+			auto bucket_of = [&](const value_t& x)
+			{
+				size_t lo = 0, hi = splitters.size();
+				while (lo < hi)
+				{
+					const size_t m = lo + (hi - lo) / 2;
+					if (comp(x, splitters[m])) hi = m;
+					else lo = m + 1;
+				}
+				return lo;
+			};
+
+			// count the elements of each bucket in each block of the input, where counts[block * num_buckets + bucket]
+			const size_t num_blocks = (n + grain - 1) / grain;
+			ghl::vector<size_t> counts(num_blocks * num_buckets);
+			for (size_t i = 0; i != num_blocks * num_buckets; ++i) counts.push_back(0);
+			pool.parallel_for(0, num_blocks, 1, [&](size_t lo, size_t hi)
+			{
+				for (size_t block = lo; block != hi; ++block)
+				{
+					const size_t last = (block + 1) * grain < n ? (block + 1) * grain : n;
+					for (size_t i = block * grain; i != last; ++i) ++counts[block * num_buckets + bucket_of(*(begin + i))];
+				}
+			});
+
+			// turn the counts into the positions where the blocks write their elements of each bucket, in the order of buckets and then blocks
+			ghl::vector<size_t> bucket_starts(num_buckets + 1);
+			{
+				size_t sum = 0;
+				for (size_t b = 0; b != num_buckets; ++b)
+				{
+					bucket_starts.push_back(sum);
+					for (size_t block = 0; block != num_blocks; ++block)
+					{
+						const size_t count = counts[block * num_buckets + b];
+						counts[block * num_buckets + b] = sum;
+						sum += count;
+					}
+				}
+				bucket_starts.push_back(sum);
+			}
+
+			// distribute the elements into the buckets, moving them into a buffer, where every slot is constructed exactly once
+			ghl::vector<value_t> buffer(n);
+			pool.parallel_for(0, num_blocks, 1, [&](size_t lo, size_t hi)
+			{
+				for (size_t block = lo; block != hi; ++block)
+				{
+					const size_t last = (block + 1) * grain < n ? (block + 1) * grain : n;
+					for (size_t i = block * grain; i != last; ++i)
+					{
+						value_t& x = *(begin + i);
+						new (buffer.begin() + counts[block * num_buckets + bucket_of(x)]++) value_t(std::move(x));
+					}
+				}
+			});
+			buffer.increase_size(n);
+
+			// sort each bucket, and move it back
+			pool.parallel_for(0, num_buckets, 1, [&](size_t lo, size_t hi)
+			{
+				for (size_t b = lo; b != hi; ++b)
+				{
+					introsort(buffer.begin() + bucket_starts[b], buffer.begin() + bucket_starts[b + 1], comp);
+					for (size_t i = bucket_starts[b]; i != bucket_starts[b + 1]; ++i) *(begin + i) = std::move(buffer[i]);
+				}
+			});
+		}
+	}
+
+	/*
+	* Merge sorts the list in parallel on pool: the halves are sorted in parallel (fork-join),
+	* and are merged in parallel by cutting the output into blocks whose inputs are found by binary search (co-ranking).
+	* Ranges of at most grain elements are sorted by the sequential merge_sort.
+	*
+	* Stable. O(n log n) work, with an extra buffer of n elements.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void parallel_merge_sort(T begin, T end, thread_pool& pool, size_t grain = 1 << 14, Compare comp = Compare(), Proj proj = Proj())
+	{
+		using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+
+		const ptrdiff_t n = end - begin;
+		if (n < 2) return;
+		if (grain < 2) grain = 2;
+
+		// move the elements into a buffer, from which they are sorted back
+		ghl::vector<value_t> buffer(n);
+		pool.parallel_for(0, (size_t)n, grain, [&](size_t lo, size_t hi)
+		{
+			for (size_t i = lo; i != hi; ++i) new (buffer.begin() + i) value_t(std::move(*(begin + i)));
+		});
+		buffer.increase_size(n);
+
+		detail::parallel_merge_sort(buffer.begin(), begin, n, true, pool, grain, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to parallel_merge_sort
+	* Equivalent to parallel_merge_sort(list.begin(), list.end(), pool, grain, comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void parallel_merge_sort(T& list, thread_pool& pool, size_t grain = 1 << 14, Compare comp = Compare(), Proj proj = Proj())
+	{
+		parallel_merge_sort(list.begin(), list.end(), pool, grain, comp, proj);
+	}
+
+	/*
+	* Sample sorts the list in parallel on pool:
+	* 1. splitters are picked from a sorted sample of the list, which cut it into a few buckets per thread
+	* 2. blocks of grain elements count their elements of each bucket in parallel,
+	*    and then move them in parallel into a buffer where the buckets are consecutive
+	* 3. the buckets are sorted by introsort in parallel, and moved back
+	*
+	* Moves every element only twice, compared to log(n / grain) times by parallel_merge_sort.
+	* Elements equal to a splitter go to one bucket, so a list of very few distinct values gets little parallelism.
+	*
+	* Not stable. O(n log n) work, with an extra buffer of n elements.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void parallel_sample_sort(T begin, T end, thread_pool& pool, size_t grain = 1 << 14, Compare comp = Compare(), Proj proj = Proj())
+	{
+		if (grain < 1) grain = 1;
+		detail::parallel_sample_sort(begin, end, pool, grain, detail::make_comparison(comp, proj));
+	}
+
+	/*
+	* Overloading to parallel_sample_sort
+	* Equivalent to parallel_sample_sort(list.begin(), list.end(), pool, grain, comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void parallel_sample_sort(T& list, thread_pool& pool, size_t grain = 1 << 14, Compare comp = Compare(), Proj proj = Proj())
+	{
+		parallel_sample_sort(list.begin(), list.end(), pool, grain, comp, proj);
+	}
+
+	namespace detail
+	{
+		/*
+		* Maps arithmetic keys to unsigned integers of the same size, whose order as unsigned integers is the order of the keys.
+		* Signed integers get their sign bit flipped. Floats get all bits flipped if negative, and only the sign bit otherwise,
+		* so NaNs come after +inf (or before -inf if negative). -0 is mapped as +0, as they compare equal,
+		* so that the sorts by radix_sort keep them in order like the stable sorts by comparisons.
+		*/
+		template <typename K, bool = std::is_integral<K>::value>
+		struct radix_key_traits
+		{
+			using bits_t = std::make_unsigned_t<K>;
+
+			static bits_t to_bits(K key)
+			{
+				return std::is_signed<K>::value ? (bits_t)((bits_t)key ^ ((bits_t)1 << (8 * sizeof(K) - 1))) : (bits_t)key;
+			}
+		};
+
+		template <>
+		struct radix_key_traits<float, false>
+		{
+			using bits_t = uint32_t;
+
+			static bits_t to_bits(float key)
+			{
+				if (0.0f == key) key = 0.0f;
+				bits_t b;
+				std::memcpy(&b, &key, sizeof(b));
+				return b ^ ((bits_t)(-(int32_t)(b >> 31)) | 0x80000000u);
+			}
+		};
+
+		template <>
+		struct radix_key_traits<double, false>
+		{
+			using bits_t = uint64_t;
+
+			static bits_t to_bits(double key)
+			{
+				if (0.0 == key) key = 0.0;
+				bits_t b;
+				std::memcpy(&b, &key, sizeof(b));
+				return b ^ ((bits_t)(-(int64_t)(b >> 63)) | 0x8000000000000000ull);
+			}
+		};
+
+		// ranges smaller than this are merge sorted by radix_sort, where clearing the counts would cost more than sorting
+		constexpr size_t radix_sort_threshold = 256;
+
+		/*
+		* @returns the number of bits of the digits of radix_sort for n keys of key_bits bits:
+		* 8 bits (whose counts fit in L1) for short lists, 11 bits (3 passes) for 32-bit keys,
+		* and 16 bits (4 passes) for long lists of 64-bit keys, where the counts are amortized over enough elements
+		*/
+		inline unsigned radix_digit_bits(unsigned key_bits, size_t n)
+		{
+			if (key_bits <= 8 || n < ((size_t)1 << 16)) return 8;
+			if (key_bits <= 16) return 16;
+			if (key_bits <= 32 || n < ((size_t)1 << 22)) return 11;
+			return 16;
+		}
+
+		// ranges smaller than this are insertion sorted by american_flag_sort
+		constexpr ptrdiff_t american_flag_insertion_threshold = 32;
+
+		// @returns the bucket of s at depth: 0 if s is shorter than depth + 1, and 1 + its char at depth otherwise
+		template <typename S>
+		size_t flag_digit(const S& s, size_t depth)
+		{
+			return depth < (size_t)s.size() ? 1 + (size_t)(unsigned char)s[depth] : 0;
+		}
+
+		// @returns true iff the suffix of a from depth is less than that of b, where chars are compared as unsigned
+		template <typename S>
+		bool suffix_less(const S& a, const S& b, size_t depth)
+		{
+			const size_t na = a.size(), nb = b.size();
+			for (size_t i = depth; ; ++i)
+			{
+				if (i == nb) return false;
+				if (i == na) return true;
+				const unsigned char ca = (unsigned char)a[i], cb = (unsigned char)b[i];
+				if (ca != cb) return ca < cb;
+			}
+		}
+	}
+
+	namespace detail
+	{
+		// radix_sort, in descending order of the keys if b_descending
+		template <typename T, typename Key>
+		void radix_sort(T begin, T end, Key key, bool b_descending)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			using key_t = std::remove_cv_t<std::remove_reference_t<decltype(key(*begin))>>;
+			using traits = detail::radix_key_traits<key_t>;
+			using bits_t = typename traits::bits_t;
+
+			// descending keys have their bits flipped
+			const bits_t flip = b_descending ? (bits_t)~(bits_t)0 : (bits_t)0;
+			auto bits_of = [&key, flip](const value_t& x) { return (bits_t)(traits::to_bits(key(x)) ^ flip); };
+
+			const size_t n = end - begin;
+			if (n < 2) return;
+			if (n < radix_sort_threshold)
+			{
+				ghl::vector<value_t> buffer(n / 2 + 1);
+				merge_sort(begin, end, buffer, [&bits_of](const value_t& a, const value_t& b) { return bits_of(a) < bits_of(b); });
+				return;
+			}
+
+			const unsigned key_bits = 8 * sizeof(bits_t);
+			const unsigned digit_bits = radix_digit_bits(key_bits, n);
+			const unsigned num_passes = (key_bits + digit_bits - 1) / digit_bits;
+			const size_t radix = (size_t)1 << digit_bits, mask = radix - 1;
+
+			// counts[pass * radix + digit]
+			ghl::vector<size_t> counts(num_passes * radix);
+			for (size_t i = 0; i != num_passes * radix; ++i) counts.push_back(0);
+			for (T it = begin; it != end; ++it)
+			{
+				const bits_t b = bits_of(*it);
+				for (unsigned pass = 0; pass != num_passes; ++pass) ++counts[pass * radix + (size_t)((b >> (pass * digit_bits)) & mask)];
+			}
+
+			ghl::vector<value_t> buffer(n);
+			bool b_in_buffer = false;
+			for (unsigned pass = 0; pass != num_passes; ++pass)
+			{
+				size_t* next = counts.begin() + pass * radix;
+				const unsigned shift = pass * digit_bits;
+				auto digit_of = [&](const value_t& x) { return (size_t)((bits_of(x) >> shift) & mask); };
+
+				if (n == next[digit_of(b_in_buffer ? buffer[0] : *begin)]) continue; // all elements have the same digit
+
+				// where the elements of each digit go
+				size_t sum = 0;
+				for (size_t d = 0; d != radix; ++d)
+				{
+					const size_t count = next[d];
+					next[d] = sum;
+					sum += count;
+				}
+
+				if (b_in_buffer)
+				{
+					for (value_t* it = buffer.begin(); it != buffer.end(); ++it) *(begin + next[digit_of(*it)]++) = std::move(*it);
+				}
+				else if (buffer.empty())
+				{
+					// the first pass constructs every slot of the buffer exactly once
+					for (T it = begin; it != end; ++it) new (buffer.begin() + next[digit_of(*it)]++) value_t(std::move(*it));
+					buffer.increase_size(n);
+				}
+				else
+				{
+					for (T it = begin; it != end; ++it) buffer[next[digit_of(*it)]++] = std::move(*it);
+				}
+				b_in_buffer = !b_in_buffer;
+			}
+
+			if (b_in_buffer)
+			{
+				for (size_t i = 0; i != n; ++i) *(begin + i) = std::move(buffer[i]);
+			}
+		}
+	}
+
+	/*
+	* LSD radix sort by key(element), which is an integer, a float or a double:
+	* the keys are mapped to unsigned integers that sort the same way (see detail::radix_key_traits),
+	* and the elements are distributed by the digits of the keys from the lowest to the highest,
+	* moving between the list and a buffer.
+	*
+	* The counts of all digits are taken in one pass over the list, and the passes in which all elements have the same digit are skipped,
+	* so keys that only use their low bits take fewer passes. Digits are 8, 11 or 16 bits (see detail::radix_digit_bits).
+	*
+	* Stable. O(n * passes) time, with an extra buffer of n elements. key is called twice per element and pass.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. key(element) returns an arithmetic type (or a reference to one)
+	* 3. the type of the object must be Cpp17CopyConstructible (required by ghl::vector), Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Key>
+	void radix_sort(T begin, T end, Key key)
+	{
+		detail::radix_sort(begin, end, key, false);
+	}
+
+	/*
+	* Overloading to radix_sort, which sorts arithmetic elements by their values
+	* Equivalent to radix_sort(begin, end, [](const auto& x) { return x; });
+	*/
+	template <typename T>
+	void radix_sort(T begin, T end)
+	{
+		radix_sort(begin, end, detail::identity());
+	}
+
+	/*
+	* Overloading to radix_sort
+	* Equivalent to radix_sort(list.begin(), list.end());
+	*/
+	template <typename T>
+	void radix_sort(T& list)
+	{
+		radix_sort(list.begin(), list.end());
+	}
+
+	/*
+	* In-place MSD radix sort (American flag sort) by key(element), which is a string of bytes:
+	* a range is distributed into 257 buckets by the byte at the current depth (the first bucket for the keys that end before it),
+	* by counting the buckets and then swapping every element into its bucket in cycles,
+	* and every bucket of more than one element but the first is sorted the same way one byte deeper.
+	* Ranges of fewer than 32 elements are insertion sorted by the rest of their keys.
+	*
+	* The ranges still to sort are kept on a stack instead of recursing, as keys may be long.
+	* Chars are compared as unsigned, as std::string compares them.
+	*
+	* Not stable. O(total length of the distinguishing prefixes) time, and no extra memory besides the stack of ranges.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. key(element) returns an object s with s.size() and chars s[i] (e.g. std::string, std::string_view, ghl::vector<char>),
+	*    preferably by reference, as it is called for every element at every depth
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable and swappable
+	*/
+	template <typename T, typename Key>
+	void american_flag_sort(T begin, T end, Key key)
+	{
+		using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+
+		struct range
+		{
+			T first, last;
+			size_t depth;
+		};
+
+		ghl::vector<range> stack(64);
+		auto push = [&stack](T first, T last, size_t depth)
+		{
+			if (stack.size() == stack.capacity()) stack.resize(2 * stack.capacity());
+			stack.push_back(range{ first, last, depth });
+		};
+		if (end - begin > 1) push(begin, end, 0);
+
+		size_t next[257], ends[257];
+		while (!stack.empty())
+		{
+			const range r = stack[stack.size() - 1];
+			stack.remove_back();
+			const size_t depth = r.depth;
+
+			if (r.last - r.first < detail::american_flag_insertion_threshold)
+			{
+				detail::insertion_sort_moves(r.first, r.last, [&key, depth](const value_t& a, const value_t& b)
+				{
+					return detail::suffix_less(key(a), key(b), depth);
+				});
+				continue;
+			}
+
+			size_t counts[257] = {};
+			for (T it = r.first; it != r.last; ++it) ++counts[detail::flag_digit(key(*it), depth)];
+
+			// all keys share the byte at depth: look one byte deeper without moving anything
+			const size_t first_digit = detail::flag_digit(key(*r.first), depth);
+			if ((size_t)(r.last - r.first) == counts[first_digit])
+			{
+				if (0 != first_digit) push(r.first, r.last, depth + 1);
+				continue;
+			}
+
+			size_t sum = 0;
+			for (size_t d = 0; d != 257; ++d)
+			{
+				next[d] = sum;
+				sum += counts[d];
+				ends[d] = sum;
+			}
+
+			// swap every element into its bucket, where next[d] is the first position of bucket d that may not hold an element of d yet
+			for (size_t d = 0; d != 257; ++d)
+			{
+				while (next[d] != ends[d])
+				{
+					size_t to = detail::flag_digit(key(*(r.first + next[d])), depth);
+					while (to != d)
+					{
+						std::iter_swap(r.first + next[d], r.first + next[to]++);
+						to = detail::flag_digit(key(*(r.first + next[d])), depth);
+					}
+					++next[d];
+				}
+			}
+
+			// the keys of the first bucket have ended, so they are all equal
+			for (size_t d = 1; d != 257; ++d)
+			{
+				if (counts[d] > 1) push(r.first + (ends[d] - counts[d]), r.first + ends[d], depth + 1);
+			}
+		}
+	}
+
+	/*
+	* Overloading to american_flag_sort, which sorts strings by their chars
+	* Equivalent to american_flag_sort(begin, end, [](const auto& s) -> const auto& { return s; });
+	*/
+	template <typename T>
+	void american_flag_sort(T begin, T end)
+	{
+		american_flag_sort(begin, end, detail::identity());
+	}
+
+	/*
+	* Overloading to american_flag_sort
+	* Equivalent to american_flag_sort(list.begin(), list.end());
+	*/
+	template <typename T>
+	void american_flag_sort(T& list)
+	{
+		american_flag_sort(list.begin(), list.end());
+	}
+
+	namespace detail
+	{
+		// a key of an element, and the index of the element, which argsort sorts instead of the elements
+		template <typename K>
+		struct keyed_index
+		{
+			K key;
+			size_t index;
+		};
+
+		// argsort by a comparison of the elements: stably merge sorts the indices
+		template <typename T, typename Compare, typename Proj>
+		ghl::vector<size_t> argsort(T begin, T end, Compare comp, Proj proj, std::false_type)
+		{
+			const size_t n = end - begin;
+			ghl::vector<size_t> indices(n);
+			for (size_t i = 0; i != n; ++i) indices.push_back(i);
+
+			auto before = make_comparison(comp, proj);
+			ghl::merge_sort(indices, [&](size_t a, size_t b) { return before(*(begin + a), *(begin + b)); });
+			return indices;
+		}
+
+		// @returns the indices of [begin, end) stably sorted by the arithmetic key(element), by radix sorting the (key, index) pairs
+		template <typename T, typename Key>
+		ghl::vector<size_t> radix_argsort(T begin, T end, Key key, bool b_descending)
+		{
+			using key_t = std::remove_cv_t<std::remove_reference_t<decltype(key(*begin))>>;
+
+			const size_t n = end - begin;
+			ghl::vector<keyed_index<key_t>> pairs(n);
+			for (size_t i = 0; i != n; ++i) pairs.push_back(keyed_index<key_t>{ key(*(begin + i)), i });
+			radix_sort(pairs.begin(), pairs.end(), [](const keyed_index<key_t>& p) { return p.key; }, b_descending);
+
+			ghl::vector<size_t> indices(n);
+			for (size_t i = 0; i != n; ++i) indices.push_back(pairs[i].index);
+			return indices;
+		}
+
+		// argsort by the keys radix_sort takes, compared by < or >, which reads every element once
+		template <typename T, typename Compare, typename Proj>
+		ghl::vector<size_t> argsort(T begin, T end, Compare comp, Proj proj, std::true_type)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			using traits = comparison_traits<decltype(make_comparison(comp, proj)), value_t>;
+			return radix_argsort(begin, end, [proj](const value_t& x) { return project(proj, x); }, traits::order < 0);
+		}
+	}
+
+	/*
+	* @returns the permutation that sorts [begin, end) by comp(proj(a), proj(b)), without moving any element:
+	* the indices of the elements in sorted order, so that *(begin + result[0]) is the first of them.
+	* Equal elements keep their order (stable).
+	*
+	* If the keys are integers, floats or doubles compared by < or > (see the top of this file), (key, index) pairs are radix sorted,
+	* and otherwise the indices are merge sorted by the elements they refer to.
+	*
+	* O(n log n) comparisons, or O(n) for those keys, with an extra buffer of n indices (or pairs).
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	ghl::vector<size_t> argsort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		using traits = detail::comparison_traits<decltype(detail::make_comparison(comp, proj)), std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>>;
+		return detail::argsort(begin, end, comp, proj, std::integral_constant<bool, traits::radix>());
+	}
+
+	/*
+	* Overloading to argsort
+	* Equivalent to argsort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	ghl::vector<size_t> argsort(const T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		return argsort(list.begin(), list.end(), comp, proj);
+	}
+
+	/*
+	* Reorders [begin, end) in place so that the element at i is the one that was at perm[i] (e.g. the result of argsort),
+	* by following the cycles of the permutation: the first element of a cycle is moved aside,
+	* and every other element is moved straight to its final place.
+	* So every element is moved exactly once, and the first element of each cycle twice.
+	*
+	* The cycles already followed are marked by flipping the bits of their indices in perm, which are restored at the end,
+	* so no extra memory is needed.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. P is a LegacyRandomAccessIterator over end - begin size_t, which are a permutation of [0, end - begin)
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename P>
+	void apply_permutation(T begin, T end, P perm)
+	{
+		const size_t n = end - begin;
+		for (size_t i = 0; i != n; ++i)
+		{
+			if (perm[i] == i)
+			{
+				perm[i] = ~perm[i];
+				continue;
+			}
+			if (perm[i] >= n) continue; // marked: its cycle is done
+
+			auto first = std::move(*(begin + i));
+			size_t to = i;
+			while (true)
+			{
+				const size_t from = perm[to];
+				perm[to] = ~from;
+				if (from == i)
+				{
+					*(begin + to) = std::move(first);
+					break;
+				}
+				*(begin + to) = std::move(*(begin + from));
+				to = from;
+			}
+		}
+		for (size_t i = 0; i != n; ++i) perm[i] = ~perm[i];
+	}
+
+	/*
+	* Overloading to apply_permutation
+	* Equivalent to apply_permutation(list.begin(), list.end(), perm.begin());
+	*/
+	template <typename T, typename Perm>
+	void apply_permutation(T& list, Perm& perm)
+	{
+		apply_permutation(list.begin(), list.end(), perm.begin());
+	}
+
+	namespace detail
+	{
+		// sorts [begin, end) stably by the arithmetic key(element) through radix_argsort and apply_permutation
+		template <typename T, typename Key>
+		void indirect_radix_sort(T begin, T end, Key key, bool b_descending)
+		{
+			ghl::vector<size_t> perm = radix_argsort(begin, end, key, b_descending);
+			ghl::apply_permutation(begin, end, perm.begin());
+		}
+	}
+
+	/*
+	* Sorts [begin, end) by comp(proj(a), proj(b)) through argsort and apply_permutation,
+	* for large elements with small keys: the keys and indices are sorted instead of the elements,
+	* and then every element is moved once (the first of every cycle twice), compared to O(log n) times by merge_sort.
+	*
+	* Stable. The time of argsort, with an extra buffer of n indices.
+	*
+	* Requirements:
+	* 1. T is a LegacyRandomAccessIterator and a LegacyOutputIterator
+	* 2. comp(proj(a), proj(b)) is a strict weak ordering of the elements
+	* 3. the type of the object must be Cpp17MoveConstructible, Cpp17MoveAssignable
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity>
+	void indirect_sort(T begin, T end, Compare comp = Compare(), Proj proj = Proj())
+	{
+		ghl::vector<size_t> perm = argsort(begin, end, comp, proj);
+		apply_permutation(begin, end, perm.begin());
+	}
+
+	/*
+	* Overloading to indirect_sort
+	* Equivalent to indirect_sort(list.begin(), list.end(), comp, proj);
+	*/
+	template <typename T, typename Compare = detail::less, typename Proj = detail::identity, typename = std::enable_if_t<detail::is_list<T>::value>>
+	void indirect_sort(T& list, Compare comp = Compare(), Proj proj = Proj())
+	{
+		indirect_sort(list.begin(), list.end(), comp, proj);
 	}
-}
\ No newline at end of file
+}
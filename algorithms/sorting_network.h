@@ -0,0 +1,301 @@
+/*
+* This file contains the sorting networks that sort short arrays of 32-bit and 64-bit keys in AVX2 registers,
+* which are the base case of introsort and merge_sort
+*/
+
+#pragma once
+
+#include "../data_structures/simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <limits>
+#include <type_traits>
+#include <utility> // std::declval
+
+namespace ghl
+{
+	namespace detail
+	{
+		/*
+		* Whether the sorting network can sort elements of type V (value), and how it does:
+		* the elements are mapped to signed integers of the same size (int_t) that compare the same way,
+		* by to_int, and mapped back by from_int.
+		*
+		* Integers and floats of 32 and 64 bits have a network if AVX2 is enabled, and no type does otherwise.
+		*/
+		template <typename V, bool = std::is_integral<V>::value, size_t = sizeof(V)>
+		struct network_key
+		{
+			static constexpr bool value = false;
+		};
+
+#ifdef GHL_AVX2
+		template <typename V>
+		struct network_key<V, true, 4>
+		{
+			static constexpr bool value = true;
+			using int_t = int32_t;
+
+			// unsigned integers get their sign bit flipped
+			static int_t to_int(V x) { return std::is_signed<V>::value ? (int_t)x : (int_t)((uint32_t)x ^ 0x80000000u); }
+			static V from_int(int_t x) { return std::is_signed<V>::value ? (V)x : (V)((uint32_t)x ^ 0x80000000u); }
+		};
+
+		template <typename V>
+		struct network_key<V, true, 8>
+		{
+			static constexpr bool value = true;
+			using int_t = int64_t;
+
+			static int_t to_int(V x) { return std::is_signed<V>::value ? (int_t)x : (int_t)((uint64_t)x ^ 0x8000000000000000ull); }
+			static V from_int(int_t x) { return std::is_signed<V>::value ? (V)x : (V)((uint64_t)x ^ 0x8000000000000000ull); }
+		};
+
+		// negative floats get all bits but the sign flipped, so that larger magnitudes become smaller integers (and -0 comes before +0)
+		template <>
+		struct network_key<float, false, 4>
+		{
+			static constexpr bool value = true;
+			using int_t = int32_t;
+
+			static int_t to_int(float x)
+			{
+				int_t i;
+				std::memcpy(&i, &x, sizeof(i));
+				return i ^ (int_t)((uint32_t)(i >> 31) >> 1);
+			}
+
+			static float from_int(int_t i)
+			{
+				i ^= (int_t)((uint32_t)(i >> 31) >> 1);
+				float x;
+				std::memcpy(&x, &i, sizeof(x));
+				return x;
+			}
+		};
+
+		template <>
+		struct network_key<double, false, 8>
+		{
+			static constexpr bool value = true;
+			using int_t = int64_t;
+
+			static int_t to_int(double x)
+			{
+				int_t i;
+				std::memcpy(&i, &x, sizeof(i));
+				return i ^ (int_t)((uint64_t)(i >> 63) >> 1);
+			}
+
+			static double from_int(int_t i)
+			{
+				i ^= (int_t)((uint64_t)(i >> 63) >> 1);
+				double x;
+				std::memcpy(&x, &i, sizeof(x));
+				return x;
+			}
+		};
+
+		// the operations on 8 lanes of int32_t
+		struct network_lanes32
+		{
+			static constexpr int lanes = 8;
+			using int_t = int32_t;
+
+			static __m256i min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+			static __m256i max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+			static __m256i reverse(__m256i a) { return _mm256_permutevar8x32_epi32(a, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+			// @returns the vector whose lane i is lane i ^ J of a
+			template <int J>
+			static __m256i partner(__m256i a)
+			{
+				return 1 == J ? _mm256_shuffle_epi32(a, 0xB1) : 2 == J ? _mm256_shuffle_epi32(a, 0x4E) : _mm256_permute2x128_si256(a, a, 1);
+			}
+
+			// the mask of _mm256_blend_epi32 that takes lane i from the second vector iff bit i of lane_mask is set
+			static constexpr int blend_mask(int lane_mask) { return lane_mask; }
+		};
+
+		// the operations on 4 lanes of int64_t, where AVX2 has no min and max
+		struct network_lanes64
+		{
+			static constexpr int lanes = 4;
+			using int_t = int64_t;
+
+			static __m256i min(__m256i a, __m256i b) { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+			static __m256i max(__m256i a, __m256i b) { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+			static __m256i reverse(__m256i a) { return _mm256_permute4x64_epi64(a, 0x1B); }
+
+			template <int J>
+			static __m256i partner(__m256i a)
+			{
+				return 1 == J ? _mm256_shuffle_epi32(a, 0x4E) : _mm256_permute2x128_si256(a, a, 1);
+			}
+
+			// every lane takes 2 bits
+			static constexpr int blend_mask(int lane_mask)
+			{
+				return ((lane_mask & 1) ? 0x03 : 0) | ((lane_mask & 2) ? 0x0C : 0) | ((lane_mask & 4) ? 0x30 : 0) | ((lane_mask & 8) ? 0xC0 : 0);
+			}
+		};
+
+		/*
+		* @returns the mask of the lanes that take the max in the step (K, J) of a bitonic sort:
+		* lane i is compared with lane i ^ J, in ascending order if (i & K) == 0, and the higher lane of an ascending pair takes the max
+		*/
+		constexpr int bitonic_max_lanes(int lanes, int K, int J)
+		{
+			int mask = 0;
+			for (int i = 0; i != lanes; ++i)
+			{
+				if ((0 != (i & J)) != (0 != (i & K))) mask |= 1 << i;
+			}
+			return mask;
+		}
+
+		// a step (K, J) of the bitonic sort inside a vector
+		template <typename L, int K, int J>
+		__m256i bitonic_step(__m256i a)
+		{
+			const __m256i b = L::template partner<J>(a);
+			return _mm256_blend_epi32(L::min(a, b), L::max(a, b), L::blend_mask(bitonic_max_lanes(L::lanes, K, J)));
+		}
+
+		// sorts the lanes of a
+		template <typename L>
+		__m256i sort_lanes(__m256i a)
+		{
+			a = bitonic_step<L, 2, 1>(a);
+			a = bitonic_step<L, 4, 2>(a);
+			a = bitonic_step<L, 4, 1>(a);
+			if (8 == L::lanes)
+			{
+				a = bitonic_step<L, 8, 4>(a);
+				a = bitonic_step<L, 8, 2>(a);
+				a = bitonic_step<L, 8, 1>(a);
+			}
+			return a;
+		}
+
+		// sorts the lanes of a, which are bitonic (ascending and then descending, or the other way)
+		template <typename L>
+		__m256i merge_lanes(__m256i a)
+		{
+			if (8 == L::lanes) a = bitonic_step<L, 8, 4>(a);
+			a = bitonic_step<L, 8, 2>(a);
+			return bitonic_step<L, 8, 1>(a);
+		}
+
+		/*
+		* Merges the sorted vectors a and b in registers, leaving the lower half in a and the upper half in b, both sorted
+		*/
+		template <typename L>
+		void merge_vectors(__m256i& a, __m256i& b)
+		{
+			const __m256i r = L::reverse(b);
+			b = merge_lanes<L>(L::max(a, r));
+			a = merge_lanes<L>(L::min(a, r));
+		}
+
+		// the largest number of vectors sorted by sort_vectors
+		constexpr size_t network_max_vectors = 32;
+
+		/*
+		* Bitonic sorts the num_vectors * L::lanes keys, where num_vectors is a power of 2 of at most network_max_vectors:
+		* every vector is sorted in its lanes, and then sorted runs of vectors are merged pairwise,
+		* by reversing the second run and compare-exchanging vectors at halving distances, and finally lanes inside the vectors.
+		*/
+		template <typename L>
+		void sort_vectors(typename L::int_t* keys, size_t num_vectors)
+		{
+			__m256i v[network_max_vectors];
+			for (size_t i = 0; i != num_vectors; ++i) v[i] = sort_lanes<L>(_mm256_load_si256((const __m256i*)(keys + i * L::lanes)));
+
+			for (size_t run = 1; run < num_vectors; run *= 2)
+			{
+				for (size_t s = 0; s != num_vectors; s += 2 * run)
+				{
+					if (1 == run)
+					{
+						merge_vectors<L>(v[s], v[s + 1]);
+						continue;
+					}
+
+					// the second run reversed makes the two runs one bitonic sequence
+					for (size_t i = 0; i != run; ++i)
+					{
+						const __m256i a = v[s + i], b = L::reverse(v[s + 2 * run - 1 - i]);
+						v[s + i] = L::min(a, b);
+						v[s + 2 * run - 1 - i] = L::max(a, b);
+					}
+					// which is now two bitonic halves, every element of the first not greater than any of the second
+					for (size_t d = run / 2; d != 0; d /= 2)
+					{
+						for (size_t i = s; i != s + 2 * run; ++i)
+						{
+							if (0 != ((i - s) & d)) continue;
+							const __m256i a = v[i], b = v[i + d];
+							v[i] = L::min(a, b);
+							v[i + d] = L::max(a, b);
+						}
+					}
+					for (size_t i = s; i != s + 2 * run; ++i) v[i] = merge_lanes<L>(v[i]);
+				}
+			}
+
+			for (size_t i = 0; i != num_vectors; ++i) _mm256_store_si256((__m256i*)(keys + i * L::lanes), v[i]);
+		}
+#endif
+
+		// whether network_sort sorts [begin, end) of the iterator type T, which has to be a pointer
+		template <typename T>
+		struct has_sorting_network
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*std::declval<T>())>>;
+			static constexpr bool value = std::is_pointer<T>::value && network_key<value_t>::value;
+		};
+
+		// the overload of network_sort for types without a network, which is never called
+		template <typename T>
+		void network_sort(T, T, std::false_type) {}
+
+#ifdef GHL_AVX2
+		/*
+		* Sorts [begin, end), of at most network_max_size<T>() elements, in ascending order by a bitonic sorting network in AVX2 registers.
+		* Only called if has_sorting_network<T> (the last parameter is its value).
+		* Not stable, but elements that compare equal can only be told apart if they are floats (-0 and +0, which it orders).
+		*/
+		template <typename T>
+		void network_sort(T begin, T end, std::true_type)
+		{
+			using value_t = std::remove_cv_t<std::remove_reference_t<decltype(*begin)>>;
+			using key = network_key<value_t>;
+			using lanes_t = typename std::conditional<4 == sizeof(value_t), network_lanes32, network_lanes64>::type;
+			using int_t = typename key::int_t;
+
+			const size_t n = end - begin;
+			size_t num_vectors = 1;
+			while (num_vectors * lanes_t::lanes < n) num_vectors *= 2;
+
+			// the lanes past the elements are filled with the largest key, which stays at the end
+			alignas(32) int_t keys[network_max_vectors * lanes_t::lanes];
+			for (size_t i = 0; i != n; ++i) keys[i] = key::to_int(begin[i]);
+			for (size_t i = n; i != num_vectors * lanes_t::lanes; ++i) keys[i] = std::numeric_limits<int_t>::max();
+
+			sort_vectors<lanes_t>(keys, num_vectors);
+
+			for (size_t i = 0; i != n; ++i) begin[i] = key::from_int(keys[i]);
+		}
+#endif
+
+		// @returns the number of elements that fit in the vectors of network_sort, 256 keys of 32 bits or 128 of 64 bits
+		template <typename T>
+		constexpr size_t network_max_size()
+		{
+			return 32 * 32 / sizeof(*std::declval<T>());
+		}
+	}
+}
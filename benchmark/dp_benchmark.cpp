@@ -0,0 +1,273 @@
+// benchmarks for the dynamic programming algorithms
+
+#include "../algorithms/dynamic_programming.h"
+#include "../data_structures/thread_pool.h"
+#include "../data_structures/vector.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+	// @returns the seconds f takes
+	template <typename F>
+	double time_of(F f)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	ghl::vector<char> random_sequence(size_t n, int alphabet, unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		ghl::vector<char> sequence(n);
+		for (size_t i = 0; i != n; ++i) sequence.push_back((char)('A' + rng() % alphabet));
+		return sequence;
+	}
+
+	// times an LCS function on first and second, and prints its rate in millions of cells of the length matrix per second
+	template <typename F>
+	void run_lcs(const char* name, const ghl::vector<char>& first, const ghl::vector<char>& second, F lcs)
+	{
+		long long length = 0;
+		const double seconds = time_of([&]() { length = (long long)lcs(first, second); });
+		const double cells = (double)first.size() * (double)second.size();
+		std::printf("  %-40s %8.3f s   %10.1f Mcells/s   length %lld\n", name, seconds, cells / seconds * 1e-6, length);
+	}
+}
+
+void benchmark_lcs()
+{
+	for (size_t n : { 4000, 20000 })
+	{
+		const auto first = random_sequence(n, 4, 1), second = random_sequence(n, 4, 2);
+		std::printf("LCS of two random sequences of %zu elements over 4 symbols\n", n);
+		if (n <= 4000)
+		{
+			run_lcs("longest_common_subsequence (matrix)", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b)
+			{
+				ghl::vector<ghl::vector<ghl::subsequence_direction>> directions;
+				return ghl::longest_common_subsequence(a, b, directions);
+			});
+			run_lcs("  flat table", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b)
+			{
+				ghl::matrix<ghl::subsequence_direction> directions;
+				return ghl::longest_common_subsequence(a, b, directions);
+			});
+			run_lcs("  packed directions", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b)
+			{
+				ghl::packed_matrix<ghl::subsequence_direction> directions;
+				return ghl::longest_common_subsequence(a, b, directions);
+			});
+		}
+		run_lcs("longest_common_subsequence (Hirschberg)", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b) { return ghl::longest_common_subsequence(a, b).size(); });
+		run_lcs("longest_common_subsequence_length", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b) { return ghl::longest_common_subsequence_length(a, b); });
+		run_lcs("  bit_parallel", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b) { return ghl::longest_common_subsequence_length_bit_parallel(a, b); });
+	}
+
+	const size_t n = 200000;
+	for (int alphabet : { 4, 20, 96 })
+	{
+		const auto first = random_sequence(n, alphabet, 3), second = random_sequence(n, alphabet, 4);
+		std::printf("LCS length of two random sequences of %zu elements over %d symbols\n", n, alphabet);
+		run_lcs("  bit_parallel", first, second, [](const ghl::vector<char>& a, const ghl::vector<char>& b) { return ghl::longest_common_subsequence_length_bit_parallel(a, b); });
+	}
+}
+
+void benchmark_alignment()
+{
+	for (size_t n : { 2000, 8000 })
+	{
+		std::mt19937 rng((unsigned)n);
+		ghl::vector<int> first(n), second(n), flat(n * n);
+		for (size_t i = 0; i != n; ++i)
+		{
+			first.push_back((int)(rng() % 4));
+			second.push_back((int)(rng() % 4));
+		}
+		for (size_t i = 0; i != n; ++i)
+		{
+			for (size_t j = 0; j != n; ++j) flat.push_back(first[i] == second[j] ? 2 : -1);
+		}
+
+		std::printf("global alignment of two sequences of %zu elements, gap -2\n", n);
+		const double cells = (double)n * (double)n;
+		if (n <= 2000)
+		{
+			ghl::vector<ghl::vector<int>> matrix(n);
+			for (size_t i = 0; i != n; ++i)
+			{
+				matrix.emplace_back(n);
+				for (size_t j = 0; j != n; ++j) matrix[i].push_back(flat[i * n + j]);
+			}
+
+			int score = 0;
+			const double seconds = time_of([&]()
+			{
+				ghl::vector<ghl::vector<ghl::subsequence_direction>> directions;
+				score = ghl::best_alignment(-2, matrix, first, second, directions);
+			});
+			std::printf("  %-40s %8.3f s   %10.3f GCUPS   score %d\n", "best_alignment", seconds, cells / seconds * 1e-9, score);
+
+			ghl::matrix<int> table(n, n);
+			for (size_t i = 0; i != n; ++i)
+			{
+				for (size_t j = 0; j != n; ++j) table[i][j] = flat[i * n + j];
+			}
+			const double flat_seconds = time_of([&]()
+			{
+				ghl::matrix<ghl::subsequence_direction> directions;
+				score = ghl::best_alignment(-2, table, first, second, directions);
+			});
+			std::printf("  %-40s %8.3f s   %10.3f GCUPS   score %d\n", "  flat table", flat_seconds, cells / flat_seconds * 1e-9, score);
+
+			const double packed_seconds = time_of([&]()
+			{
+				ghl::packed_matrix<ghl::subsequence_direction> directions;
+				score = ghl::best_alignment(-2, table, first, second, directions);
+			});
+			std::printf("  %-40s %8.3f s   %10.3f GCUPS   score %d\n", "  packed directions", packed_seconds, cells / packed_seconds * 1e-9, score);
+		}
+
+		int score = 0;
+		const double seconds = time_of([&]() { score = ghl::best_alignment_vectorized(-2, flat, first, second); });
+		std::printf("  %-40s %8.3f s   %10.3f GCUPS   score %d\n", "best_alignment_vectorized", seconds, cells / seconds * 1e-9, score);
+
+		// affine gaps, with and without the traceback
+		const char* mode_names[] = { "global", "local", "semi_global" };
+		for (int mode = 0; mode != 3; ++mode)
+		{
+			for (bool b_traceback : { false, true })
+			{
+				ghl::alignment a;
+				const double affine_seconds = time_of([&]() { a = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, (ghl::alignment_mode)mode, b_traceback); });
+				std::printf("  align %-12s %-21s %8.3f s   %10.3f GCUPS   score %d", mode_names[mode], b_traceback ? "with traceback" : "score only",
+					affine_seconds, cells / affine_seconds * 1e-9, a.score);
+				if (b_traceback) std::printf(", CIGAR of %zu characters", a.cigar.size());
+				std::printf("\n");
+			}
+		}
+	}
+
+	// near-identical sequences, where a band finds the best alignment in a fraction of the cells
+	{
+		const size_t n = 5000;
+		std::mt19937 rng(72);
+		ghl::vector<int> first(n), second(n + n / 100);
+		for (size_t i = 0; i != n; ++i) first.push_back((int)(rng() % 4));
+		for (size_t i = 0; i != n; ++i)
+		{
+			const unsigned r = rng() % 300;
+			if (r == 0) continue; // a deletion
+			second.push_back(r == 1 ? (first[i] + 1) % 4 : first[i]);
+			if (r == 2) second.push_back((int)(rng() % 4)); // an insertion
+		}
+		const size_t n2 = second.size();
+		ghl::vector<int> flat(n * n2);
+		for (size_t i = 0; i != n; ++i)
+		{
+			for (size_t j = 0; j != n2; ++j) flat.push_back(first[i] == second[j] ? 2 : -1);
+		}
+
+		std::printf("global alignment of two sequences of %zu elements that differ in about 1%%, gap -3 - k\n", n);
+		const double cells = (double)n * (double)n2;
+		for (bool b_traceback : { false, true })
+		{
+			ghl::alignment a;
+			const double seconds = time_of([&]() { a = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global, b_traceback); });
+			std::printf("  %-40s %8.3f s   %10.3f GCUPS   score %d\n", b_traceback ? "align with traceback" : "align score only", seconds, cells / seconds * 1e-9, a.score);
+		}
+		for (size_t width : { 16, 64, 256 })
+		{
+			for (bool b_traceback : { false, true })
+			{
+				ghl::alignment a;
+				const double seconds = time_of([&]() { a = ghl::align_banded(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global, ghl::alignment_band{ width }, b_traceback); });
+				std::printf("  align_banded width %-4zu %-16s %8.3f s   %10.3f GCUPS (full matrix)   score %d\n", width, b_traceback ? "with traceback" : "score only",
+					seconds, cells / seconds * 1e-9, a.score);
+			}
+		}
+		ghl::alignment a;
+		const double seconds = time_of([&]() { a = ghl::align_banded(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global, ghl::alignment_band{ 1, true }, false); });
+		std::printf("  %-40s %8.3f s   %10.3f GCUPS (full matrix)   score %d\n", "align_banded adaptive from width 1", seconds, cells / seconds * 1e-9, a.score);
+	}
+}
+
+void benchmark_alignment_batch()
+{
+	// pairs of 100 to 150 symbols over 4, matching 2 and mismatching -1
+	const size_t count = 100000, alphabet_size = 4;
+	std::mt19937 rng(73);
+	ghl::vector<int> substitution(alphabet_size * alphabet_size);
+	for (size_t a = 0; a != alphabet_size; ++a)
+	{
+		for (size_t b = 0; b != alphabet_size; ++b) substitution.push_back(a == b ? 2 : -1);
+	}
+
+	ghl::sequence_batch<int> firsts, seconds;
+	firsts.symbols = ghl::vector<int>(count * 150);
+	seconds.symbols = ghl::vector<int>(count * 150);
+	firsts.offsets = ghl::vector<size_t>(count + 1);
+	seconds.offsets = ghl::vector<size_t>(count + 1);
+	firsts.offsets.push_back(0);
+	seconds.offsets.push_back(0);
+	double cells = 0;
+	for (size_t k = 0; k != count; ++k)
+	{
+		const size_t m = 100 + rng() % 51, n = 100 + rng() % 51;
+		for (size_t i = 0; i != m; ++i) firsts.symbols.push_back((int)(rng() % alphabet_size));
+		for (size_t j = 0; j != n; ++j) seconds.symbols.push_back((int)(rng() % alphabet_size));
+		firsts.offsets.push_back(firsts.symbols.size());
+		seconds.offsets.push_back(seconds.symbols.size());
+		cells += (double)m * (double)n;
+	}
+	std::printf("alignment of %zu pairs of 100 to 150 elements, gap -3 - k\n", count);
+
+	// align, one pair at a time, on the first pairs (their score matrices are built before the timing)
+	{
+		const size_t pairs = 2000;
+		ghl::vector<ghl::vector<int>> matrices(pairs);
+		double pair_cells = 0;
+		for (size_t k = 0; k != pairs; ++k)
+		{
+			const size_t m = firsts.offsets[k + 1] - firsts.offsets[k], n = seconds.offsets[k + 1] - seconds.offsets[k];
+			matrices.emplace_back(m * n);
+			for (size_t i = 0; i != m; ++i)
+			{
+				for (size_t j = 0; j != n; ++j) matrices[k].push_back(substitution[firsts.symbols[firsts.offsets[k] + i] * alphabet_size + seconds.symbols[seconds.offsets[k] + j]]);
+			}
+			pair_cells += (double)m * (double)n;
+		}
+
+		long long total = 0;
+		const double seconds_taken = time_of([&]()
+		{
+			for (size_t k = 0; k != pairs; ++k)
+			{
+				ghl::vector<int> first(firsts.symbols.begin() + firsts.offsets[k], firsts.symbols.begin() + firsts.offsets[k + 1]);
+				ghl::vector<int> second(seconds.symbols.begin() + seconds.offsets[k], seconds.symbols.begin() + seconds.offsets[k + 1]);
+				total += ghl::align(matrices[k], first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global, false).score;
+			}
+		});
+		std::printf("  %-40s %8.3f s   %10.3f GCUPS   (first %zu pairs, total score %lld)\n", "align, score only", seconds_taken, pair_cells / seconds_taken * 1e-9, pairs, total);
+	}
+
+	for (unsigned threads : { 1u, 0u })
+	{
+		ghl::thread_pool pool(threads);
+		for (bool b_traceback : { false, true })
+		{
+			long long total = 0;
+			const double seconds_taken = time_of([&]()
+			{
+				auto batch = ghl::align_batch(firsts, seconds, substitution, alphabet_size, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global, pool, b_traceback);
+				for (size_t k = 0; k != count; ++k) total += batch.scores[k];
+			});
+			std::printf("  align_batch, %2u threads, %-14s %8.3f s   %10.3f GCUPS   total score %lld\n", pool.num_threads(), b_traceback ? "traceback" : "score only",
+				seconds_taken, cells / seconds_taken * 1e-9, total);
+		}
+	}
+}
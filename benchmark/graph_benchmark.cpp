@@ -0,0 +1,242 @@
+// benchmarks for the algorithms on indexed graphs
+
+#include "../algorithms/graph_operations.h"
+#include "../data_structures/csr_graph.h"
+#include "../data_structures/compressed_csr_graph.h"
+#include "../data_structures/dynamic_graph.h"
+#include "../data_structures/graph.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+namespace
+{
+	// @returns the seconds f takes
+	template <typename F>
+	double time_of(F f)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	/*
+	* A side x side grid (every vertex is adj to its 4 neighbors), whose vertices are given random indices,
+	* so that the traversals have no locality at all before reordering
+	*/
+	ghl::csr_graph shuffled_grid(size_t side)
+	{
+		const size_t n = side * side;
+
+		ghl::vector<size_t> label(n);
+		for (size_t v = 0; v != n; ++v) label.push_back(v);
+		std::mt19937_64 rng(42);
+		for (size_t i = n - 1; i > 0; --i)
+		{
+			size_t j = rng() % (i + 1);
+			size_t t = label[i]; label[i] = label[j]; label[j] = t;
+		}
+
+		ghl::vector<ghl::edge_update> batch(2 * n);
+		for (size_t r = 0; r != side; ++r)
+		{
+			for (size_t c = 0; c != side; ++c)
+			{
+				if (c + 1 != side) batch.emplace_back(label[r * side + c], label[r * side + c + 1]);
+				if (r + 1 != side) batch.emplace_back(label[r * side + c], label[(r + 1) * side + c]);
+			}
+		}
+
+		ghl::dynamic_graph g(true);
+		g.apply_batch(batch);
+		return ghl::csr_graph(*g.snapshot());
+	}
+
+	// times bfs from vertex 0 and 10 iterations of PageRank on g
+	void run_kernels(const char* name, double reorder_seconds, const ghl::csr_graph& g)
+	{
+		double bfs = time_of([&g]()
+		{
+			ghl::vector<unsigned> d;
+			ghl::indexed_breadth_first_search(g, 0, d);
+		});
+		double pr = time_of([&g]()
+		{
+			ghl::vector<double> ranks;
+			ghl::indexed_page_rank(g, ranks, .85, 10);
+		});
+
+		std::printf("%-16s reorder %8.3f s   bfs %8.3f s   pagerank(10) %8.3f s\n", name, reorder_seconds, bfs, pr);
+	}
+
+	/*
+	* An undirected R-MAT graph of 2^scale vertices and edge_factor * 2^scale edges,
+	* whose degrees are skewed like those of social and web graphs
+	*/
+	ghl::csr_graph rmat(unsigned scale, size_t edge_factor)
+	{
+		const size_t n = (size_t)1 << scale;
+		const size_t m = edge_factor * n;
+		std::mt19937_64 rng(42);
+		std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+		ghl::vector<ghl::edge_update> batch(m);
+		for (size_t e = 0; e != m; ++e)
+		{
+			size_t l = 0, r = 0;
+			for (unsigned bit = 0; bit != scale; ++bit)
+			{
+				// quadrant probabilities .57, .19, .19, .05
+				double p = coin(rng);
+				if (p >= .57 && p < .76) r |= (size_t)1 << bit;
+				else if (p >= .76 && p < .95) l |= (size_t)1 << bit;
+				else if (p >= .95) { l |= (size_t)1 << bit; r |= (size_t)1 << bit; }
+			}
+			batch.emplace_back(l, r);
+		}
+
+		ghl::dynamic_graph g(true);
+		g.add_vertices(n);
+		g.apply_batch(batch);
+		return ghl::csr_graph(*g.snapshot());
+	}
+
+	// times a pass over all adj lists of g, which sums up the neighbors so that the decoding is not optimized away
+	template <typename G>
+	void run_scan(const char* name, const G& g, size_t bytes)
+	{
+		size_t sum = 0;
+		double seconds = time_of([&]()
+		{
+			for (size_t v = 0; v != g.num_vertices(); ++v) g.for_each_neighbor(v, [&sum](size_t u, float) { sum += u; });
+		});
+
+		const double refs = (double)(g.is_undirected() ? 2 * g.num_edges() : g.num_edges());
+		std::printf("%-24s %6.2f bytes/edge   scan %8.3f s   %7.1f M edges/s   (checksum %zu)\n", name, bytes / refs, seconds, refs / seconds / 1e6, sum);
+	}
+
+	template <typename F>
+	void run_ordering(const char* name, const ghl::csr_graph& g, F order)
+	{
+		ghl::vector<size_t> new_index;
+		ghl::csr_graph r;
+		double seconds = time_of([&]()
+		{
+			order(g, new_index);
+			r = g.relabeled(new_index);
+		});
+		run_kernels(name, seconds, r);
+	}
+}
+
+void benchmark_graph_reordering()
+{
+	const size_t side = 1024;
+	auto g = shuffled_grid(side);
+
+	std::printf("graph reordering on a shuffled %zu x %zu grid (%zu vertices, %zu edges)\n", side, side, g.num_vertices(), g.num_edges());
+
+	run_kernels("random", 0.0, g);
+	run_ordering("degree sort", g, [](const ghl::csr_graph& g, ghl::vector<size_t>& i) { ghl::degree_sort_order(g, i); });
+	run_ordering("rcm", g, [](const ghl::csr_graph& g, ghl::vector<size_t>& i) { ghl::cuthill_mckee_order(g, i); });
+	run_ordering("gorder", g, [](const ghl::csr_graph& g, ghl::vector<size_t>& i) { ghl::gorder_order(g, i); });
+
+	// partitioning
+	{
+		ghl::vector<unsigned> part;
+		double seconds = time_of([&]() { ghl::multilevel_partition(g, 16, part); });
+		std::printf("multilevel partition into 16 parts: %8.3f s, edge cut %zu of %zu\n", seconds, ghl::edge_cut(g, part), g.num_edges());
+	}
+}
+
+void benchmark_graph_kernels()
+{
+	const unsigned scale = 18;
+	auto g = rmat(scale, 16);
+
+	std::printf("graph kernels on an R-MAT graph (%zu vertices, %zu edges)\n", g.num_vertices(), g.num_edges());
+
+	uint64_t triangles = 0;
+	double one = time_of([&]() { triangles = ghl::count_triangles(g, 1); });
+	std::printf("%-16s %8.3f s   %llu triangles\n", "triangles(1)", one, (unsigned long long)triangles);
+
+	const unsigned threads = std::thread::hardware_concurrency();
+	double all = time_of([&]() { triangles = ghl::count_triangles(g, threads); });
+	std::printf("%-16s %8.3f s   %llu triangles   (%u threads)\n", "triangles(all)", all, (unsigned long long)triangles, threads);
+
+	ghl::vector<size_t> core;
+	size_t degeneracy = 0;
+	double kcore = time_of([&]() { degeneracy = ghl::k_core_decomposition(g, core); });
+	std::printf("%-16s %8.3f s   degeneracy %zu\n", "k-core", kcore, degeneracy);
+}
+
+void benchmark_compressed_graph()
+{
+	auto g = rmat(20, 16);
+	std::printf("compressed adjacency on an R-MAT graph (%zu vertices, %zu edges)\n", g.num_vertices(), g.num_edges());
+
+	const size_t csr_bytes = (g.num_vertices() + 1) * sizeof(size_t) + 2 * g.num_edges() * sizeof(ghl::indexed_vertex_ref);
+	run_scan("csr", g, csr_bytes);
+
+	ghl::compressed_csr_graph c(g);
+	run_scan("compressed", c, c.size_in_bytes());
+
+	ghl::vector<size_t> new_index;
+	ghl::cuthill_mckee_order(g, new_index);
+	ghl::compressed_csr_graph cr(g.relabeled(new_index));
+	run_scan("compressed after rcm", cr, cr.size_in_bytes());
+}
+
+void benchmark_graph_iteration()
+{
+	// the largest graph that fits here: the list-filling calls hold an edge_t per edge on top of the graph itself,
+	// so a list of ~10M edges does not fit in memory
+	const uint64_t n = (uint64_t)1 << 17;
+	const size_t m = (size_t)1 << 21;
+
+	ghl::graph<ghl::adj_list_graph_ds<uint64_t>> g(false);
+	for (uint64_t v = 0; v != n; ++v) g.add_vertex(v, v);
+	std::mt19937_64 rng(42);
+	for (size_t e = 0; e != m; ++e) g.add_edge(rng() % n, rng() % n, 1.0f);
+
+	std::printf("graph iteration on a random directed adj list graph (%llu vertices, %zu edges)\n", (unsigned long long)n, m);
+
+	// sums up the right endpoints so that the passes are not optimized away, and checks the two APIs agree
+	uint64_t listed = 0, visited = 0;
+	ghl::list<ghl::float_weighted_edge<uint64_t>> all;
+	double all_edges = time_of([&]()
+	{
+		g.get_all_edges(all);
+		for (const auto& e : all) listed += *(e.right.observe().obj);
+	});
+	// the nodes of a list are destroyed recursively, which overflows the stack for millions of them, so empty it from the front
+	while (!all.empty()) all.remove_front();
+	double each_edge = time_of([&]()
+	{
+		g.for_each_edge([&](ghl::vertex_weak_ref<uint64_t>, ghl::vertex_weak_ref<uint64_t> r, float) { visited += *(r.observe().obj); });
+	});
+	std::printf("%-20s %8.3f s   %-20s %8.3f s   (checksums %llu, %llu)\n", "get_all_edges", all_edges, "for_each_edge", each_edge,
+		(unsigned long long)listed, (unsigned long long)visited);
+
+	listed = 0; visited = 0;
+	double adj_in_edges = time_of([&]()
+	{
+		for (uint64_t v = 0; v != n; ++v)
+		{
+			ghl::list<ghl::float_weighted_edge<uint64_t>> edges;
+			g.get_adj_in_edges(v, edges);
+			for (const auto& e : edges) listed += *(e.right.observe().obj);
+		}
+	});
+	double each_neighbor = time_of([&]()
+	{
+		for (uint64_t v = 0; v != n; ++v)
+		{
+			g.for_each_neighbor(v, [&](ghl::vertex_weak_ref<uint64_t> r, float) { visited += *(r.observe().obj); });
+		}
+	});
+	std::printf("%-20s %8.3f s   %-20s %8.3f s   (checksums %llu, %llu)\n", "get_adj_in_edges", adj_in_edges, "for_each_neighbor", each_neighbor,
+		(unsigned long long)listed, (unsigned long long)visited);
+}
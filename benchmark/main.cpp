@@ -0,0 +1,40 @@
+#include <cstddef>
+
+void benchmark_graph_reordering();
+void benchmark_graph_kernels();
+void benchmark_compressed_graph();
+void benchmark_graph_iteration();
+void benchmark_parallel_sorting();
+void benchmark_radix_sorting();
+void benchmark_sorting_networks();
+void benchmark_external_sorting();
+void benchmark_partial_sorting();
+void benchmark_projected_sorting();
+void benchmark_indirect_sorting();
+void benchmark_adaptive_sorting();
+void benchmark_sorting_suite(const char* json_path, size_t max_size);
+void benchmark_lcs();
+void benchmark_alignment();
+void benchmark_alignment_batch();
+
+int main()
+{
+	benchmark_graph_reordering();
+	benchmark_graph_kernels();
+	benchmark_compressed_graph();
+	benchmark_graph_iteration();
+	benchmark_parallel_sorting();
+	benchmark_radix_sorting();
+	benchmark_sorting_networks();
+	benchmark_external_sorting();
+	benchmark_partial_sorting();
+	benchmark_projected_sorting();
+	benchmark_indirect_sorting();
+	benchmark_adaptive_sorting();
+	benchmark_sorting_suite("sorting_benchmark.json", 1000000);
+	benchmark_lcs();
+	benchmark_alignment();
+	benchmark_alignment_batch();
+
+	return 0;
+}
@@ -0,0 +1,397 @@
+// benchmarks for the sorting algorithms
+
+#include "../algorithms/external_sort.h"
+#include "../algorithms/sorting.h"
+#include "../data_structures/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+	// @returns the seconds f takes
+	template <typename F>
+	double time_of(F f)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	ghl::vector<uint64_t> random_keys(size_t n, uint64_t seed)
+	{
+		ghl::vector<uint64_t> keys(n);
+		std::mt19937_64 rng(seed);
+		for (size_t i = 0; i != n; ++i) keys.push_back(rng());
+		return keys;
+	}
+
+	template <typename V>
+	bool is_ascending(const V& keys)
+	{
+		for (size_t i = 1; i < keys.size(); ++i)
+		{
+			if (keys[i] < keys[i - 1]) return false;
+		}
+		return true;
+	}
+
+	// a record sorted by its key
+	struct record
+	{
+		uint64_t key;
+		uint64_t payload;
+
+		bool operator<(const record& other) const { return key < other.key; }
+	};
+
+	// times every sort of a copy of input
+	template <typename V, typename F>
+	void run_sort(const char* name, const V& input, F sort)
+	{
+		V list(input);
+		double seconds = time_of([&]() { sort(list); });
+		std::printf("  %-20s %8.3f s   %6.1f ns/element%s\n", name, seconds, seconds * 1e9 / input.size(), is_ascending(list) ? "" : "   NOT SORTED");
+	}
+
+	template <typename V>
+	void run_comparison_sorts(const V& input)
+	{
+		run_sort("merge_sort", input, [](V& list) { ghl::merge_sort(list); });
+		run_sort("introsort", input, [](V& list) { ghl::introsort(list); });
+	}
+}
+
+void benchmark_parallel_sorting()
+{
+	const size_t n = (size_t)1 << 24;
+	const size_t grain = (size_t)1 << 14;
+	const ghl::vector<uint64_t> input = random_keys(n, 42);
+
+	std::printf("parallel sorting of %zu random 64-bit keys (grain %zu, %u hardware threads)\n", n, grain, std::thread::hardware_concurrency());
+
+	double sequential = time_of([&]()
+	{
+		ghl::vector<uint64_t> keys(input);
+		ghl::introsort(keys);
+	});
+	std::printf("%-12s %8.3f s\n", "introsort", sequential);
+
+	for (unsigned threads = 1; threads <= 64; threads *= 2)
+	{
+		ghl::thread_pool pool(threads);
+
+		ghl::vector<uint64_t> keys(input);
+		double merge = time_of([&]() { ghl::parallel_merge_sort(keys, pool, grain); });
+		bool b_sorted = is_ascending(keys);
+
+		keys = input;
+		double sample = time_of([&]() { ghl::parallel_sample_sort(keys, pool, grain); });
+		b_sorted = b_sorted && is_ascending(keys);
+
+		std::printf("%2u threads   merge sort %8.3f s (x%5.2f)   sample sort %8.3f s (x%5.2f)%s\n",
+			threads, merge, sequential / merge, sample, sequential / sample, b_sorted ? "" : "   NOT SORTED");
+	}
+}
+
+void benchmark_radix_sorting()
+{
+	const size_t n = (size_t)1 << 22;
+	std::mt19937_64 rng(7);
+
+	std::printf("radix sorting of %zu keys\n", n);
+
+	ghl::vector<uint32_t> keys32(n);
+	for (size_t i = 0; i != n; ++i) keys32.push_back((uint32_t)rng());
+	std::printf("random uint32_t\n");
+	run_sort("radix_sort", keys32, [](ghl::vector<uint32_t>& list) { ghl::radix_sort(list); });
+	run_comparison_sorts(keys32);
+
+	const ghl::vector<uint64_t> keys64 = random_keys(n, 7);
+	std::printf("random uint64_t\n");
+	run_sort("radix_sort", keys64, [](ghl::vector<uint64_t>& list) { ghl::radix_sort(list); });
+	run_comparison_sorts(keys64);
+
+	ghl::vector<float> floats(n);
+	std::normal_distribution<float> normal;
+	for (size_t i = 0; i != n; ++i) floats.push_back(normal(rng));
+	std::printf("normally distributed float\n");
+	run_sort("radix_sort", floats, [](ghl::vector<float>& list) { ghl::radix_sort(list); });
+	run_comparison_sorts(floats);
+
+	ghl::vector<record> records(n);
+	for (size_t i = 0; i != n; ++i) records.push_back(record{ rng(), i });
+	std::printf("16-byte records by a uint64_t key\n");
+	run_sort("radix_sort", records, [](ghl::vector<record>& list) { ghl::radix_sort(list.begin(), list.end(), [](const record& r) { return r.key; }); });
+	run_comparison_sorts(records);
+
+	// urls-like strings, with long common prefixes
+	const size_t num_strings = n / 4;
+	ghl::vector<std::string> strings(num_strings);
+	for (size_t i = 0; i != num_strings; ++i) strings.push_back("https://example.com/" + std::to_string(rng() % 1000) + "/item/" + std::to_string(rng()));
+	std::printf("%zu url-like strings\n", num_strings);
+	run_sort("american_flag_sort", strings, [](ghl::vector<std::string>& list) { ghl::american_flag_sort(list); });
+	run_comparison_sorts(strings);
+}
+
+namespace
+{
+	// times sorting n random keys of type V in lists of size elements
+	template <typename V>
+	void run_small_sorts(const char* type, size_t size, size_t n)
+	{
+		std::mt19937_64 rng(size);
+		ghl::vector<V> input(n);
+		for (size_t i = 0; i != n; ++i) input.push_back((V)(int64_t)rng());
+
+		ghl::vector<V> keys(input);
+		double ghl_seconds = time_of([&]()
+		{
+			for (size_t i = 0; i + size <= n; i += size) ghl::introsort(keys.begin() + i, keys.begin() + i + size);
+		});
+		keys = input;
+		double std_seconds = time_of([&]()
+		{
+			for (size_t i = 0; i + size <= n; i += size) std::sort(keys.begin() + i, keys.begin() + i + size);
+		});
+		std::printf("  %-8s lists of %3zu   introsort %6.2f ns/element   std::sort %6.2f ns/element\n", type, size, ghl_seconds * 1e9 / n, std_seconds * 1e9 / n);
+	}
+
+	template <typename V>
+	void run_large_sorts(const char* type, size_t n)
+	{
+		std::mt19937_64 rng(n);
+		ghl::vector<V> input(n);
+		for (size_t i = 0; i != n; ++i) input.push_back((V)(int64_t)rng());
+
+		std::printf("%s\n", type);
+		run_comparison_sorts(input);
+		run_sort("std::sort", input, [](ghl::vector<V>& list) { std::sort(list.begin(), list.end()); });
+		run_sort("std::stable_sort", input, [](ghl::vector<V>& list) { std::stable_sort(list.begin(), list.end()); });
+	}
+}
+
+void benchmark_sorting_networks()
+{
+	const size_t n = (size_t)1 << 22;
+
+#ifdef GHL_AVX2
+	std::printf("sorting networks (AVX2) as the base case of the sorts\n");
+#else
+	std::printf("sorting networks as the base case of the sorts: not compiled in, as AVX2 is not enabled\n");
+#endif
+
+	for (size_t size : { 8, 16, 32, 64, 256 })
+	{
+		run_small_sorts<int32_t>("int32_t", size, n);
+		run_small_sorts<double>("double", size, n);
+	}
+
+	run_large_sorts<int32_t>("random int32_t", n);
+	run_large_sorts<int64_t>("random int64_t", n);
+	run_large_sorts<float>("random float", n);
+}
+
+namespace
+{
+	// times taking the greatest k of input, sorted from the greatest down, in every way
+	template <typename V>
+	void run_top_k(const char* type, const ghl::vector<V>& input, size_t k)
+	{
+		const size_t n = input.size();
+		std::printf("%s, top %zu of %zu\n", type, k, n);
+
+		ghl::vector<V> keys(input);
+		double seconds = time_of([&]() { ghl::merge_sort(keys); });
+		const ghl::vector<V> expected(keys);
+		std::printf("  %-32s %8.3f s\n", "merge_sort", seconds);
+
+		// the least k of the negated keys are the greatest k
+		ghl::vector<V> negated(n);
+		for (size_t i = 0; i != n; ++i) negated.push_back(-input[i]);
+		seconds = time_of([&]() { ghl::partial_sort(negated, k); });
+		bool b_ok = true;
+		for (size_t i = 0; i != k; ++i) b_ok = b_ok && -negated[i] == expected[n - 1 - i];
+		std::printf("  %-32s %8.3f s%s\n", "partial_sort (of negated keys)", seconds, b_ok ? "" : "   WRONG");
+
+		keys = input;
+		seconds = time_of([&]()
+		{
+			ghl::nth_element(keys, n - k);
+			ghl::introsort(keys.begin() + (n - k), keys.end());
+		});
+		b_ok = true;
+		for (size_t i = n - k; i != n; ++i) b_ok = b_ok && keys[i] == expected[i];
+		std::printf("  %-32s %8.3f s%s\n", "nth_element + introsort", seconds, b_ok ? "" : "   WRONG");
+
+		ghl::vector<V> top;
+		seconds = time_of([&]()
+		{
+			ghl::top_k<V> acc(k);
+			acc.push(input.begin(), input.end());
+			top = acc.sorted();
+		});
+		b_ok = k == top.size();
+		for (size_t i = 0; b_ok && i != k; ++i) b_ok = top[i] == expected[n - 1 - i];
+		std::printf("  %-32s %8.3f s%s\n", "top_k (array)", seconds, b_ok ? "" : "   WRONG");
+
+		seconds = time_of([&]()
+		{
+			ghl::top_k<V> acc(k);
+			for (size_t i = 0; i != n; ++i) acc.push(input[i]);
+			top = acc.sorted();
+		});
+		std::printf("  %-32s %8.3f s\n", "top_k (one at a time)", seconds);
+
+		keys = input;
+		seconds = time_of([&]() { std::partial_sort(keys.begin(), keys.begin() + k, keys.end(), [](const V& a, const V& b) { return b < a; }); });
+		std::printf("  %-32s %8.3f s\n", "std::partial_sort", seconds);
+	}
+}
+
+void benchmark_partial_sorting()
+{
+	const size_t n = (size_t)1 << 25;
+	std::mt19937_64 rng(13);
+
+	ghl::vector<float> scores(n);
+	std::normal_distribution<float> normal;
+	for (size_t i = 0; i != n; ++i) scores.push_back(normal(rng));
+	run_top_k("normally distributed float scores", scores, 100);
+	run_top_k("normally distributed float scores", scores, 100000);
+
+	ghl::vector<int64_t> keys(n);
+	for (size_t i = 0; i != n; ++i) keys.push_back((int64_t)(rng() >> 1));
+	run_top_k("random int64_t", keys, 100);
+}
+
+void benchmark_external_sorting()
+{
+	const size_t n = (size_t)1 << 24;
+	const char* input_path = "external_sort_benchmark.in";
+	const char* output_path = "external_sort_benchmark.out";
+	{
+		const ghl::vector<uint64_t> keys = random_keys(n, 11);
+		std::ofstream out(input_path, std::ios::binary | std::ios::trunc);
+		out.write((const char*)keys.begin(), (std::streamsize)(n * sizeof(uint64_t)));
+	}
+
+	std::printf("external sorting of %zu random 64-bit keys (%zu MB)\n", n, n * sizeof(uint64_t) >> 20);
+	for (size_t memory_mb : { 4, 16, 64, 256 })
+	{
+		ghl::external_sort_stats stats;
+		bool b_ok = false;
+		double seconds = time_of([&]() { b_ok = ghl::external_sort<uint64_t>(input_path, output_path, memory_mb << 20, &stats); });
+
+		std::ifstream in(output_path, std::ios::binary);
+		ghl::vector<uint64_t> keys(n);
+		keys.increase_size(n);
+		in.read((char*)keys.begin(), (std::streamsize)(n * sizeof(uint64_t)));
+		b_ok = b_ok && in && is_ascending(keys);
+
+		std::printf("  %4zu MB of memory   %5zu runs   %zu-way merges   %zu passes   %8.3f s   %7.1f MB/s   read %6zu MB   written %6zu MB%s\n",
+			memory_mb, stats.num_runs, stats.fan_in, stats.num_passes, seconds, (n * sizeof(uint64_t) >> 20) / seconds,
+			stats.bytes_read >> 20, stats.bytes_written >> 20, b_ok ? "" : "   FAILED");
+	}
+
+	std::remove(input_path);
+	std::remove(output_path);
+}
+
+void benchmark_projected_sorting()
+{
+	const size_t n = (size_t)1 << 22;
+	const ghl::vector<uint64_t> keys = random_keys(n, 17);
+	ghl::vector<record> records(n);
+	for (size_t i = 0; i != n; ++i) records.push_back(record{ keys[i], i });
+
+	std::printf("sorting %zu random 64-bit keys, and 16-byte records by them through a projection\n", n);
+	std::printf("raw keys\n");
+	run_comparison_sorts(keys);
+	run_sort("radix_sort", keys, [](ghl::vector<uint64_t>& list) { ghl::radix_sort(list); });
+
+	std::printf("records by &record::key\n");
+	run_sort("merge_sort", records, [](ghl::vector<record>& list) { ghl::merge_sort(list, std::less<>(), &record::key); });
+	run_sort("introsort", records, [](ghl::vector<record>& list) { ghl::introsort(list, std::less<>(), &record::key); });
+	run_sort("introsort (operator<)", records, [](ghl::vector<record>& list) { ghl::introsort(list); });
+	run_sort("std::sort", records, [](ghl::vector<record>& list) { std::sort(list.begin(), list.end()); });
+
+	std::printf("raw keys in descending order, by std::greater\n");
+	ghl::vector<uint64_t> descending(keys);
+	double seconds = time_of([&]() { ghl::introsort(descending, std::greater<>()); });
+	std::printf("  %-20s %8.3f s   %6.1f ns/element\n", "introsort", seconds, seconds * 1e9 / n);
+	descending = keys;
+	seconds = time_of([&]() { ghl::merge_sort(descending, std::greater<>()); });
+	std::printf("  %-20s %8.3f s   %6.1f ns/element\n", "merge_sort", seconds, seconds * 1e9 / n);
+}
+
+namespace
+{
+	// a 256-byte record sorted by its key
+	struct large_record
+	{
+		uint64_t key;
+		char payload[248];
+
+		bool operator<(const large_record& other) const { return key < other.key; }
+	};
+}
+
+void benchmark_indirect_sorting()
+{
+	const size_t n = (size_t)1 << 20;
+	const ghl::vector<uint64_t> keys = random_keys(n, 19);
+	ghl::vector<large_record> records(n);
+	for (size_t i = 0; i != n; ++i)
+	{
+		records.push_back(large_record{});
+		records[i].key = keys[i];
+	}
+
+	std::printf("sorting %zu records of %zu bytes by a 64-bit key\n", n, sizeof(large_record));
+	run_sort("introsort", records, [](ghl::vector<large_record>& list) { ghl::introsort(list, std::less<>(), &large_record::key); });
+	run_sort("merge_sort", records, [](ghl::vector<large_record>& list) { ghl::merge_sort(list, std::less<>(), &large_record::key); });
+	run_sort("std::sort", records, [](ghl::vector<large_record>& list) { std::sort(list.begin(), list.end()); });
+	run_sort("indirect_sort", records, [](ghl::vector<large_record>& list) { ghl::indirect_sort(list, std::less<>(), &large_record::key); });
+
+	ghl::vector<size_t> perm;
+	double seconds = time_of([&]() { perm = ghl::argsort(records, std::less<>(), &large_record::key); });
+	std::printf("  %-20s %8.3f s   %6.1f ns/element\n", "  argsort", seconds, seconds * 1e9 / n);
+	ghl::vector<large_record> list(records);
+	seconds = time_of([&]() { ghl::apply_permutation(list, perm); });
+	std::printf("  %-20s %8.3f s   %6.1f ns/element%s\n", "  apply_permutation", seconds, seconds * 1e9 / n, is_ascending(list) ? "" : "   NOT SORTED");
+}
+
+void benchmark_adaptive_sorting()
+{
+	const size_t n = (size_t)1 << 22;
+	const ghl::vector<uint64_t> random = random_keys(n, 23);
+	const char* names[] = { "sorted", "reversed", "sawtooth (64 runs)", "appended log (1% new)", "random" };
+
+	for (size_t pattern = 0; pattern != 5; ++pattern)
+	{
+		ghl::vector<uint64_t> keys(random);
+		switch (pattern)
+		{
+		case 0: std::sort(keys.begin(), keys.end()); break;
+		case 1: std::sort(keys.begin(), keys.end(), std::greater<>()); break;
+		case 2:
+			for (size_t i = 0; i != 64; ++i) std::sort(keys.begin() + i * (n / 64), keys.begin() + (i + 1) * (n / 64));
+			break;
+		case 3: std::sort(keys.begin(), keys.end() - n / 100); break;
+		default: break;
+		}
+
+		std::printf("sorting %zu 64-bit keys, %s\n", n, names[pattern]);
+		run_sort("natural_merge_sort", keys, [](ghl::vector<uint64_t>& list) { ghl::natural_merge_sort(list); });
+		run_comparison_sorts(keys);
+		run_sort("std::stable_sort", keys, [](ghl::vector<uint64_t>& list) { std::stable_sort(list.begin(), list.end()); });
+	}
+}
@@ -0,0 +1,282 @@
+// a benchmark suite for the sorts, over sizes, element types and input distributions, that writes its results as JSON
+
+#include "../algorithms/sorting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+
+namespace
+{
+	// the version of the JSON layout, to bump whenever a field changes meaning
+	constexpr int suite_schema_version = 1;
+
+	// the small sizes are sorted repeatedly, until at least this many elements are sorted in total
+	constexpr size_t suite_min_elements_timed = 1000000;
+
+	// comparisons and moves are counted only up to this size, since counting disables the fast paths and takes a second run
+	constexpr size_t suite_max_counted_size = 1000000;
+
+	// a 64-byte record sorted by its key
+	struct record64
+	{
+		uint64_t key;
+		char payload[56];
+
+		bool operator<(const record64& other) const { return key < other.key; }
+	};
+
+	// the number of comparisons and moves (or copies) of counted elements since the last reset
+	size_t num_comparisons = 0;
+	size_t num_moves = 0;
+
+	// an element that counts its moves and copies, and the comparisons through operator<
+	template <typename V>
+	struct counted
+	{
+		V value;
+
+		counted() = default;
+		explicit counted(const V& v) : value(v) {}
+		counted(const counted& other) : value(other.value) { ++num_moves; }
+		counted(counted&& other) : value(std::move(other.value)) { ++num_moves; }
+		counted& operator=(const counted& other) { value = other.value; ++num_moves; return *this; }
+		counted& operator=(counted&& other) { value = std::move(other.value); ++num_moves; return *this; }
+
+		bool operator<(const counted& other) const { ++num_comparisons; return value < other.value; }
+	};
+
+	const char* const distribution_names[] = { "random", "sorted", "reversed", "few_unique", "organ_pipe", "zipf" };
+	const size_t num_distributions = 6;
+
+	/*
+	* @returns n keys in the distribution:
+	* 0 uniformly random, 1 sorted, 2 reversed, 3 16 distinct values, 4 ascending then descending,
+	* 5 Zipf (s = 1) over up to 2^20 distinct values, which are scattered so that the frequent ones are not the small ones
+	*/
+	ghl::vector<uint32_t> distribution_keys(size_t distribution, size_t n)
+	{
+		std::mt19937 rng((unsigned)(distribution * 7919 + n));
+		ghl::vector<uint32_t> keys(n);
+
+		ghl::vector<double> cdf;
+		if (5 == distribution)
+		{
+			const size_t num_values = std::min<size_t>(n, (size_t)1 << 20);
+			cdf.resize(num_values);
+			double sum = 0;
+			for (size_t rank = 1; rank <= num_values; ++rank)
+			{
+				sum += 1.0 / (double)rank;
+				cdf.push_back(sum);
+			}
+			for (auto& c : cdf) c /= sum;
+		}
+		std::uniform_real_distribution<double> uniform(0, 1);
+
+		for (size_t i = 0; i != n; ++i)
+		{
+			switch (distribution)
+			{
+			case 0: keys.push_back((uint32_t)rng()); break;
+			case 1: keys.push_back((uint32_t)i); break;
+			case 2: keys.push_back((uint32_t)(n - i)); break;
+			case 3: keys.push_back((uint32_t)(rng() % 16)); break;
+			case 4: keys.push_back((uint32_t)(i < n / 2 ? i : n - i)); break;
+			default:
+			{
+				const size_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng)) - cdf.begin();
+				keys.push_back((uint32_t)(rank * 2654435761u));
+				break;
+			}
+			}
+		}
+		return keys;
+	}
+
+	// the elements of every type made from a key, in the order of the keys
+	void make_element(uint32_t key, int& e) { e = (int)(key & 0x7fffffff); }
+	void make_element(uint32_t key, double& e) { e = key * 0.25; }
+	void make_element(uint32_t key, std::string& e)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "element_%010u", key);
+		e = buffer;
+	}
+	void make_element(uint32_t key, record64& e)
+	{
+		e.key = key;
+		std::fill(e.payload, e.payload + sizeof(e.payload), (char)key);
+	}
+
+	// radix_sort the list if its elements have an arithmetic key, @returns whether it did
+	bool radix_sort_of(ghl::vector<int>& list) { ghl::radix_sort(list); return true; }
+	bool radix_sort_of(ghl::vector<double>& list) { ghl::radix_sort(list); return true; }
+	bool radix_sort_of(ghl::vector<std::string>&) { return false; }
+	bool radix_sort_of(ghl::vector<record64>& list) { ghl::radix_sort(list.begin(), list.end(), [](const record64& r) { return r.key; }); return true; }
+	template <typename V>
+	bool radix_sort_of(ghl::vector<counted<V>>&) { return false; }
+
+	template <typename V>
+	bool is_ascending(const ghl::vector<V>& list)
+	{
+		for (size_t i = 1; i < list.size(); ++i)
+		{
+			if (list[i].value < list[i - 1].value) return false;
+		}
+		return true;
+	}
+
+	bool is_ascending(const ghl::vector<int>& list) { return std::is_sorted(list.begin(), list.end()); }
+	bool is_ascending(const ghl::vector<double>& list) { return std::is_sorted(list.begin(), list.end()); }
+	bool is_ascending(const ghl::vector<std::string>& list) { return std::is_sorted(list.begin(), list.end()); }
+	bool is_ascending(const ghl::vector<record64>& list) { return std::is_sorted(list.begin(), list.end()); }
+
+	const char* const sort_names[] = { "introsort", "merge_sort", "natural_merge_sort", "heap_sort", "radix_sort", "std::sort", "std::stable_sort" };
+	const size_t num_sorts = 7;
+
+	// sorts the list by the sort, @returns false if the sort does not apply to the elements
+	template <typename V>
+	bool sort_by(size_t sort, ghl::vector<V>& list)
+	{
+		switch (sort)
+		{
+		case 0: ghl::introsort(list); return true;
+		case 1: ghl::merge_sort(list); return true;
+		case 2: ghl::natural_merge_sort(list); return true;
+		case 3: ghl::heap_sort(list); return true;
+		case 4: return radix_sort_of(list);
+		case 5: std::sort(list.begin(), list.end()); return true;
+		default: std::stable_sort(list.begin(), list.end()); return true;
+		}
+	}
+
+	// the results of a sort on an input
+	struct measurement
+	{
+		bool b_applies = false;
+		bool b_sorted = true;
+		size_t repetitions = 0;
+		double ns_per_element = 0;
+		bool b_counted = false;
+		double comparisons_per_element = 0;
+		double moves_per_element = 0;
+	};
+
+	template <typename V>
+	measurement measure(size_t sort, const ghl::vector<V>& input)
+	{
+		measurement m;
+		const size_t n = input.size();
+		m.repetitions = std::max<size_t>(1, suite_min_elements_timed / std::max<size_t>(n, 1));
+
+		double seconds = 0;
+		for (size_t r = 0; r != m.repetitions; ++r)
+		{
+			ghl::vector<V> list(input);
+			const auto begin = std::chrono::steady_clock::now();
+			m.b_applies = sort_by(sort, list);
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+			if (!m.b_applies) return m;
+			m.b_sorted = m.b_sorted && is_ascending(list);
+		}
+		m.ns_per_element = seconds * 1e9 / (double)(m.repetitions * n);
+
+		if (n <= suite_max_counted_size)
+		{
+			ghl::vector<counted<V>> list(n);
+			for (size_t i = 0; i != n; ++i) list.push_back(counted<V>(input[i]));
+			num_comparisons = num_moves = 0;
+			if (sort_by(sort, list))
+			{
+				m.b_counted = true;
+				m.comparisons_per_element = (double)num_comparisons / (double)n;
+				m.moves_per_element = (double)num_moves / (double)n;
+				m.b_sorted = m.b_sorted && is_ascending(list);
+			}
+		}
+		return m;
+	}
+
+	// measures every sort on every distribution of every size, printing a table and writing the JSON records to out
+	template <typename V>
+	void run_type(const char* type_name, size_t max_size, FILE* out, bool& b_first)
+	{
+		for (size_t n = 100; n <= max_size; n *= 10)
+		{
+			for (size_t d = 0; d != num_distributions; ++d)
+			{
+				const ghl::vector<uint32_t> keys = distribution_keys(d, n);
+				ghl::vector<V> input(n);
+				for (size_t i = 0; i != n; ++i)
+				{
+					V e{};
+					make_element(keys[i], e);
+					input.push_back(std::move(e));
+				}
+
+				for (size_t s = 0; s != num_sorts; ++s)
+				{
+					const measurement m = measure(s, input);
+					if (!m.b_applies) continue;
+
+					std::printf("  %-9s %-11s %10zu %-19s %8.1f ns/element", type_name, distribution_names[d], n, sort_names[s], m.ns_per_element);
+					if (m.b_counted) std::printf(" %7.1f cmp/element %7.1f moves/element", m.comparisons_per_element, m.moves_per_element);
+					std::printf("%s\n", m.b_sorted ? "" : "   NOT SORTED");
+
+					if (!out) continue;
+					std::fprintf(out, "%s\n    {\"sort\": \"%s\", \"type\": \"%s\", \"distribution\": \"%s\", \"size\": %zu, \"repetitions\": %zu, "
+						"\"ns_per_element\": %.3f, ", b_first ? "" : ",", sort_names[s], type_name, distribution_names[d], n, m.repetitions, m.ns_per_element);
+					if (m.b_counted) std::fprintf(out, "\"comparisons_per_element\": %.3f, \"moves_per_element\": %.3f, ", m.comparisons_per_element, m.moves_per_element);
+					else std::fprintf(out, "\"comparisons_per_element\": null, \"moves_per_element\": null, ");
+					std::fprintf(out, "\"sorted\": %s}", m.b_sorted ? "true" : "false");
+					b_first = false;
+				}
+			}
+		}
+	}
+}
+
+/*
+* Times the sorts of sorting.h on lists of int, double, std::string and 64-byte records,
+* of 100, 1000, ... up to max_size elements, in the distributions of distribution_keys,
+* and counts their comparisons and moves on elements that count them.
+* Prints a table, and writes every measurement to json_path (unless it is null) as
+* { "schema_version": 1, "compiler": ..., "results": [ { "sort", "type", "distribution", "size", "repetitions",
+*   "ns_per_element", "comparisons_per_element", "moves_per_element", "sorted" }, ... ] },
+* where the counts are null for the sizes above suite_max_counted_size and for radix_sort, which does not compare.
+*
+* Sizes up to 1e9 need max_size = 1000000000 and memory for two copies of the largest list (about 128 GB for the records).
+*/
+void benchmark_sorting_suite(const char* json_path, size_t max_size)
+{
+	FILE* out = json_path ? std::fopen(json_path, "w") : nullptr;
+	if (out)
+	{
+#if defined(_MSC_VER)
+		std::fprintf(out, "{\n  \"schema_version\": %d,\n  \"compiler\": \"msvc %d\",\n  \"results\": [", suite_schema_version, _MSC_VER);
+#elif defined(__VERSION__)
+		std::fprintf(out, "{\n  \"schema_version\": %d,\n  \"compiler\": \"%s\",\n  \"results\": [", suite_schema_version, __VERSION__);
+#else
+		std::fprintf(out, "{\n  \"schema_version\": %d,\n  \"compiler\": \"unknown\",\n  \"results\": [", suite_schema_version);
+#endif
+	}
+
+	std::printf("sorting suite, up to %zu elements%s%s\n", max_size, out ? ", results in " : "", out ? json_path : "");
+	bool b_first = true;
+	run_type<int>("int", max_size, out, b_first);
+	run_type<double>("double", max_size, out, b_first);
+	run_type<std::string>("string", max_size, out, b_first);
+	run_type<record64>("record64", max_size, out, b_first);
+
+	if (out)
+	{
+		std::fprintf(out, "\n  ]\n}\n");
+		std::fclose(out);
+	}
+}
@@ -0,0 +1,339 @@
+/*
+* This file contains the definition of an immutable graph whose adj lists are compressed,
+* for graphs that are too large to be stored with a vertex ref per edge
+*/
+
+#pragma once
+
+#include "graph.h"
+#include "vector.h"
+#include "simd.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace ghl
+{
+	/*
+	* A CSR graph (see ghl::csr_graph) whose adj lists are sorted and compressed into one byte array.
+	*
+	* The list of v is stored from bytes[offsets[v]] on as
+	* 1. its length, as a varint (7 bits per byte, the highest bit set on all bytes but the last)
+	* 2. the gaps between consecutive neighbors (the first neighbor itself for the first gap), in the StreamVByte format:
+	*    groups of 4 gaps, each of which takes 1 to 4 bytes, and whose lengths are given by a control byte (2 bits per gap).
+	*    All control bytes of the list come first, followed by all the gap bytes.
+	*
+	* So an edge takes 1.25 bytes when the neighbors are close to each other (e.g. after ghl::cuthill_mckee_order), and at most 4.25 bytes,
+	* compared to 16 bytes of an indexed_vertex_ref.
+	* Weights take no space if all edges have the same weight, and 4 bytes per edge otherwise.
+	*
+	* The lists are decoded on the fly by for_each_neighbor, 4 gaps at a time with SSSE3 if available.
+	*
+	* Vertices are identified by indices in [0, num_vertices()), where num_vertices() < 2^32. See ghl::indexed_vertex_ref
+	* Is never modified after being constructed.
+	*
+	* Thread-safety: Yes, as long as it is not being assigned to.
+	*/
+	class compressed_csr_graph final
+	{
+	public:
+		compressed_csr_graph() { offsets.push_back(0); pad(); }
+
+		/*
+		* Compresses any indexed graph, i.e. a graph that provides num_vertices(), is_undirected(), and for_each_neighbor()
+		* (e.g. ghl::csr_graph, or ghl::dynamic_graph_snapshot).
+		*
+		* Sorting the lists takes 8 (12 if weighted) extra bytes per edge while constructing.
+		*/
+		template <typename G>
+		explicit compressed_csr_graph(const G& g) :
+			undirected(g.is_undirected()), offsets(g.num_vertices() + 1)
+		{
+			const size_t n = g.num_vertices();
+			_ASSERT(n <= UINT32_MAX);
+
+			// count the refs by their targets, and see if the graph is weighted
+			ghl::vector<size_t> counts(n + 1);
+			for (size_t v = 0; v != n + 1; ++v) counts.push_back(0);
+			bool b_first = true;
+			for (size_t v = 0; v != n; ++v)
+			{
+				g.for_each_neighbor(v, [&](size_t u, float w)
+				{
+					++counts[u + 1];
+					if (b_first) { m_weight = w; b_first = false; }
+					else if (w != m_weight) b_weighted = true;
+				});
+			}
+			for (size_t v = 0; v != n; ++v) counts[v + 1] += counts[v];
+			m_num_refs = counts[n];
+
+			// counting sort the refs by their targets, and then stably by their sources, which sorts every list
+			ghl::vector<uint32_t> by_target(m_num_refs), sorted(m_num_refs);
+			ghl::vector<float> by_target_weights, sorted_weights;
+			by_target.increase_size(m_num_refs);
+			sorted.increase_size(m_num_refs);
+			if (b_weighted)
+			{
+				by_target_weights.resize(m_num_refs);
+				by_target_weights.increase_size(m_num_refs);
+				sorted_weights.resize(m_num_refs);
+				sorted_weights.increase_size(m_num_refs);
+			}
+
+			ghl::vector<size_t> starts(n + 1); // where the list of each source starts in sorted
+			for (size_t v = 0; v != n + 1; ++v) starts.push_back(0);
+			{
+				ghl::vector<size_t> next(counts.begin(), counts.end());
+				for (size_t v = 0; v != n; ++v)
+				{
+					g.for_each_neighbor(v, [&](size_t u, float w)
+					{
+						if (b_weighted) by_target_weights[next[u]] = w;
+						by_target[next[u]++] = (uint32_t)v;
+						++starts[v + 1];
+					});
+				}
+			}
+			for (size_t v = 0; v != n; ++v) starts[v + 1] += starts[v];
+			{
+				ghl::vector<size_t> next(starts.begin(), starts.end());
+				for (size_t t = 0; t != n; ++t)
+				{
+					for (size_t i = counts[t]; i != counts[t + 1]; ++i)
+					{
+						const size_t j = next[by_target[i]]++;
+						sorted[j] = (uint32_t)t;
+						if (b_weighted) sorted_weights[j] = by_target_weights[i];
+					}
+				}
+			}
+
+			// encode the lists
+			offsets.push_back(0);
+			for (size_t v = 0; v != n; ++v)
+			{
+				encode(sorted.begin() + starts[v], starts[v + 1] - starts[v]);
+				offsets.push_back(bytes.size());
+			}
+			pad();
+
+			if (b_weighted)
+			{
+				weight_offsets = ghl::vector<size_t>(starts.begin(), starts.end());
+				weights = std::move(sorted_weights);
+			}
+		}
+
+	public:
+		bool empty() const { return 0 == num_vertices(); }
+		bool is_undirected() const { return undirected; }
+
+		// false iff all edges have the same weight (which is not stored per edge then)
+		bool is_weighted() const { return b_weighted; }
+
+		size_t num_vertices() const { return offsets.size() - 1; }
+		// all edges are stored twice for undirected graph
+		size_t num_edges() const { return undirected ? m_num_refs / 2 : m_num_refs; }
+
+		// @returns the number of bytes used to store the edges (the encoded lists, their offsets, and the weights)
+		size_t size_in_bytes() const
+		{
+			return bytes.size() + offsets.size() * sizeof(size_t) + weights.size() * sizeof(float) + weight_offsets.size() * sizeof(size_t);
+		}
+
+		// @returns the number of refs in the adj list of v (its outdeg if directed, or its deg if undirected)
+		size_t degree(size_t v) const
+		{
+			const uint8_t* p = bytes.begin() + offsets[v];
+			return read_varint(p);
+		}
+
+		/*
+		* Calls f(size_t u, float weight) for every u adj to v, in ascending order of u
+		*/
+		template <typename F>
+		void for_each_neighbor(size_t v, F f) const
+		{
+			const uint8_t* control = bytes.begin() + offsets[v];
+			const size_t count = read_varint(control);
+			const uint8_t* data = control + (count + 3) / 4;
+			const float* w = b_weighted ? weights.begin() + weight_offsets[v] : nullptr;
+
+			uint32_t values[4];
+			uint32_t prev = 0;
+			size_t i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				data = decode_group(*control++, data, prev, values);
+				prev = values[3];
+				for (size_t k = 0; k != 4; ++k)
+				{
+					f((size_t)values[k], b_weighted ? w[i + k] : m_weight);
+				}
+			}
+
+			// the last group, which has fewer than 4 gaps
+			if (i != count)
+			{
+				const uint8_t c = *control;
+				for (size_t k = 0; i != count; ++i, ++k)
+				{
+					const size_t length = ((c >> (2 * k)) & 3) + 1;
+					uint32_t gap = 0;
+					for (size_t b = 0; b != length; ++b) gap |= (uint32_t)data[b] << (8 * b);
+					data += length;
+
+					prev += gap;
+					f((size_t)prev, b_weighted ? w[i] : m_weight);
+				}
+			}
+		}
+
+	private:
+		// lookup tables of all 256 control bytes
+		struct decode_table
+		{
+			decode_table()
+			{
+				for (size_t c = 0; c != 256; ++c)
+				{
+					uint8_t pos = 0;
+					for (size_t k = 0; k != 4; ++k)
+					{
+						const uint8_t length = (uint8_t)(((c >> (2 * k)) & 3) + 1);
+						for (uint8_t b = 0; b != 4; ++b)
+						{
+							shuffles[c][4 * k + b] = b < length ? (uint8_t)(pos + b) : 0xFF; // 0xFF zeros the byte
+						}
+						pos += length;
+					}
+					lengths[c] = pos;
+				}
+			}
+
+			// shuffles[c] moves the gap bytes of a group into 4 uint32s for _mm_shuffle_epi8
+			alignas(16) uint8_t shuffles[256][16];
+			// the number of gap bytes of a group
+			uint8_t lengths[256];
+		};
+
+		static const decode_table& table()
+		{
+			static const decode_table t;
+			return t;
+		}
+
+		/*
+		* Decodes the group of 4 gaps at data described by control, adds them up from prev into values,
+		* and returns the position after the group
+		*/
+		static const uint8_t* decode_group(uint8_t control, const uint8_t* data, uint32_t prev, uint32_t* values)
+		{
+			const decode_table& t = table();
+
+#ifdef GHL_SSSE3
+			// reads up to 12 bytes past the group, which stay in the array thanks to the padding
+			__m128i gaps = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), _mm_load_si128((const __m128i*)t.shuffles[control]));
+
+			// prefix sums
+			gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 4));
+			gaps = _mm_add_epi32(gaps, _mm_slli_si128(gaps, 8));
+			_mm_storeu_si128((__m128i*)values, _mm_add_epi32(gaps, _mm_set1_epi32((int)prev)));
+#else
+			const uint8_t* p = data;
+			for (size_t k = 0; k != 4; ++k)
+			{
+				const size_t length = ((control >> (2 * k)) & 3) + 1;
+				uint32_t gap = 0;
+				for (size_t b = 0; b != length; ++b) gap |= (uint32_t)p[b] << (8 * b);
+				p += length;
+
+				prev += gap;
+				values[k] = prev;
+			}
+#endif
+
+			return data + t.lengths[control];
+		}
+
+		static size_t read_varint(const uint8_t*& p)
+		{
+			size_t res = 0;
+			for (unsigned shift = 0; ; shift += 7)
+			{
+				const uint8_t b = *p++;
+				res |= (size_t)(b & 0x7F) << shift;
+				if (0 == (b & 0x80)) return res;
+			}
+		}
+
+		void write_varint(size_t x)
+		{
+			while (x >= 0x80)
+			{
+				bytes.push_back((uint8_t)(x | 0x80));
+				x >>= 7;
+			}
+			bytes.push_back((uint8_t)x);
+		}
+
+		// appends the encoding of the sorted list list[0, count) to bytes
+		void encode(const uint32_t* list, size_t count)
+		{
+			const size_t num_controls = (count + 3) / 4;
+			reserve(10 + num_controls + 4 * count); // a varint of 64 bits takes at most 10 bytes
+
+			write_varint(count);
+
+			// the control bytes are filled while the gaps are written
+			const size_t control_begin = bytes.size();
+			for (size_t i = 0; i != num_controls; ++i) bytes.push_back(0);
+
+			uint32_t prev = 0;
+			for (size_t i = 0; i != count; ++i)
+			{
+				uint32_t gap = list[i] - prev;
+				prev = list[i];
+
+				const size_t length = gap < (1u << 8) ? 1 : gap < (1u << 16) ? 2 : gap < (1u << 24) ? 3 : 4;
+				bytes[control_begin + i / 4] |= (uint8_t)((length - 1) << (2 * (i % 4)));
+				for (size_t b = 0; b != length; ++b, gap >>= 8) bytes.push_back((uint8_t)gap);
+			}
+		}
+
+		// makes room for at least extra more bytes, growing geometrically (as push_back grows the vector by one)
+		void reserve(size_t extra)
+		{
+			if (bytes.size() + extra > bytes.capacity())
+			{
+				size_t new_capacity = bytes.capacity() * 2;
+				if (new_capacity < bytes.size() + extra) new_capacity = bytes.size() + extra;
+				bytes.resize(new_capacity);
+			}
+		}
+
+		// appends the 16 bytes a group decoded by SIMD may read past the end of the lists
+		void pad()
+		{
+			reserve(16);
+			for (size_t i = 0; i != 16; ++i) bytes.push_back(0);
+		}
+
+	private:
+		bool undirected = false;
+		bool b_weighted = false;
+		// the weight of every edge if not weighted
+		float m_weight = 0.0f;
+		size_t m_num_refs = 0;
+
+		// of size num_vertices() + 1, where the encoded list of v is bytes[offsets[v], offsets[v+1])
+		ghl::vector<size_t> offsets;
+		ghl::vector<uint8_t> bytes;
+
+		// only used if weighted, where the weight of the i^th neighbor of v is weights[weight_offsets[v] + i]
+		ghl::vector<size_t> weight_offsets;
+		ghl::vector<float> weights;
+	};
+}
@@ -0,0 +1,187 @@
+/*
+* This file contains the definition of an immutable graph stored in the compressed sparse row format
+*/
+
+#pragma once
+
+#include "graph.h"
+#include "vector.h"
+
+namespace ghl
+{
+	/*
+	* A graph stored in the compressed sparse row (CSR) format:
+	* the adj lists of all vertices are stored one after another in one array (neighbors),
+	* and the list of v is found by neighbors[offsets[v], offsets[v+1]).
+	*
+	* Vertices are identified by indices in [0, num_vertices()). See ghl::indexed_vertex_ref
+	* Is never modified after being constructed. To change its edges, build a new one (or use ghl::dynamic_graph).
+	*
+	* If undirected, every edge {a,b} is stored twice as a ref to b in the list of a and a ref to a in the list of b.
+	*
+	* Thread-safety: Yes, as long as it is not being assigned to.
+	*/
+	class csr_graph final
+	{
+	public:
+		csr_graph() { offsets.push_back(0); }
+
+		/*
+		* Copies any indexed graph, i.e. a graph that provides num_vertices(), is_undirected(), and for_each_neighbor()
+		* (e.g. ghl::dynamic_graph_snapshot, or another csr_graph)
+		*/
+		template <typename G>
+		explicit csr_graph(const G& g) :
+			undirected(g.is_undirected()), offsets(g.num_vertices() + 1)
+		{
+			const size_t n = g.num_vertices();
+
+			size_t num_refs = 0;
+			offsets.push_back(0);
+			for (size_t v = 0; v != n; ++v)
+			{
+				g.for_each_neighbor(v, [&num_refs](size_t, float) { ++num_refs; });
+				offsets.push_back(num_refs);
+			}
+
+			neighbors.resize(num_refs);
+			for (size_t v = 0; v != n; ++v)
+			{
+				g.for_each_neighbor(v, [this](size_t u, float w) { neighbors.emplace_back(u, w); });
+			}
+		}
+
+		/*
+		* Builds the CSR of a graph of vertex_ids (e.g. ghl::adj_list_graph_ds), which must provide for_each_vertex(), for_each_edge(), and is_undirected().
+		* The vertices are given indices in the order for_each_vertex() visits them (which is the order of their ids for adj_list_graph_ds).
+		*
+		* @param ids where ids[v] = the id of the vertex whose index is v (assumed to be empty when passed in)
+		*/
+		template <typename G>
+		static csr_graph from_id_graph(const G& g, ghl::vector<uint64_t>& ids)
+		{
+			csr_graph res;
+			res.undirected = g.is_undirected();
+
+			g.for_each_vertex([&ids](const auto& v) { ids.push_back(v.observe().id.id); });
+			const size_t n = ids.size();
+
+			// ids are visited in ascending order by adj_list_graph_ds, but we do not rely on it
+			std::map<uint64_t, size_t> index_of;
+			for (size_t v = 0; v != n; ++v) index_of.emplace(ids[v], v);
+
+			ghl::vector<size_t> counts(n + 1);
+			for (size_t v = 0; v != n + 1; ++v) counts.push_back(0);
+			size_t num_refs = 0;
+			g.for_each_edge([&](const auto& l, const auto&, float) { ++counts[index_of[l.observe().id.id] + 1]; ++num_refs; });
+			for (size_t v = 0; v != n; ++v) counts[v + 1] += counts[v];
+
+			res.offsets = ghl::vector<size_t>(counts.begin(), counts.end());
+			res.neighbors.resize(num_refs);
+			res.neighbors.increase_size(num_refs);
+			g.for_each_edge([&](const auto& l, const auto& r, float w)
+			{
+				res.neighbors[counts[index_of[l.observe().id.id]]++] = indexed_vertex_ref(index_of[r.observe().id.id], w);
+			});
+
+			return res;
+		}
+
+	public:
+		bool empty() const { return 0 == num_vertices(); }
+		bool is_undirected() const { return undirected; }
+
+		size_t num_vertices() const { return offsets.size() - 1; }
+		// all edges are stored twice for undirected graph
+		size_t num_edges() const { return undirected ? neighbors.size() / 2 : neighbors.size(); }
+
+		// @returns the number of refs in the adj list of v (its outdeg if directed, or its deg if undirected)
+		size_t degree(size_t v) const { return offsets[v + 1] - offsets[v]; }
+
+		/*
+		* Direct access to the adj list of v, which is [adj_begin(v), adj_end(v))
+		*/
+		const indexed_vertex_ref* adj_begin(size_t v) const { return neighbors.begin() + offsets[v]; }
+		const indexed_vertex_ref* adj_end(size_t v) const { return neighbors.begin() + offsets[v + 1]; }
+
+		/*
+		* Calls f(size_t u, float weight) for every u adj to v
+		*/
+		template <typename F>
+		void for_each_neighbor(size_t v, F f) const
+		{
+			for (auto i = adj_begin(v), e = adj_end(v); i != e; ++i)
+			{
+				f(i->v, i->weight);
+			}
+		}
+
+		/*
+		* @returns the graph with every vertex v renamed to new_index[v], which must be a permutation of [0, num_vertices()).
+		* The order of each adj list is kept.
+		*/
+		csr_graph relabeled(const ghl::vector<size_t>& new_index) const
+		{
+			const size_t n = num_vertices();
+
+			csr_graph res;
+			res.undirected = undirected;
+
+			// old_index[new_index[v]] = v
+			ghl::vector<size_t> old_index(n);
+			old_index.increase_size(n);
+			for (size_t v = 0; v != n; ++v) old_index[new_index[v]] = v;
+
+			res.offsets.resize(n + 1);
+			res.neighbors.resize(neighbors.size());
+			for (size_t nv = 0; nv != n; ++nv)
+			{
+				const size_t v = old_index[nv];
+				for (auto i = adj_begin(v), e = adj_end(v); i != e; ++i)
+				{
+					res.neighbors.emplace_back(new_index[i->v], i->weight);
+				}
+				res.offsets.push_back(res.neighbors.size());
+			}
+
+			return res;
+		}
+
+		/*
+		* @returns the graph with every edge reversed, whose adj lists are the in edges of this graph.
+		* Each list is sorted in ascending order of the indices. An undirected graph is its own transpose.
+		*/
+		csr_graph transposed() const
+		{
+			const size_t n = num_vertices();
+
+			csr_graph res;
+			res.undirected = undirected;
+
+			ghl::vector<size_t> counts(n + 1);
+			for (size_t v = 0; v != n + 1; ++v) counts.push_back(0);
+			for (const auto& r : neighbors) ++counts[r.v + 1];
+			for (size_t v = 0; v != n; ++v) counts[v + 1] += counts[v];
+
+			res.offsets = ghl::vector<size_t>(counts.begin(), counts.end());
+			res.neighbors.resize(neighbors.size());
+			res.neighbors.increase_size(neighbors.size());
+			for (size_t v = 0; v != n; ++v)
+			{
+				for (auto i = adj_begin(v), e = adj_end(v); i != e; ++i)
+				{
+					res.neighbors[counts[i->v]++] = indexed_vertex_ref(v, i->weight);
+				}
+			}
+
+			return res;
+		}
+
+	private:
+		bool undirected = false;
+
+		// of size num_vertices() + 1, where offsets[0] = 0 and offsets[num_vertices()] = neighbors.size()
+		ghl::vector<size_t> offsets;
+		ghl::vector<indexed_vertex_ref> neighbors;
+	};
+}
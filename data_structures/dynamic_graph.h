@@ -0,0 +1,344 @@
+/*
+* This file contains the definition of a graph that keeps changing while being read,
+* whose readers work on immutable snapshots of it.
+*/
+
+#pragma once
+
+#include "graph.h"
+#include "vector.h"
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace ghl
+{
+	/*
+	* An insertion (b_insert = true) or a deletion (b_insert = false) of the edge (left, right)
+	* (or {left, right} for undirected graphs), which is applied to a dynamic_graph in batches.
+	*
+	* weight is ignored for deletions.
+	*/
+	struct edge_update
+	{
+		edge_update() {}
+		edge_update(size_t l, size_t r, float wt = 0.0f, bool b_ins = true) : left(l), right(r), weight(wt), b_insert(b_ins) {}
+
+		size_t left = 0, right = 0;
+		float weight = 0.0f;
+		bool b_insert = true;
+	};
+
+	/*
+	* An immutable version of a dynamic_graph.
+	*
+	* Vertices are identified by indices in [0, num_vertices()). See ghl::indexed_vertex_ref
+	*
+	* The adj lists are stored in blocks of block_size consecutive vertices, each of which is a small CSR
+	* (compressed sparse row: the lists of the vertices are stored one after another in one array, and are found by an offset array).
+	* A block is shared by all snapshots in which it is unchanged, so that publishing a new snapshot only copies the blocks a batch touched.
+	*
+	* Thread-safety: Yes, as it is never modified after being published.
+	*/
+	class dynamic_graph_snapshot
+	{
+		friend class dynamic_graph;
+
+	public:
+		// the number of vertices in a block
+		static constexpr size_t block_size = 256;
+
+		struct adj_block
+		{
+			// the adj list of the i^th vertex of the block is neighbors[offsets[i], offsets[i+1])
+			// it may contain fewer than block_size + 1 offsets for the last block, in which case the missing vertices have no edges.
+			ghl::vector<size_t> offsets;
+			ghl::vector<indexed_vertex_ref> neighbors;
+		};
+
+	public:
+		dynamic_graph_snapshot() {}
+		~dynamic_graph_snapshot() {}
+
+	public:
+		bool empty() const { return 0 == m_num_vertices; }
+		bool is_undirected() const { return undirected; }
+
+		size_t num_vertices() const { return m_num_vertices; }
+		// all edges are stored twice for undirected graph
+		size_t num_edges() const { return undirected ? m_num_refs / 2 : m_num_refs; }
+
+		// the number of batches applied before this snapshot was published
+		uint64_t version() const { return m_version; }
+
+		/*
+		* @returns the number of refs in the adj list of v (its outdeg if directed, or its deg if undirected). 0 if v is out of range.
+		*/
+		size_t degree(size_t v) const
+		{
+			size_t begin, end;
+			return find_range(v, begin, end) ? end - begin : 0;
+		}
+
+		/*
+		* Calls f(size_t u, float weight) for every u adj to v. Does nothing if v is out of range.
+		*/
+		template <typename F>
+		void for_each_neighbor(size_t v, F f) const
+		{
+			size_t begin, end;
+			if (find_range(v, begin, end))
+			{
+				const auto& neighbors = blocks[v / block_size]->neighbors;
+				for (size_t i = begin; i != end; ++i)
+				{
+					f(neighbors[i].v, neighbors[i].weight);
+				}
+			}
+		}
+
+	private:
+		// @returns false iff v has no adj list stored, and sets [begin, end) to the range of its list in its block otherwise.
+		bool find_range(size_t v, size_t& begin, size_t& end) const
+		{
+			if (v >= m_num_vertices) return false;
+
+			const auto& block = blocks[v / block_size];
+			size_t local = v % block_size;
+			if (nullptr == block || local + 1 >= block->offsets.size()) return false;
+
+			begin = block->offsets[local];
+			end = block->offsets[local + 1];
+			return true;
+		}
+
+	private:
+		bool undirected = false;
+		uint64_t m_version = 0;
+
+		size_t m_num_vertices = 0;
+		size_t m_num_refs = 0;
+
+		// nullptr for a block that has no edges
+		ghl::vector<std::shared_ptr<const adj_block>> blocks;
+	};
+
+	/*
+	* A graph whose edges are inserted and deleted in batches by writers, while readers run algorithms on consistent snapshots of it.
+	*
+	* Each batch is applied by copying only the blocks it touches (copy-on-write) and then publishing a new snapshot atomically,
+	* so algorithms (e.g. BFS, PageRank) run on a snapshot without any lock, and are never affected by later batches once it is got.
+	* Getting the snapshot itself may briefly lock inside the standard library, whose atomic operations on shared_ptr are not lock-free
+	* (a mutex pool in libstdc++, a spin lock in MSVC), but never waits for a batch being applied.
+	*
+	* Vertices are identified by indices. Referencing an index >= num_vertices() in a batch adds vertices up to it.
+	* Deleting an edge that is not present does nothing. If multiple edges of the same endpoints are present, the earliest inserted one is deleted.
+	*
+	* Thread-safety: Yes. Batches from multiple writers are applied one at a time.
+	*/
+	class dynamic_graph
+	{
+	public:
+		using snapshot_t = std::shared_ptr<const dynamic_graph_snapshot>;
+		using block_t = dynamic_graph_snapshot::adj_block;
+		static constexpr size_t block_size = dynamic_graph_snapshot::block_size;
+
+	public:
+		dynamic_graph() : dynamic_graph(false) {}
+		explicit dynamic_graph(bool b_undirected)
+		{
+			auto first = std::make_shared<dynamic_graph_snapshot>();
+			first->undirected = b_undirected;
+			current = first;
+		}
+
+		dynamic_graph(const dynamic_graph&) = delete;
+		dynamic_graph& operator=(const dynamic_graph&) = delete;
+
+		~dynamic_graph() {}
+
+	public:
+		/*
+		* @returns the latest published snapshot, which stays valid and unchanged as long as it is held.
+		* Briefly locks inside std::atomic_load, which is not lock-free for shared_ptr
+		*/
+		snapshot_t snapshot() const { return std::atomic_load(&current); }
+
+		/*
+		* Makes the graph have at least n vertices
+		*/
+		void add_vertices(size_t n)
+		{
+			apply_batch(ghl::vector<edge_update>(), n);
+		}
+
+		/*
+		* Applies all updates of batch in order, and publishes the result as a new snapshot.
+		*
+		* O(size of batch + number of blocks + number of refs in the touched blocks)
+		*/
+		void apply_batch(const ghl::vector<edge_update>& batch)
+		{
+			apply_batch(batch, 0);
+		}
+
+	private:
+		void apply_batch(const ghl::vector<edge_update>& batch, size_t min_vertices)
+		{
+			std::lock_guard<std::mutex> lock(writer_mutex);
+
+			auto old = std::atomic_load(&current);
+			const bool undirected = old->undirected;
+
+			size_t n = old->m_num_vertices > min_vertices ? old->m_num_vertices : min_vertices;
+			for (const auto& u : batch)
+			{
+				auto larger = u.left > u.right ? u.left : u.right;
+				if (larger + 1 > n) n = larger + 1;
+			}
+			const size_t num_blocks = (n + block_size - 1) / block_size;
+
+			// an undirected update is applied to the lists of both endpoints
+			const size_t num_refs = undirected ? batch.size() * 2 : batch.size();
+
+			// group the (directed) updates by their blocks with a stable counting sort,
+			// so that the updates of a vertex are applied in the order given
+			ghl::vector<size_t> starts(num_blocks + 1);
+			for (size_t b = 0; b != num_blocks + 1; ++b) starts.push_back(0);
+			for (const auto& u : batch)
+			{
+				++starts[u.left / block_size + 1];
+				if (undirected) ++starts[u.right / block_size + 1];
+			}
+			for (size_t b = 0; b != num_blocks; ++b) starts[b + 1] += starts[b];
+
+			ghl::vector<edge_update> grouped(num_refs);
+			grouped.increase_size(num_refs);
+			{
+				ghl::vector<size_t> next(starts.begin(), starts.end());
+				for (const auto& u : batch)
+				{
+					grouped[next[u.left / block_size]++] = u;
+					if (undirected) grouped[next[u.right / block_size]++] = edge_update(u.right, u.left, u.weight, u.b_insert);
+				}
+			}
+
+			auto res = std::make_shared<dynamic_graph_snapshot>();
+			res->undirected = undirected;
+			res->m_version = old->m_version + 1;
+			res->m_num_vertices = n;
+			res->m_num_refs = old->m_num_refs;
+			res->blocks.resize(num_blocks);
+
+			for (size_t b = 0; b != num_blocks; ++b)
+			{
+				std::shared_ptr<const block_t> old_block = b < old->blocks.size() ? old->blocks[b] : nullptr;
+
+				if (starts[b] == starts[b + 1]) // untouched, share it
+				{
+					res->blocks.push_back(old_block);
+				}
+				else
+				{
+					res->blocks.push_back(rebuild_block(old_block.get(), b * block_size, n, grouped, starts[b], starts[b + 1], res->m_num_refs));
+				}
+			}
+
+			std::atomic_store(&current, snapshot_t(std::move(res)));
+		}
+
+		/*
+		* @returns a copy of old_block (nullptr = no edges) which covers the vertices from first_vertex on,
+		* with the updates in grouped[begin, end) applied, and adjusts num_refs accordingly
+		*/
+		static std::shared_ptr<const block_t> rebuild_block
+		(
+			const block_t* old_block, size_t first_vertex, size_t n,
+			const ghl::vector<edge_update>& grouped, size_t begin, size_t end,
+			size_t& num_refs
+		)
+		{
+			const size_t count = (n - first_vertex < block_size) ? n - first_vertex : block_size;
+			const size_t old_count = nullptr == old_block ? 0 : old_block->offsets.size() - 1;
+
+			// group the updates again by the vertices in the block
+			ghl::vector<size_t> starts(count + 1);
+			for (size_t i = 0; i != count + 1; ++i) starts.push_back(0);
+			size_t num_inserts = 0;
+			for (size_t i = begin; i != end; ++i)
+			{
+				++starts[grouped[i].left - first_vertex + 1];
+				if (grouped[i].b_insert) ++num_inserts;
+			}
+			for (size_t i = 0; i != count; ++i) starts[i + 1] += starts[i];
+
+			ghl::vector<size_t> order(end - begin);
+			order.increase_size(end - begin);
+			{
+				ghl::vector<size_t> next(starts.begin(), starts.end());
+				for (size_t i = begin; i != end; ++i)
+				{
+					order[next[grouped[i].left - first_vertex]++] = i;
+				}
+			}
+
+			auto res = std::make_shared<block_t>();
+			res->offsets.resize(count + 1);
+			res->neighbors.resize((nullptr == old_block ? 0 : old_block->neighbors.size()) + num_inserts);
+
+			res->offsets.push_back(0);
+			for (size_t i = 0; i != count; ++i)
+			{
+				const size_t list_begin = res->neighbors.size();
+
+				// copy the old list
+				if (i < old_count)
+				{
+					for (size_t j = old_block->offsets[i]; j != old_block->offsets[i + 1]; ++j)
+					{
+						res->neighbors.push_back(old_block->neighbors[j]);
+					}
+				}
+
+				// apply the updates of the vertex to the copy
+				for (size_t k = starts[i]; k != starts[i + 1]; ++k)
+				{
+					const auto& u = grouped[order[k]];
+					if (u.b_insert)
+					{
+						res->neighbors.push_back(indexed_vertex_ref(u.right, u.weight));
+						++num_refs;
+					}
+					else
+					{
+						for (size_t j = list_begin; j != res->neighbors.size(); ++j)
+						{
+							if (res->neighbors[j].v == u.right) // remove it by moving the rest of the list forward
+							{
+								for (size_t l = j; l + 1 != res->neighbors.size(); ++l)
+								{
+									res->neighbors[l] = res->neighbors[l + 1];
+								}
+								res->neighbors.remove_back();
+								--num_refs;
+								break;
+							}
+						}
+					}
+				}
+
+				res->offsets.push_back(res->neighbors.size());
+			}
+
+			return res;
+		}
+
+	private:
+		// serializes the writers
+		std::mutex writer_mutex;
+
+		// accessed only through std::atomic_load and std::atomic_store
+		snapshot_t current;
+	};
+}
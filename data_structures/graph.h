@@ -3,6 +3,8 @@
 #include "list.h"
 // will replace std::map with my own map in the future (probably after I learn map in the courses)
 #include <map>
+// used for the optional neighbor indices of adj_list_graph_ds
+#include <unordered_map>
 
 #include <string> // for char_traits
 
@@ -331,6 +333,22 @@ namespace ghl
 	template <typename T>
 	using float_weighted_edge = edge<T, float>;
 
+	/*
+	* Used by graphs whose vertices are identified by dense indices in [0, num_vertices()), instead of by vertex_id,
+	* (e.g. ghl::dynamic_graph) to reference the other endpoint of an edge in an adj list.
+	* 
+	* Such graphs provide num_vertices() and for_each_neighbor(v, f) which calls f(size_t u, float weight) for every u adj to v,
+	* which is all the algorithms on them in graph_operations.h need.
+	*/
+	struct indexed_vertex_ref
+	{
+		indexed_vertex_ref() {}
+		indexed_vertex_ref(size_t in_v, float wt = 0.0f) : v(in_v), weight(wt) {}
+
+		size_t v = 0;
+		float weight = 0.0f;
+	};
+
 	/*
 	* ADT graph:
 	* Represents mathematically any graph.
@@ -360,6 +378,9 @@ namespace ghl
 	*		g. given the ID of a vertex, T provides get_adj_in_edges() that fills all vertices adj to the vertex in edges of the passed in list
 	*		h. get_all_vertices which takes a reference to a list of weak_ref_t and stored references to all vertices in it
 	*		i. get_all_edges which takes a reference to a list of edge_t and stored references to all edges in it (for undirected maps, all edges are stored twice, with two possible orders of the endpoints)
+	*		i'. for_each_vertex(f), for_each_edge(f), and for_each_neighbor(ID, f) that do the same as g., h., and i. 
+	*	but call f on each result directly instead of materializing it in a list (so no allocation is made). 
+	*	f is called with (weak_ref_t) for vertices, (weak_ref_t left, weak_ref_t right, W weight) for edges, and (weak_ref_t right, W weight) for neighbors.
 	*		j. num_vertices() and num_edges()
 	*		k. empty()
 	*		l. is_undirected()
@@ -421,6 +442,13 @@ namespace ghl
 		inline void get_all_vertices(ghl::list<weak_ref_t>& in_list) const { imp->get_all_vertices(in_list); }
 		inline void get_all_edges(ghl::list<edge_t>& in_list) const { imp->get_all_edges(in_list); }
 
+		template <typename ID, typename F>
+		inline void for_each_neighbor(ID id, F f) const { imp->for_each_neighbor(id, f); }
+		template <typename F>
+		inline void for_each_vertex(F f) const { imp->for_each_vertex(f); }
+		template <typename F>
+		inline void for_each_edge(F f) const { imp->for_each_edge(f); }
+
 	private:
 		// the actual implementation
 		std::unique_ptr<T> imp;
@@ -434,6 +462,10 @@ namespace ghl
 	* If used as undirected, then the two endpoint vertices both have a ref to each other in adj lists.
 	* 
 	* Supports adding weight to edges. If not set, all weights are by default 0.0f
+	* 
+	* Optionally, a vertex whose adj list has at least index_threshold refs gets a hashed index of its neighbors,
+	* which is kept in sync on adding and removing edges, so that has_edge, get_edge, and remove_edge are O(1) expected for it, instead of O(deg).
+	* index_threshold = 0 (the default) disables the indices.
 	*/
 	template <typename T>
 	class adj_list_graph_ds
@@ -476,10 +508,19 @@ namespace ghl
 
 	private:
 		using pair_t = std::pair<vertex_t, ghl::list<vertex_ref>>;
+		using map_t = std::map<vertex_t, ghl::list<vertex_ref>, std::less<>>;
+		using entry_t = typename map_t::value_type;
+		using ref_iter_t = typename ghl::list<vertex_ref>::iterator;
+		// maps the id of a neighbor to the refs to it in an adj list (more than one for multigraphs)
+		using index_t = std::unordered_multimap<uint64_t, ref_iter_t>;
 
 	public:
 		adj_list_graph_ds() {}
 		explicit adj_list_graph_ds(bool b_undirected) : undirected(b_undirected) {}
+		/*
+		* @param in_index_threshold the size an adj list must reach for its vertex to get a neighbor index. 0 means never.
+		*/
+		adj_list_graph_ds(bool b_undirected, size_t in_index_threshold) : undirected(b_undirected), index_threshold(in_index_threshold) {}
 
 		~adj_list_graph_ds() {}
 
@@ -529,7 +570,8 @@ namespace ghl
 				for (auto& pair : vertices_and_lists)
 				{
 					auto& adj_list = pair.second;
-					for (auto iter = adj_list.begin(); iter != adj_list.end(); ++iter)
+					auto* p_index = find_index(pair.first);
+					for (auto iter = adj_list.begin(); iter != adj_list.end(); /* incremented below */)
 					{
 						if (*(iter->v) == id)
 						{
@@ -543,15 +585,34 @@ namespace ghl
 								--(pair.first.outdeg);
 							}
 
+							if (nullptr != p_index)
+							{
+								index_erase(*p_index, id, iter);
+							}
+
 							iter = adj_list.remove(iter); // remove the vertex ref and update iter
 						}
+						else
+						{
+							++iter;
+						}
+					}
+				}
+
+				// for directed graph, the vertices it leads to lose an in edge each
+				if (!undirected)
+				{
+					for (const auto& v_ref : i->second)
+					{
+						--(v_ref.v->indeg);
 					}
+				}
 
-					// after all refs are gone, remove the vertex and its adj_list
-					vertices_and_lists.erase(i);
+				// after all refs are gone, remove the vertex, its adj_list, and its index
+				indices.erase(id);
+				vertices_and_lists.erase(i);
 
-					return true;
-				}				
+				return true;
 			}
 
 			return false;
@@ -595,13 +656,13 @@ namespace ghl
 				if (undirected) // add the edge to the list of both left and right
 				{
 					++(li->first.deg); ++(ri->first.deg);
-					li->second.emplace_back(ri->first, weight);
-					ri->second.emplace_back(li->first, weight);
+					index_insert(*li, li->second.emplace_back(ri->first, weight));
+					index_insert(*ri, ri->second.emplace_back(li->first, weight));
 				}
 				else // add the edge to only the list of left
 				{
 					++(li->first.outdeg); ++(ri->first.indeg);
-					li->second.emplace_back(ri->first, weight);
+					index_insert(*li, li->second.emplace_back(ri->first, weight));
 				}
 
 				return true;
@@ -630,13 +691,7 @@ namespace ghl
 			auto i = vertices_and_lists.find(left);
 			if (i != vertices_and_lists.end())
 			{
-				for (const auto& edge : i->second)
-				{
-					if (*(edge.v) == right) // edges in adj lists can never be invalid
-					{
-						return true;
-					}
-				}
+				return find_ref(*i, right) != i->second.end();
 			}
 			return false;
 		}
@@ -652,12 +707,10 @@ namespace ghl
 			auto i = vertices_and_lists.find(left);
 			if (i != vertices_and_lists.end())
 			{
-				for (const auto& edge : i->second)
+				auto iter = find_ref(*i, right);
+				if (iter != i->second.end())
 				{
-					if (*(edge.v) == right) // edges in adj lists can never be invalid
-					{
-						return float_weighted_edge<T>(i->first, *(edge.v), edge.weight);
-					}
+					return float_weighted_edge<T>(i->first, *(iter->v), iter->weight);
 				}
 			}
 
@@ -679,36 +732,28 @@ namespace ghl
 
 				auto& l_adj_list = il->second;
 				// right should appear in left's adj list for regardless of the graph being directed or undirected.
-				bool edge_found = false;
-				auto liter = l_adj_list.begin();
-				for (; liter != l_adj_list.end(); ++liter)
-				{
-					if (*(liter->v) == right)
-					{
-						edge_found = true;
-						break;
-					}
-				}
+				auto liter = find_ref(*il, right);
 
-				if (edge_found) // now liter should point to the right vertex
+				if (liter != l_adj_list.end()) // now liter should point to the right vertex
 				{
+					const uint64_t lid = il->first.id.id, rid = ir->first.id.id;
+
 					if (undirected) // need to remove the edge from both left's and right's list
 					{
 						// update deg
 						--(il->first.deg); --(ir->first.deg);
 
 						// remove right from left's list
+						index_erase(il->first, rid, liter);
 						l_adj_list.remove(liter);
 
 						// remove left from right's list
 						auto& r_adj_list = ir->second;
-						for (auto riter = r_adj_list.begin(); riter != r_adj_list.end(); ++riter)
+						auto riter = find_ref(*ir, left);
+						if (riter != r_adj_list.end())
 						{
-							if (*(riter->v) == left)
-							{
-								r_adj_list.remove(riter);
-								break;
-							}
+							index_erase(ir->first, lid, riter);
+							r_adj_list.remove(riter);
 						}
 					}
 					else // need to remove the edge from only left's list
@@ -716,6 +761,7 @@ namespace ghl
 						--(il->first.outdeg); --(ir->first.indeg);
 						
 						// remove right from left's list
+						index_erase(il->first, rid, liter);
 						l_adj_list.remove(liter);
 					}
 
@@ -776,10 +822,156 @@ namespace ghl
 			}
 		}
 
+		/*
+		* The following three are the allocation free versions of get_all_vertices, get_all_edges, and get_adj_in_edges.
+		* Instead of filling a list, they call f on each result directly, so that no list node or edge_t is constructed.
+		* 
+		* f must not add or remove vertices or edges of this graph during the iteration.
+		*/
+
+		/*
+		* Calls f(weak_ref_t v) for every vertex v
+		*/
+		template <typename F>
+		void for_each_vertex(F f) const
+		{
+			for (const auto& p : vertices_and_lists)
+			{
+				f(weak_ref_t(p.first));
+			}
+		}
+		/*
+		* Calls f(weak_ref_t left, weak_ref_t right, float weight) for every edge
+		* 
+		* Note that for undirected map, all edges {a,b} are visited twice as {a,b} and {b,a}
+		*/
+		template <typename F>
+		void for_each_edge(F f) const
+		{
+			for (const auto& p : vertices_and_lists)
+			{
+				weak_ref_t left(p.first);
+				for (const auto& v_ref : p.second)
+				{
+					f(left, weak_ref_t(*(v_ref.v)), v_ref.weight);
+				}
+			}
+		}
+		/*
+		* V has to be one of: vertex_t, weak_ref_t, or the types that can result in a vertex id
+		* 
+		* Calls f(weak_ref_t right, float weight) for every vertex right adj to v. Does nothing if v is not found.
+		*/
+		template <typename V, typename F>
+		void for_each_neighbor(V v, F f) const
+		{
+			auto i = vertices_and_lists.find(v);
+
+			if (i != vertices_and_lists.end())
+			{
+				for (const auto& v_ref : i->second)
+				{
+					f(weak_ref_t(*(v_ref.v)), v_ref.weight);
+				}
+			}
+		}
+
+	private:
+		/*
+		* The following are helpers for the neighbor indices
+		*/
+
+		// the id of a vertex given by one of the types V accepted above
+		static uint64_t id_of(uint64_t id) { return id; }
+		static uint64_t id_of(const char* name) { return vertex_id::name_to_id(name); }
+		static uint64_t id_of(vertex_id id) { return id.id; }
+		static uint64_t id_of(const vertex_t& v) { return v.id.id; }
+		static uint64_t id_of(const weak_ref_t& v) { return v.observe().id.id; }
+
+		// @returns the index of v, or nullptr if v has none
+		index_t* find_index(const vertex_t& v)
+		{
+			auto i = indices.find(v.id.id);
+			return i != indices.end() ? &(i->second) : nullptr;
+		}
+
+		/*
+		* @returns an iterator to a ref to right in the adj list of p, or the end of the list if there is none.
+		* O(1) expected if p.first is indexed, and O(deg) otherwise
+		*/
+		template <typename V>
+		ref_iter_t find_ref(entry_t& p, V right)
+		{
+			if (auto* p_index = find_index(p.first))
+			{
+				auto i = p_index->find(id_of(right));
+				return i != p_index->end() ? i->second : p.second.end();
+			}
+
+			for (auto iter = p.second.begin(); iter != p.second.end(); ++iter)
+			{
+				if (*(iter->v) == right) // edges in adj lists can never be invalid
+				{
+					return iter;
+				}
+			}
+			return p.second.end();
+		}
+
+		/*
+		* Records iter, which has just been added to the adj list of p, in the index of p.first.
+		* If p.first has no index but its list has reached the threshold, builds one for it.
+		*/
+		void index_insert(entry_t& p, ref_iter_t iter)
+		{
+			if (auto* p_index = find_index(p.first))
+			{
+				p_index->emplace(iter->v->id.id, iter);
+			}
+			// the deg is used instead of p.second.size(), which is O(deg)
+			else if (0 != index_threshold && (undirected ? p.first.deg : p.first.outdeg) >= index_threshold)
+			{
+				auto& index = indices[p.first.id.id];
+				auto& adj_list = p.second;
+				for (auto i = adj_list.begin(); i != adj_list.end(); ++i)
+				{
+					index.emplace(i->v->id.id, i);
+				}
+			}
+		}
+
+		// removes the entry of iter, which refs the vertex of right_id and is about to be removed from the adj list of v
+		void index_erase(const vertex_t& v, uint64_t right_id, const ref_iter_t& iter)
+		{
+			if (auto* p_index = find_index(v))
+			{
+				index_erase(*p_index, right_id, iter);
+			}
+		}
+		static void index_erase(index_t& index, uint64_t right_id, const ref_iter_t& iter)
+		{
+			auto range = index.equal_range(right_id);
+			for (auto i = range.first; i != range.second; ++i)
+			{
+				if (i->second == iter)
+				{
+					index.erase(i);
+					return;
+				}
+			}
+		}
+
 	private:
 		// true = undirected, false = directed
 		bool undirected = true;
 
-		std::map<vertex_t, ghl::list<vertex_ref>, std::less<>> vertices_and_lists;
+		// 0 = no vertex is indexed
+		size_t index_threshold = 0;
+
+		map_t vertices_and_lists;
+
+		// the neighbor indices of the vertices whose adj lists have reached index_threshold, keyed by their ids.
+		// an index is dropped only when its vertex is removed
+		std::unordered_map<uint64_t, index_t> indices;
 	};
 }
\ No newline at end of file
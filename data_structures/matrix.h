@@ -0,0 +1,336 @@
+/*
+* This file contains the definition of a dense matrix stored in one contiguous, aligned allocation, and of views of it,
+* which the DP algorithms use as their tables, and of a matrix of 2-bit values for their tracebacks
+*/
+
+#pragma once
+
+#include "simd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // std::memcpy
+#include <new> // std::align_val_t
+#include <type_traits>
+#include <utility>
+
+namespace ghl
+{
+	/*
+	* A view of the elements of a matrix, or of a part of it (e.g. a tile), which it does not own:
+	* the element (i, j) is at data()[i * row_stride() + j * column_stride()].
+	*
+	* Thread-safety: the same as the matrix it views
+	*/
+	template <typename T>
+	class matrix_view final
+	{
+	public:
+		matrix_view() = default;
+		matrix_view(T* data, size_t rows, size_t columns, ptrdiff_t row_stride, ptrdiff_t column_stride) :
+			mp_data(data), m_rows(rows), m_columns(columns), m_row_stride(row_stride), m_column_stride(column_stride) {}
+
+	public:
+		inline size_t rows() const { return m_rows; }
+		inline size_t columns() const { return m_columns; }
+		inline ptrdiff_t row_stride() const { return m_row_stride; }
+		inline ptrdiff_t column_stride() const { return m_column_stride; }
+		inline T* data() const { return mp_data; }
+
+		inline T& operator()(size_t i, size_t j) const { return mp_data[(ptrdiff_t)i * m_row_stride + (ptrdiff_t)j * m_column_stride]; }
+
+		/*
+		* @returns the view of the rows x columns elements from (i, j), e.g. a tile
+		*/
+		matrix_view block(size_t i, size_t j, size_t rows, size_t columns) const
+		{
+			return matrix_view(&(*this)(i, j), rows, columns, m_row_stride, m_column_stride);
+		}
+
+		// @returns the view of the row i, as a 1 x columns() matrix
+		matrix_view row(size_t i) const { return block(i, 0, 1, m_columns); }
+		// @returns the view of the column j, as a rows() x 1 matrix
+		matrix_view column(size_t j) const { return block(0, j, m_rows, 1); }
+
+		// @returns the view of the transpose, where (i, j) is the element (j, i) of this
+		matrix_view transposed() const { return matrix_view(mp_data, m_columns, m_rows, m_column_stride, m_row_stride); }
+
+		/*
+		* Calls f(tile, i, j) for the tiles of tile_rows x tile_columns elements that cover the view, in row-major order,
+		* where (i, j) is where the tile begins. The tiles of the last row and column may be smaller
+		*/
+		template <typename F>
+		void for_each_tile(size_t tile_rows, size_t tile_columns, F f) const
+		{
+			for (size_t i = 0; i < m_rows; i += tile_rows)
+			{
+				const size_t rows = m_rows - i < tile_rows ? m_rows - i : tile_rows;
+				for (size_t j = 0; j < m_columns; j += tile_columns)
+				{
+					f(block(i, j, rows, m_columns - j < tile_columns ? m_columns - j : tile_columns), i, j);
+				}
+			}
+		}
+
+	private:
+		T* mp_data = nullptr;
+		size_t m_rows = 0, m_columns = 0;
+		ptrdiff_t m_row_stride = 0, m_column_stride = 1;
+	};
+
+	/*
+	* ADT matrix
+	* underlying DS: one array, row-major
+	*
+	* A rows x columns matrix of trivially copyable objects of type T (e.g. the tables of DP algorithms),
+	* allocated at once instead of row by row: the element (i, j) is at data()[i * row_stride() + j].
+	* Every row starts at a multiple of alignment bytes (when sizeof(T) divides it), so it may be loaded by aligned vectors
+	* and does not share a cache line with the previous one; row_stride() >= columns() counts the padding.
+	*
+	* Rep Invariant:
+	* 1. row_stride >= columns
+	* 2. start != nullptr iff rows * row_stride != 0
+	*
+	* Thread-safety: No
+	*/
+	template <typename T>
+	class matrix final
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "the elements of a matrix are copied as bytes");
+
+	public:
+		// the alignment of the rows, in bytes: a cache line, which is also enough for the widest vectors
+		static constexpr size_t alignment = 64;
+
+		matrix() = default;
+
+		/*
+		* @param rows the number of rows
+		* @param columns the number of columns
+		* @param value the value of every element
+		*/
+		matrix(size_t rows, size_t columns, const T& value = T()) :
+			m_rows(rows), m_columns(columns), m_row_stride(stride_of(columns))
+		{
+			allocate();
+			fill(value);
+		}
+
+		matrix(const matrix& other) :
+			m_rows(other.m_rows), m_columns(other.m_columns), m_row_stride(other.m_row_stride)
+		{
+			allocate();
+			if (nullptr != mp_start) std::memcpy(mp_start, other.mp_start, sizeof(T) * m_rows * m_row_stride);
+		}
+
+		matrix(matrix&& other) noexcept :
+			m_rows(other.m_rows), m_columns(other.m_columns), m_row_stride(other.m_row_stride), mp_start(other.mp_start)
+		{
+			other.m_rows = other.m_columns = other.m_row_stride = 0;
+			other.mp_start = nullptr;
+		}
+
+		~matrix() noexcept { deallocate(); }
+
+		matrix& operator=(const matrix& right)
+		{
+			if (this != &right)
+			{
+				matrix copy(right);
+				swap(copy);
+			}
+			return *this;
+		}
+
+		matrix& operator=(matrix&& right) noexcept
+		{
+			matrix moved(std::move(right));
+			swap(moved);
+			return *this;
+		}
+
+	public:
+		inline size_t rows() const { return m_rows; }
+		inline size_t columns() const { return m_columns; }
+		inline size_t row_stride() const { return m_row_stride; }
+		static constexpr size_t column_stride() { return 1; }
+		inline bool empty() const { return 0 == m_rows || 0 == m_columns; }
+
+		inline T* data() { return mp_start; }
+		inline const T* data() const { return mp_start; }
+
+		// @returns the row i, whose columns() elements are contiguous, so that m[i][j] is the element (i, j)
+		inline T* operator[](size_t i) { _ASSERT(i < m_rows); return mp_start + i * m_row_stride; }
+		inline const T* operator[](size_t i) const { _ASSERT(i < m_rows); return mp_start + i * m_row_stride; }
+
+		inline T& operator()(size_t i, size_t j) { _ASSERT(i < m_rows && j < m_columns); return mp_start[i * m_row_stride + j]; }
+		inline const T& operator()(size_t i, size_t j) const { _ASSERT(i < m_rows && j < m_columns); return mp_start[i * m_row_stride + j]; }
+
+		matrix_view<T> view() { return matrix_view<T>(mp_start, m_rows, m_columns, (ptrdiff_t)m_row_stride, 1); }
+		matrix_view<const T> view() const { return matrix_view<const T>(mp_start, m_rows, m_columns, (ptrdiff_t)m_row_stride, 1); }
+
+		// sets every element, and the padding, to value
+		void fill(const T& value)
+		{
+			for (size_t k = 0; k != m_rows * m_row_stride; ++k) mp_start[k] = value;
+		}
+
+		void swap(matrix& other) noexcept
+		{
+			std::swap(m_rows, other.m_rows);
+			std::swap(m_columns, other.m_columns);
+			std::swap(m_row_stride, other.m_row_stride);
+			std::swap(mp_start, other.mp_start);
+		}
+
+	private:
+		// @returns columns rounded up to the elements of a multiple of alignment bytes, if they divide it
+		static size_t stride_of(size_t columns)
+		{
+			if (0 != alignment % sizeof(T)) return columns;
+			constexpr size_t per_line = alignment / sizeof(T);
+			return (columns + per_line - 1) / per_line * per_line;
+		}
+
+		void allocate()
+		{
+			const size_t count = m_rows * m_row_stride;
+			mp_start = 0 == count ? nullptr : (T*)::operator new(sizeof(T) * count, std::align_val_t(alignment));
+		}
+
+		void deallocate() noexcept
+		{
+			if (nullptr != mp_start) ::operator delete(mp_start, std::align_val_t(alignment));
+			mp_start = nullptr;
+		}
+
+	private:
+		size_t m_rows = 0, m_columns = 0, m_row_stride = 0;
+		T* mp_start = nullptr;
+	};
+
+	/*
+	* ADT packed matrix
+	* underlying DS: a matrix of 64-bit words, row-major
+	*
+	* A rows x columns matrix of values of 2 bits (0 to 3) of a type T of one byte, e.g. the directions of a DP traceback,
+	* which takes a quarter of the memory of matrix<T>: the element (i, j) is the bits 2 * (j % 32) and above of the word j / 32 of the row i.
+	* Rows are written at once by store_row, which packs the bytes of a row with SIMD, and elements are read one by one.
+	*
+	* Rep Invariant:
+	* 1. the bits of the words past columns are 0
+	*
+	* Thread-safety: No
+	*/
+	template <typename T>
+	class packed_matrix final
+	{
+		static_assert(1 == sizeof(T) && std::is_trivially_copyable<T>::value, "the elements of a packed matrix are bytes of 2 bits");
+
+	public:
+		// the number of elements in a word
+		static constexpr size_t per_word = 32;
+
+		// a row, whose operator[] reads the element j
+		class row_reader
+		{
+		public:
+			explicit row_reader(const uint64_t* words) : mp_words(words) {}
+			inline T operator[](size_t j) const { return (T)((mp_words[j / per_word] >> (j % per_word * 2)) & 3); }
+
+		private:
+			const uint64_t* mp_words;
+		};
+
+		packed_matrix() = default;
+
+		/*
+		* @param rows the number of rows
+		* @param columns the number of columns
+		* (every element is T(0))
+		*/
+		packed_matrix(size_t rows, size_t columns) : m_words(rows, (columns + per_word - 1) / per_word), m_columns(columns) {}
+
+	public:
+		inline size_t rows() const { return m_words.rows(); }
+		inline size_t columns() const { return m_columns; }
+		inline bool empty() const { return 0 == rows() || 0 == m_columns; }
+
+		// the words, row i from words().data() + i * words().row_stride()
+		inline const matrix<uint64_t>& words() const { return m_words; }
+
+		inline row_reader operator[](size_t i) const { return row_reader(m_words[i]); }
+		inline T operator()(size_t i, size_t j) const { _ASSERT(j < m_columns); return (*this)[i][j]; }
+
+		void set(size_t i, size_t j, T value)
+		{
+			_ASSERT(j < m_columns);
+			uint64_t& word = m_words[i][j / per_word];
+			const unsigned shift = (unsigned)(j % per_word * 2);
+			word = (word & ~((uint64_t)3 << shift)) | (uint64_t)((unsigned char)value & 3) << shift;
+		}
+
+		/*
+		* Sets the row i to values[0, columns()), which must all be 0 to 3
+		*/
+		void store_row(size_t i, const T* values)
+		{
+			pack((const unsigned char*)values, m_columns, m_words[i]);
+		}
+
+		/*
+		* Packs the count values, 0 to 3, into the (count + 31) / 32 words, the first value in the lowest bits,
+		* and the bits past count of the last word 0
+		*/
+		static void pack(const unsigned char* values, size_t count, uint64_t* words)
+		{
+			size_t k = 0;
+#if defined(GHL_AVX2)
+			// 32 bytes to a word: pairs of bytes are added as b0 + 4 * b1, pairs of those as h0 + 16 * h1,
+			// leaving 4 values in the low byte of every 32-bit lane, which are gathered
+			const __m256i gather = _mm256_setr_epi8(
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+				0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+			for (; k + per_word <= count; k += per_word)
+			{
+				__m256i v = _mm256_loadu_si256((const __m256i*)(values + k));
+				v = _mm256_madd_epi16(_mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0401)), _mm256_set1_epi32(0x00100001));
+				v = _mm256_shuffle_epi8(v, gather);
+				words[k / per_word] = (uint64_t)(uint32_t)_mm256_cvtsi256_si32(v)
+					| (uint64_t)(uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(v, 1)) << 32;
+			}
+#elif defined(GHL_SSSE3)
+			// the same, 16 bytes to half a word
+			const __m128i gather = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+			for (; k + per_word <= count; k += per_word)
+			{
+				uint64_t word = 0;
+				for (size_t half = 0; half != 2; ++half)
+				{
+					__m128i v = _mm_loadu_si128((const __m128i*)(values + k + half * 16));
+					v = _mm_madd_epi16(_mm_maddubs_epi16(v, _mm_set1_epi16(0x0401)), _mm_set1_epi32(0x00100001));
+					word |= (uint64_t)(uint32_t)_mm_cvtsi128_si32(_mm_shuffle_epi8(v, gather)) << (half * 32);
+				}
+				words[k / per_word] = word;
+			}
+#endif
+			// 8 bytes at a time in a word, folded into 16 bits
+			for (; k < count; k += 8)
+			{
+				uint64_t x = 0;
+				std::memcpy(&x, values + k, count - k < 8 ? count - k : 8);
+				x = (x | x >> 6) & 0x000F000F000F000Full;
+				x = (x | x >> 12) & 0x000000FF000000FFull;
+				x = (x | x >> 24) & 0xFFFFull;
+
+				const size_t shift = k % per_word * 2;
+				if (0 == shift) words[k / per_word] = x;
+				else words[k / per_word] |= x << shift;
+			}
+		}
+
+	private:
+		matrix<uint64_t> m_words;
+		size_t m_columns = 0;
+	};
+}
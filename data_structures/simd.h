@@ -0,0 +1,33 @@
+/*
+* This file detects the SIMD instruction sets the algorithms and data structures may use at compile time,
+* and includes their intrinsics.
+*
+* Defines GHL_SSE2 if SSE2 is available (always the case for x64),
+* GHL_SSSE3 if SSSE3 is enabled for the compiler (/arch:AVX or higher, or -mssse3),
+* GHL_SSE41 if SSE4.1 is enabled for the compiler (/arch:AVX or higher, or -msse4.1),
+* and GHL_AVX2 if AVX2 is enabled for the compiler (/arch:AVX2 or -mavx2).
+*
+* Code that uses them must keep a scalar version for when they are not defined.
+*/
+
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GHL_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(GHL_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#define GHL_SSSE3
+#include <tmmintrin.h>
+#endif
+
+#if defined(GHL_SSSE3) && (defined(__SSE4_1__) || defined(__AVX__))
+#define GHL_SSE41
+#include <smmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define GHL_AVX2
+#include <immintrin.h>
+#endif
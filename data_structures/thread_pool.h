@@ -0,0 +1,188 @@
+/*
+* This file contains the definition of a pool of worker threads for fork-join parallelism
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ghl
+{
+	/*
+	* A fixed set of worker threads that run the tasks submitted to them in FIFO order.
+	*
+	* A thread that waits for tasks (see ghl::task_group and parallel_for) runs pending tasks itself while waiting,
+	* so tasks may submit and wait for other tasks (fork-join) without deadlocking, even on a pool of one thread.
+	*
+	* Tasks must not throw.
+	*
+	* Thread-safety: Yes
+	*/
+	class thread_pool final
+	{
+	public:
+		/*
+		* @param num_threads the number of worker threads. 0 means std::thread::hardware_concurrency()
+		*/
+		explicit thread_pool(unsigned num_threads = 0)
+		{
+			if (0 == num_threads) num_threads = std::thread::hardware_concurrency();
+			if (0 == num_threads) num_threads = 1;
+
+			m_num_threads = num_threads;
+			workers.reset(new std::thread[num_threads]);
+			for (unsigned i = 0; i != num_threads; ++i)
+			{
+				workers[i] = std::thread([this]() { work(); });
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		// waits for all pending tasks to finish
+		~thread_pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				b_stopping = true;
+			}
+			has_task.notify_all();
+			for (unsigned i = 0; i != m_num_threads; ++i) workers[i].join();
+		}
+
+	public:
+		unsigned num_threads() const { return m_num_threads; }
+
+		/*
+		* Queues f(), which is run by a worker (or a waiting thread) later
+		*/
+		template <typename F>
+		void submit(F&& f)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.emplace_back(std::forward<F>(f));
+			}
+			has_task.notify_one();
+		}
+
+		/*
+		* Runs one pending task on the calling thread
+		*
+		* @returns false iff there was no pending task
+		*/
+		bool run_pending_task()
+		{
+			std::function<void()> task;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (tasks.empty()) return false;
+				task = std::move(tasks.front());
+				tasks.pop_front();
+			}
+			task();
+			return true;
+		}
+
+		/*
+		* Calls f(size_t lo, size_t hi) for consecutive blocks [lo, hi) of at most grain indices that cover [begin, end), in parallel.
+		* The calling thread takes part, and returns when all blocks are done.
+		*/
+		template <typename F>
+		void parallel_for(size_t begin, size_t end, size_t grain, F f);
+
+	private:
+		void work()
+		{
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					has_task.wait(lock, [this]() { return b_stopping || !tasks.empty(); });
+					if (tasks.empty()) return; // stopping, and nothing is left to do
+
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				task();
+			}
+		}
+
+	private:
+		unsigned m_num_threads = 0;
+		std::unique_ptr<std::thread[]> workers;
+
+		std::mutex mutex;
+		std::condition_variable has_task;
+		std::deque<std::function<void()>> tasks;
+		bool b_stopping = false;
+	};
+
+	/*
+	* A set of tasks run on a thread_pool, which can be waited for together.
+	*
+	* Thread-safety: run() may be called from any thread, including from the tasks of the group. wait() is called once, by the owner.
+	*/
+	class task_group final
+	{
+	public:
+		explicit task_group(thread_pool& p) : pool(p) {}
+
+		task_group(const task_group&) = delete;
+		task_group& operator=(const task_group&) = delete;
+
+		~task_group() { wait(); }
+
+	public:
+		template <typename F>
+		void run(F f)
+		{
+			++pending;
+			pool.submit([this, f]() mutable
+			{
+				f();
+				--pending;
+			});
+		}
+
+		/*
+		* Returns when all tasks of the group are done, running pending tasks of the pool meanwhile
+		*/
+		void wait()
+		{
+			while (0 != pending)
+			{
+				if (!pool.run_pending_task()) std::this_thread::yield();
+			}
+		}
+
+	private:
+		thread_pool& pool;
+		std::atomic<size_t> pending{ 0 };
+	};
+
+	template <typename F>
+	void thread_pool::parallel_for(size_t begin, size_t end, size_t grain, F f)
+	{
+		if (begin >= end) return;
+		if (0 == grain) grain = 1;
+
+		task_group group(*this);
+		size_t lo = begin;
+		// the calling thread takes the last block
+		for (; end - lo > grain; lo += grain)
+		{
+			group.run([lo, grain, &f]() { f(lo, lo + grain); });
+		}
+		f(lo, end);
+		group.wait();
+	}
+}
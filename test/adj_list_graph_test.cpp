@@ -481,6 +481,111 @@ DEFINE_TEST_CASE(test_adj_graph_get_directedly_connected_edges)
 
 ENDDEF_TEST_CASE
 
+DEFINE_TEST_CASE(test_adj_graph_for_each)
+
+	ghl::adj_list_graph_ds<int> g(false);
+
+	g.add_vertex("a", 1);
+	g.add_vertex("b", 2);
+	g.add_vertex("c", 3);
+
+	g.add_edge("a", "b", .1f);
+	g.add_edge("a", "c", .2f);
+	g.add_edge("c", "b", .4f);
+
+	// vertices
+	{
+		int sum = 0; size_t count = 0;
+		g.for_each_vertex([&](ghl::vertex_weak_ref<int> v) { sum += *(v.observe().obj); ++count; });
+
+		ASSERT_EQUALS(3, count, "expected to visit all vertices")
+		ASSERT_EQUALS(6, sum, "expected to visit each vertex once")
+	}
+
+	// edges
+	{
+		float sum = 0.0f; size_t count = 0; bool all_valid = true;
+		g.for_each_edge([&](ghl::vertex_weak_ref<int> l, ghl::vertex_weak_ref<int> r, float w) { sum += w; ++count; all_valid = all_valid && l.valid() && r.valid(); });
+
+		ASSERT_EQUALS(3, count, "expected to visit all edges")
+		ASSERT_TRUE(sum > .69f && sum < .71f, "expected to visit each edge once")
+		ASSERT_TRUE(all_valid, "expected to get valid endpoints")
+	}
+
+	// neighbors
+	{
+		int sum = 0; float w_sum = 0.0f;
+		g.for_each_neighbor("a", [&](ghl::vertex_weak_ref<int> r, float w) { sum += *(r.observe().obj); w_sum += w; });
+
+		ASSERT_EQUALS(5, sum, "expected to visit b and c")
+		ASSERT_TRUE(w_sum > .29f && w_sum < .31f, "expected to get the weights right")
+
+		size_t count = 0;
+		g.for_each_neighbor("b", [&](ghl::vertex_weak_ref<int>, float) { ++count; });
+		ASSERT_EQUALS(0, count, "expected to visit nothing for a vertex without out edges")
+
+		g.for_each_neighbor("x", [&](ghl::vertex_weak_ref<int>, float) { ++count; });
+		ASSERT_EQUALS(0, count, "expected to visit nothing for an absent vertex")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_adj_graph_neighbor_index)
+
+	// undirected graph whose hub gets indexed after its 2nd edge
+	{
+		ghl::adj_list_graph_ds<int> g(true, 2);
+
+		g.add_vertex("hub", 0);
+		g.add_vertex("a", 1);
+		g.add_vertex("b", 2);
+		g.add_vertex("c", 3);
+
+		g.add_edge("hub", "a", .1f);
+		ASSERT_TRUE(g.has_edge("hub", "a"), "expected to find the edge before indexing")
+
+		g.add_edge("hub", "b", .2f);
+		g.add_edge("c", "hub", .3f);
+		g.add_edge("hub", "a", .4f); // a parallel edge
+
+		ASSERT_TRUE(g.has_edge("hub", "a") && g.has_edge("hub", "b") && g.has_edge("hub", "c"), "expected to find the edges by the index")
+		ASSERT_TRUE(g.has_edge("c", "hub"), "expected to find the edge from the other side")
+		ASSERT_FALSE(g.has_edge("hub", "hub"), "expected to not find an absent edge")
+		ASSERT_TRUE(g.get_edge("hub", "b").weight == .2f, "expected to get the edge by the index")
+
+		// removes one of the parallel edges
+		ASSERT_TRUE(g.remove_edge("hub", "a"), "expected to remove the edge")
+		ASSERT_TRUE(g.has_edge("hub", "a") && g.has_edge("a", "hub"), "expected to keep the parallel edge")
+		ASSERT_TRUE(g.remove_edge("a", "hub"), "expected to remove the edge")
+		ASSERT_FALSE(g.has_edge("hub", "a") || g.has_edge("a", "hub"), "expected to remove both refs")
+		ASSERT_FALSE(g.remove_edge("hub", "a"), "expected to fail to remove an absent edge")
+		ASSERT_EQUALS(2, g.num_edges(), "expected to have 2 edges left")
+
+		// removing a vertex drops its refs from the index
+		g.remove_vertex("b");
+		ASSERT_FALSE(g.has_edge("hub", "b"), "expected to remove the ref from the index")
+		ASSERT_TRUE(g.has_edge("hub", "c"), "expected to keep the other refs")
+		ASSERT_EQUALS(1, g.num_edges(), "expected to have 1 edge left")
+		ASSERT_EQUALS(1, g.find_vertex("hub").observe().deg, "expected to have the deg right")
+	}
+
+	// directed graph
+	{
+		ghl::adj_list_graph_ds<int> g(false, 1);
+
+		g.add_vertex("a", 1);
+		g.add_vertex("b", 2);
+
+		g.add_edge("a", "b", .5f);
+		ASSERT_TRUE(g.has_edge("a", "b"), "expected to find the edge")
+		ASSERT_FALSE(g.has_edge("b", "a"), "expected to not find the reversed edge")
+		ASSERT_TRUE(g.remove_edge("a", "b"), "expected to remove the edge")
+		ASSERT_FALSE(g.has_edge("a", "b"), "expected to remove the edge from the index")
+		ASSERT_EQUALS(0, g.find_vertex("a").observe().outdeg, "expected to have the deg right")
+	}
+
+ENDDEF_TEST_CASE
+
 void test_adj_list_graph_ds()
 {
 	ghl::test_unit ctor_dtor
@@ -496,9 +601,12 @@ void test_adj_list_graph_ds()
 		{
 			&test_adj_graph_add_vertex,
 			&test_adj_graph_remove_vertex,
+			&test_adj_graph_remove_vertex_with_edges,
 			&test_adj_graph_add_edge,
 			&test_adj_graph_remove_edge,
-			&test_adj_graph_get_directedly_connected_edges
+			&test_adj_graph_get_directedly_connected_edges,
+			&test_adj_graph_for_each,
+			&test_adj_graph_neighbor_index
 		},
 		"tests for operations of adj_list_graph_ds"
 	};
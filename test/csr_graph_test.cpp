@@ -0,0 +1,201 @@
+// tests for class csr_graph and compressed_csr_graph
+
+#include "../data_structures/csr_graph.h"
+#include "../data_structures/compressed_csr_graph.h"
+#include "../data_structures/dynamic_graph.h"
+#include "../unit_test/test_unit.h"
+
+#include <iostream>
+
+namespace
+{
+	// @returns true iff g has the edge (l, r) of weight w
+	bool has_edge(const ghl::csr_graph& g, size_t l, size_t r, float w)
+	{
+		bool found = false;
+		g.for_each_neighbor(l, [&](size_t u, float wt) { found = found || (u == r && wt == w); });
+		return found;
+	}
+}
+
+DEFINE_TEST_CASE(test_csr_graph_ctor)
+
+	// an empty graph
+	{
+		ghl::csr_graph g;
+		ASSERT_TRUE(g.empty(), "expected to get an empty graph")
+		ASSERT_EQUALS(0, g.num_edges(), "expected to have no edges")
+	}
+
+	// copied from an indexed graph
+	{
+		ghl::dynamic_graph d(false);
+		d.apply_batch({ {0, 1, .5f}, {0, 2, .25f}, {2, 1, 1.0f} });
+		d.add_vertices(4);
+
+		ghl::csr_graph g(*d.snapshot());
+
+		ASSERT_EQUALS(4, g.num_vertices(), "expected to have all vertices")
+		ASSERT_EQUALS(3, g.num_edges(), "expected to have all edges")
+		ASSERT_EQUALS(2, g.degree(0), "expected to have the deg right")
+		ASSERT_EQUALS(0, g.degree(3), "expected to have the deg right")
+		ASSERT_TRUE(has_edge(g, 0, 1, .5f) && has_edge(g, 0, 2, .25f) && has_edge(g, 2, 1, 1.0f), "expected to have the edges")
+		ASSERT_EQUALS(2, g.adj_end(0) - g.adj_begin(0), "expected to access the adj list directly")
+	}
+
+	// built from a graph of vertex ids
+	{
+		ghl::adj_list_graph_ds<int> a(true);
+		a.add_vertex("b", 2);
+		a.add_vertex("a", 1);
+		a.add_vertex("c", 3);
+		a.add_edge("a", "b", .1f);
+		a.add_edge("b", "c", .2f);
+
+		ghl::vector<uint64_t> ids;
+		auto g = ghl::csr_graph::from_id_graph(a, ids);
+
+		ASSERT_EQUALS(3, ids.size(), "expected to give every vertex an index")
+		ASSERT_TRUE(g.is_undirected(), "expected to keep the graph undirected")
+		ASSERT_EQUALS(2, g.num_edges(), "expected to have all edges")
+
+		size_t ia = 0, ib = 0, ic = 0;
+		for (size_t v = 0; v != 3; ++v)
+		{
+			if (ids[v] == ghl::vertex_id::name_to_id("a")) ia = v;
+			if (ids[v] == ghl::vertex_id::name_to_id("b")) ib = v;
+			if (ids[v] == ghl::vertex_id::name_to_id("c")) ic = v;
+		}
+		ASSERT_TRUE(has_edge(g, ia, ib, .1f) && has_edge(g, ib, ia, .1f), "expected to have the edge in both lists")
+		ASSERT_TRUE(has_edge(g, ib, ic, .2f) && has_edge(g, ic, ib, .2f), "expected to have the edge in both lists")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_csr_graph_relabel_and_transpose)
+
+	ghl::dynamic_graph d(false);
+	d.apply_batch({ {0, 1, 1.0f}, {0, 2, 2.0f}, {1, 2, 3.0f}, {3, 0, 4.0f} });
+	ghl::csr_graph g(*d.snapshot());
+
+	// relabeling
+	{
+		ghl::vector<size_t> new_index{ 3, 1, 0, 2 };
+		auto r = g.relabeled(new_index);
+
+		ASSERT_EQUALS(4, r.num_vertices(), "expected to keep the vertices")
+		ASSERT_EQUALS(4, r.num_edges(), "expected to keep the edges")
+		ASSERT_TRUE(has_edge(r, 3, 1, 1.0f) && has_edge(r, 3, 0, 2.0f) && has_edge(r, 1, 0, 3.0f) && has_edge(r, 2, 3, 4.0f), "expected to rename the edges")
+		ASSERT_EQUALS(2, r.degree(3), "expected to move the adj lists")
+	}
+
+	// transposing
+	{
+		auto t = g.transposed();
+
+		ASSERT_EQUALS(4, t.num_edges(), "expected to keep the edges")
+		ASSERT_TRUE(has_edge(t, 1, 0, 1.0f) && has_edge(t, 2, 0, 2.0f) && has_edge(t, 2, 1, 3.0f) && has_edge(t, 0, 3, 4.0f), "expected to reverse the edges")
+		ASSERT_EQUALS(0, t.degree(3), "expected to have the in deg right")
+		ASSERT_TRUE(t.adj_begin(2)->v == 0 && (t.adj_begin(2) + 1)->v == 1, "expected to sort the lists")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_compressed_csr_graph)
+
+	// an empty graph
+	{
+		ghl::compressed_csr_graph g;
+		ASSERT_TRUE(g.empty(), "expected to get an empty graph")
+		ASSERT_EQUALS(0, g.num_edges(), "expected to have no edges")
+	}
+
+	// a graph whose lists have gaps of 1 to 3 bytes and groups of every size, with a hub of 1000 neighbors
+	{
+		ghl::dynamic_graph d(false);
+		ghl::vector<ghl::edge_update> batch;
+		const size_t far[] = { 0, 3, 300, 70000, 200000 };
+		for (size_t v = 0; v != 5; ++v)
+		{
+			// v has v + 1 neighbors, inserted in descending order
+			for (size_t i = v + 1; i > 0; --i) batch.emplace_back(v, far[i - 1] + v);
+		}
+		for (size_t i = 0; i != 1000; ++i) batch.emplace_back(5, (i * 7919) % 1000);
+		d.apply_batch(batch);
+		ghl::csr_graph g(*d.snapshot());
+		ghl::compressed_csr_graph c(g);
+
+		ASSERT_EQUALS(g.num_vertices(), c.num_vertices(), "expected to keep the vertices")
+		ASSERT_EQUALS(g.num_edges(), c.num_edges(), "expected to keep the edges")
+		ASSERT_TRUE(!c.is_weighted(), "expected to not store the weights")
+
+		// the lists are the same after sorting
+		auto t = g.transposed().transposed();
+		for (size_t v = 0; v != 6; ++v)
+		{
+			ASSERT_EQUALS(t.degree(v), c.degree(v), "expected to keep the deg")
+
+			auto i = t.adj_begin(v);
+			bool b_same = true;
+			c.for_each_neighbor(v, [&](size_t u, float w) { b_same = b_same && u == i->v && w == i->weight; ++i; });
+			ASSERT_TRUE(b_same && i == t.adj_end(v), "expected to decode the sorted list")
+		}
+	}
+
+	// a clique, whose gaps all take 1 byte
+	{
+		ghl::dynamic_graph d(true);
+		ghl::vector<ghl::edge_update> batch;
+		for (size_t i = 0; i != 30; ++i)
+		{
+			for (size_t j = i + 1; j != 30; ++j) batch.emplace_back(i, j, 1.0f);
+		}
+		d.apply_batch(batch);
+		ghl::csr_graph g(*d.snapshot());
+		ghl::compressed_csr_graph c(g);
+
+		ASSERT_EQUALS(29, c.degree(7), "expected to keep the deg")
+		ASSERT_TRUE(c.size_in_bytes() * 4 < (g.num_vertices() + 1) * sizeof(size_t) + 2 * g.num_edges() * sizeof(ghl::indexed_vertex_ref), "expected to take much less space than the csr")
+	}
+
+	// a weighted undirected graph
+	{
+		ghl::dynamic_graph d(true);
+		d.apply_batch({ {0, 3, 1.0f}, {0, 1, 2.0f}, {0, 2, 3.0f}, {0, 4, 4.0f}, {0, 5, 5.0f}, {2, 1, 6.0f} });
+		ghl::compressed_csr_graph c(*d.snapshot());
+
+		ASSERT_TRUE(c.is_weighted(), "expected to store the weights")
+		ASSERT_EQUALS(6, c.num_edges(), "expected to keep the edges")
+
+		ghl::vector<size_t> neighbors;
+		ghl::vector<float> weights;
+		c.for_each_neighbor(0, [&](size_t u, float w) { neighbors.push_back(u); weights.push_back(w); });
+		ASSERT_EQUALS(5, neighbors.size(), "expected to have all neighbors")
+		for (size_t i = 0; i != 5; ++i)
+		{
+			ASSERT_EQUALS(i + 1, neighbors[i], "expected to sort the list")
+		}
+		ASSERT_TRUE(weights[0] == 2.0f && weights[2] == 1.0f && weights[4] == 5.0f, "expected to keep the weights with the neighbors")
+
+		bool found = false;
+		c.for_each_neighbor(1, [&](size_t u, float w) { found = found || (2 == u && 6.0f == w); });
+		ASSERT_TRUE(found, "expected to store undirected edges both ways")
+	}
+
+ENDDEF_TEST_CASE
+
+void test_csr_graph()
+{
+	ghl::test_unit unit
+	{
+		{
+			&test_csr_graph_ctor,
+			&test_csr_graph_relabel_and_transpose,
+			&test_compressed_csr_graph
+		},
+		"tests for csr_graph"
+	};
+
+	unit.execute();
+	std::cout << unit.get_msg() << "\n";
+}
@@ -1,8 +1,138 @@
 #include "../algorithms/dynamic_programming.h"
 #include "../unit_test/test_unit.h"
+#include "../data_structures/thread_pool.h"
 #include "../data_structures/vector.h"
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// the length of the LCS by the full (m+1) x (n+1) matrix
+	int lcs_length_by_matrix(const ghl::vector<char>& first, const ghl::vector<char>& second)
+	{
+		const size_t m = first.size(), n = second.size();
+		ghl::vector<int> lengths((m + 1) * (n + 1));
+		for (size_t k = 0; k != (m + 1) * (n + 1); ++k) lengths.push_back(0);
+		for (size_t i = 1; i <= m; ++i)
+		{
+			for (size_t j = 1; j <= n; ++j)
+			{
+				const int top = lengths[(i - 1) * (n + 1) + j], left = lengths[i * (n + 1) + j - 1];
+				lengths[i * (n + 1) + j] = first[i - 1] == second[j - 1] ? lengths[(i - 1) * (n + 1) + j - 1] + 1 : (top >= left ? top : left);
+			}
+		}
+		return lengths[m * (n + 1) + n];
+	}
+
+	// @returns true iff sub is a subsequence of sequence
+	bool is_subsequence(const ghl::vector<char>& sub, const ghl::vector<char>& sequence)
+	{
+		size_t i = 0;
+		for (size_t j = 0; j != sequence.size() && i != sub.size(); ++j)
+		{
+			if (sub[i] == sequence[j]) ++i;
+		}
+		return i == sub.size();
+	}
+
+	/*
+	* The score of the best alignment by the full Gotoh matrices, where h[i][0] and h[0][j] are the gaps of the global alignment,
+	* or 0 where the mode skips them
+	*/
+	int alignment_score_by_matrix(const ghl::vector<int>& flat, size_t m, size_t n, ghl::gap_penalty gap, ghl::alignment_mode mode)
+	{
+		const int minus_infinity = -1000000;
+		const bool b_local = ghl::alignment_mode::local == mode;
+		std::vector<std::vector<int>> h(m + 1, std::vector<int>(n + 1)), e = h, f = h;
+		for (size_t i = 0; i <= m; ++i)
+		{
+			for (size_t j = 0; j <= n; ++j)
+			{
+				e[i][j] = f[i][j] = minus_infinity;
+				if (0 == i && 0 == j) h[i][j] = 0;
+				else if (0 == i) h[i][j] = ghl::alignment_mode::global == mode ? gap.open + (int)j * gap.extend : 0;
+				else if (0 == j) h[i][j] = b_local ? 0 : gap.open + (int)i * gap.extend;
+				else
+				{
+					e[i][j] = std::max(e[i][j - 1] + gap.extend, h[i][j - 1] + gap.open + gap.extend);
+					f[i][j] = std::max(f[i - 1][j] + gap.extend, h[i - 1][j] + gap.open + gap.extend);
+					h[i][j] = std::max({ h[i - 1][j - 1] + flat[(i - 1) * n + j - 1], e[i][j], f[i][j], b_local ? 0 : minus_infinity });
+				}
+			}
+		}
+
+		int best = h[m][n];
+		if (ghl::alignment_mode::semi_global == mode) best = *std::max_element(h[m].begin(), h[m].end());
+		if (b_local)
+		{
+			for (auto& row : h) best = std::max(best, *std::max_element(row.begin(), row.end()));
+		}
+		return best;
+	}
+
+	// @returns the score of the operations of the alignment, or a huge number if they do not cover its ranges
+	int score_of_cigar(const ghl::alignment& a, const ghl::vector<int>& flat, size_t n, ghl::gap_penalty gap)
+	{
+		size_t i = a.first_begin, j = a.second_begin;
+		int score = 0;
+		for (size_t k = 0; k != a.cigar.size(); )
+		{
+			size_t count = 0;
+			while (isdigit((unsigned char)a.cigar[k])) count = count * 10 + (a.cigar[k++] - '0');
+			const char op = a.cigar[k++];
+			if ('M' == op)
+			{
+				for (size_t c = 0; c != count; ++c, ++i, ++j) score += flat[i * n + j];
+			}
+			else
+			{
+				score += gap.open + (int)count * gap.extend;
+				('I' == op ? i : j) += count;
+			}
+		}
+		return (i == a.first_end && j == a.second_end) ? score : 1000000000;
+	}
+
+	// @returns sequence with about one in rate of its elements substituted, deleted or followed by an insertion
+	ghl::vector<int> mutated(std::mt19937& rng, const ghl::vector<int>& sequence, unsigned rate)
+	{
+		ghl::vector<int> result(sequence.size() + sequence.size() / rate + 1);
+		for (size_t i = 0; i != sequence.size(); ++i)
+		{
+			switch (rng() % (3 * rate))
+			{
+			case 0: result.push_back((sequence[i] + 1) % 4); break;
+			case 1: break;
+			case 2: result.push_back(sequence[i]); result.push_back((int)(rng() % 4)); break;
+			default: result.push_back(sequence[i]);
+			}
+		}
+		return result;
+	}
+
+	// the flat score matrix of first against second: a random positive score for a match, and a random non-positive one for a mismatch
+	ghl::vector<int> random_scores(std::mt19937& rng, const ghl::vector<int>& first, const ghl::vector<int>& second)
+	{
+		ghl::vector<int> flat(first.size() * second.size());
+		for (size_t i = 0; i != first.size(); ++i)
+		{
+			for (size_t j = 0; j != second.size(); ++j) flat.push_back(first[i] == second[j] ? (int)(rng() % 5) + 1 : -(int)(rng() % 5));
+		}
+		return flat;
+	}
+
+	ghl::vector<char> random_sequence(std::mt19937& rng, size_t n, int alphabet)
+	{
+		ghl::vector<char> sequence(n);
+		for (size_t i = 0; i != n; ++i) sequence.push_back((char)('A' + rng() % alphabet));
+		return sequence;
+	}
+}
 
 DEFINE_TEST_CASE(test_dp_fib)
 
@@ -62,6 +192,553 @@ DEFINE_TEST_CASE(test_dp_assembly_line)
 
 ENDDEF_TEST_CASE
 
+DEFINE_TEST_CASE(test_dp_lcs_linear_space)
+
+	// the textbook example
+	{
+		ghl::vector<char> first{ 'A', 'B', 'C', 'B', 'D', 'A', 'B' }, second{ 'B', 'D', 'C', 'A', 'B', 'A' };
+
+		ASSERT_EQUALS(4, ghl::longest_common_subsequence_length(first, second), "expected to get the length right")
+		auto lcs = ghl::longest_common_subsequence(first, second);
+		ASSERT_EQUALS(4, lcs.size(), "expected to find an LCS")
+		ASSERT_TRUE(is_subsequence(lcs, first) && is_subsequence(lcs, second), "expected a common subsequence")
+	}
+
+	// empty sequences and no common element
+	{
+		ghl::vector<char> empty, first{ 'A', 'B' }, second{ 'C', 'D', 'E' };
+
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence_length(empty, first), "expected an empty LCS")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(first, empty).size(), "expected an empty LCS")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(first, second).size(), "expected an empty LCS")
+	}
+
+	// random sequences of different lengths and alphabets, against the full matrix
+	{
+		std::mt19937 rng(68);
+		for (int round = 0; round != 200; ++round)
+		{
+			auto first = random_sequence(rng, rng() % 60, 2 + round % 20);
+			auto second = random_sequence(rng, rng() % 60, 2 + round % 20);
+			const int expected = lcs_length_by_matrix(first, second);
+
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence_length(first, second), "expected to get the length right")
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence_length(second, first), "expected to get the length right")
+			auto lcs = ghl::longest_common_subsequence(first, second);
+			ASSERT_EQUALS(expected, lcs.size(), "expected to find an LCS")
+			ASSERT_TRUE(is_subsequence(lcs, first) && is_subsequence(lcs, second), "expected a common subsequence")
+		}
+	}
+
+	// long sequences, whose matrix would take 100M cells
+	{
+		std::mt19937 rng(1);
+		auto first = random_sequence(rng, 10000, 4), second = random_sequence(rng, 10000, 4);
+		auto lcs = ghl::longest_common_subsequence(first, second);
+		ASSERT_EQUALS(ghl::longest_common_subsequence_length(first, second), lcs.size(), "expected to find an LCS")
+		ASSERT_TRUE(is_subsequence(lcs, first) && is_subsequence(lcs, second), "expected a common subsequence")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_lcs_bit_parallel)
+
+	// the textbook example, and empty sequences
+	{
+		ghl::vector<char> first{ 'A', 'B', 'C', 'B', 'D', 'A', 'B' }, second{ 'B', 'D', 'C', 'A', 'B', 'A' }, empty;
+
+		ASSERT_EQUALS(4, ghl::longest_common_subsequence_length_bit_parallel(first, second), "expected to get the length right")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence_length_bit_parallel(first, empty), "expected an empty LCS")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence_length_bit_parallel(empty, empty), "expected an empty LCS")
+	}
+
+	// random sequences around the word boundaries, against the full matrix
+	{
+		std::mt19937 rng(69);
+		for (int round = 0; round != 300; ++round)
+		{
+			auto first = random_sequence(rng, rng() % 200, 2 + round % 30);
+			auto second = random_sequence(rng, rng() % 200, 2 + round % 30);
+			const int expected = lcs_length_by_matrix(first, second);
+
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence_length_bit_parallel(first, second), "expected to get the length right")
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence_length_bit_parallel(second, first), "expected to get the length right")
+		}
+	}
+
+	// every byte value, including the negative chars
+	{
+		std::mt19937 rng(256);
+		ghl::vector<char> first(1000), second(1500);
+		for (size_t i = 0; i != 1000; ++i) first.push_back((char)(rng() % 256));
+		for (size_t i = 0; i != 1500; ++i) second.push_back((char)(rng() % 256));
+		ASSERT_EQUALS(lcs_length_by_matrix(first, second), ghl::longest_common_subsequence_length_bit_parallel(first, second), "expected to get the length right")
+	}
+
+	// long sequences (many words and long carries), against the single row
+	{
+		std::mt19937 rng(2);
+		auto first = random_sequence(rng, 20000, 4), second = random_sequence(rng, 30000, 4);
+		ASSERT_EQUALS(ghl::longest_common_subsequence_length(first, second), ghl::longest_common_subsequence_length_bit_parallel(first, second), "expected to get the length right")
+		ASSERT_EQUALS(20000, ghl::longest_common_subsequence_length_bit_parallel(first, first), "expected the whole sequence")
+	}
+
+ENDDEF_TEST_CASE
+
+namespace
+{
+	// @returns the LCS read backwards from the cell (m, n) of directions of the whole sequences
+	template <typename Directions>
+	ghl::vector<char> lcs_by_directions(const ghl::vector<char>& first, const Directions& directions, size_t m, size_t n)
+	{
+		std::string reversed;
+		while (0 != m && 0 != n)
+		{
+			switch (directions[m][n])
+			{
+			case ghl::subsequence_direction::top_left: reversed.push_back(first[--m]); --n; break;
+			case ghl::subsequence_direction::top: --m; break;
+			case ghl::subsequence_direction::left: --n; break;
+			}
+		}
+		ghl::vector<char> lcs(reversed.size());
+		for (size_t k = reversed.size(); k-- != 0; ) lcs.push_back(reversed[k]);
+		return lcs;
+	}
+}
+
+DEFINE_TEST_CASE(test_dp_lcs_flat_table)
+
+	// the whole sequences, including their first elements, whatever the table
+	{
+		ghl::vector<char> a{ 'A' }, abc{ 'A', 'B', 'C' }, cab{ 'C', 'A', 'B' }, empty;
+		ghl::matrix<ghl::subsequence_direction> directions;
+		ASSERT_EQUALS(1, ghl::longest_common_subsequence(a, a, directions), "expected the whole sequence")
+		ASSERT_EQUALS(2, ghl::longest_common_subsequence(abc, cab, directions), "expected AB")
+		ASSERT_TRUE(4 == directions.rows() && 4 == directions.columns(), "expected a row and a column more than the sequences")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(abc, empty, directions), "expected an empty LCS")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(empty, empty, directions), "expected an empty LCS")
+
+		ghl::packed_matrix<ghl::subsequence_direction> packed_directions;
+		ASSERT_EQUALS(1, ghl::longest_common_subsequence(a, a, packed_directions), "expected the whole sequence")
+		ASSERT_EQUALS(2, ghl::longest_common_subsequence(abc, cab, packed_directions), "expected AB")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(empty, abc, packed_directions), "expected an empty LCS")
+
+		ghl::vector<ghl::vector<ghl::subsequence_direction>> vector_directions;
+		ASSERT_EQUALS(1, ghl::longest_common_subsequence(a, a, vector_directions), "expected the whole sequence")
+		ASSERT_EQUALS(2, ghl::longest_common_subsequence(abc, cab, vector_directions), "expected AB")
+		ASSERT_EQUALS(0, ghl::longest_common_subsequence(abc, empty, vector_directions), "expected an empty LCS")
+	}
+
+	// the lengths of the full matrix, and an LCS by the directions, flat and packed
+	{
+		std::mt19937 rng(74);
+		for (int round = 0; round != 200; ++round)
+		{
+			auto first = random_sequence(rng, rng() % 80, 2 + round % 10);
+			auto second = random_sequence(rng, rng() % 80, 2 + round % 10);
+			const int expected = lcs_length_by_matrix(first, second);
+
+			ghl::matrix<ghl::subsequence_direction> directions;
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence(first, second, directions), "expected to get the length right")
+			ASSERT_TRUE(first.size() + 1 == directions.rows() && second.size() + 1 == directions.columns(), "expected a row and a column more than the sequences")
+
+			auto lcs = lcs_by_directions(first, directions, first.size(), second.size());
+			ASSERT_EQUALS(expected, lcs.size(), "expected the directions to go along an LCS")
+			ASSERT_TRUE(is_subsequence(lcs, first) && is_subsequence(lcs, second), "expected a common subsequence")
+
+			// the packed directions are the same
+			ghl::packed_matrix<ghl::subsequence_direction> packed_directions;
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence(first, second, packed_directions), "expected to get the length right")
+			bool b_same = first.size() + 1 == packed_directions.rows() && second.size() + 1 == packed_directions.columns();
+			for (size_t i = 0; b_same && i <= first.size(); ++i)
+			{
+				for (size_t j = 0; j <= second.size(); ++j) b_same = b_same && directions[i][j] == packed_directions[i][j];
+			}
+			ASSERT_TRUE(b_same, "expected the same directions packed")
+			ASSERT_EQUALS(expected, lcs_by_directions(first, packed_directions, first.size(), second.size()).size(), "expected the packed directions to go along an LCS")
+
+			// and so are the vectors of vectors
+			ghl::vector<ghl::vector<ghl::subsequence_direction>> vector_directions;
+			ASSERT_EQUALS(expected, ghl::longest_common_subsequence(first, second, vector_directions), "expected to get the length right")
+			b_same = first.size() + 1 == vector_directions.size();
+			for (size_t i = 0; b_same && i <= first.size(); ++i)
+			{
+				b_same = second.size() + 1 == vector_directions[i].size();
+				for (size_t j = 0; b_same && j <= second.size(); ++j) b_same = directions[i][j] == vector_directions[i][j];
+			}
+			ASSERT_TRUE(b_same, "expected the same directions in the vectors of vectors")
+		}
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_alignment)
+
+	// a hand-computed example: matching costs nothing but a mismatch costs 3, and a gap 2
+	{
+		ghl::vector<int> first{ 1, 2, 3 }, second{ 1, 3 };
+		ghl::vector<ghl::vector<int>> matrix{ { 0, -3 }, { -3, -3 }, { -3, 0 } };
+		ghl::vector<int> flat{ 0, -3, -3, -3, -3, 0 };
+		ghl::vector<ghl::vector<ghl::subsequence_direction>> directions;
+
+		ASSERT_EQUALS(-2, ghl::best_alignment(-2, matrix, first, second, directions), "expected to skip the 2")
+		ASSERT_EQUALS(-2, ghl::best_alignment_vectorized(-2, flat, first, second), "expected to skip the 2")
+	}
+
+	// random scores, with sizes around the widths of the vectors and both signs of d, against best_alignment
+	{
+		std::mt19937 rng(70);
+		for (int round = 0; round != 300; ++round)
+		{
+			const size_t m = rng() % 40, n = rng() % 40;
+			const int d = (int)(rng() % 11) - 7;
+
+			ghl::vector<int> first(m), second(n), flat(m * n);
+			ghl::vector<ghl::vector<int>> matrix(m);
+			for (size_t i = 0; i != m; ++i) first.push_back((int)i);
+			for (size_t j = 0; j != n; ++j) second.push_back((int)j);
+			for (size_t i = 0; i != m; ++i)
+			{
+				matrix.emplace_back(n);
+				for (size_t j = 0; j != n; ++j)
+				{
+					const int score = (int)(rng() % 21) - 10;
+					matrix[i].push_back(score);
+					flat.push_back(score);
+				}
+			}
+
+			ghl::vector<ghl::vector<ghl::subsequence_direction>> directions;
+			const int score = ghl::best_alignment(d, matrix, first, second, directions);
+			ASSERT_EQUALS(score, ghl::best_alignment_vectorized(d, flat, first, second), "expected the same score")
+
+			// the flat and the packed tables give the same score and directions
+			ghl::matrix<int> table(m, n);
+			for (size_t i = 0; i != m; ++i)
+			{
+				for (size_t j = 0; j != n; ++j) table[i][j] = matrix[i][j];
+			}
+			ghl::matrix<ghl::subsequence_direction> flat_directions;
+			ghl::packed_matrix<ghl::subsequence_direction> packed_directions;
+			ASSERT_EQUALS(score, ghl::best_alignment(d, table, first, second, flat_directions), "expected the same score")
+			ASSERT_EQUALS(score, ghl::best_alignment(d, table, first, second, packed_directions), "expected the same score")
+			bool b_same = m + 1 == flat_directions.rows() && n + 1 == flat_directions.columns()
+				&& m + 1 == packed_directions.rows() && n + 1 == packed_directions.columns();
+			for (size_t i = 0; b_same && i != m + 1; ++i)
+			{
+				for (size_t j = 0; j != n + 1; ++j)
+				{
+					b_same = b_same && directions[i][j] == flat_directions[i][j] && directions[i][j] == packed_directions[i][j];
+				}
+			}
+			ASSERT_TRUE(b_same, "expected the same directions")
+		}
+	}
+
+	// only gaps
+	{
+		ghl::vector<int> empty, second{ 1, 2, 3, 4, 5 };
+		ghl::vector<int> flat;
+		ASSERT_EQUALS(-5, ghl::best_alignment_vectorized(-1, flat, empty, second), "expected a gap per element")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_affine_alignment)
+
+	// match 2, mismatch -1, open -3 and extend -1: a gap of 2 in the middle
+	{
+		ghl::vector<int> first{ 1, 2, 3, 4, 5, 6 }, second{ 1, 2, 5, 6 }, flat;
+		for (size_t i = 0; i != 6; ++i)
+		{
+			for (size_t j = 0; j != 4; ++j) flat.push_back(first[i] == second[j] ? 2 : -1);
+		}
+
+		auto global = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global);
+		ASSERT_EQUALS(3, global.score, "expected 4 matches and a gap of 2")
+		ASSERT_TRUE("2M2I2M" == global.cigar, "expected the gap in the middle")
+		ASSERT_EQUALS(6, global.first_end, "expected to align the whole sequences")
+		ASSERT_EQUALS(4, global.second_end, "expected to align the whole sequences")
+	}
+
+	// local and semi-global alignments of a piece of second
+	{
+		ghl::vector<int> first{ 7, 8, 9 }, second{ 1, 2, 7, 8, 9, 3 }, flat;
+		for (size_t i = 0; i != 3; ++i)
+		{
+			for (size_t j = 0; j != 6; ++j) flat.push_back(first[i] == second[j] ? 2 : -1);
+		}
+
+		auto local = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::local);
+		ASSERT_EQUALS(6, local.score, "expected 3 matches")
+		ASSERT_TRUE("3M" == local.cigar, "expected 3 matches")
+		ASSERT_EQUALS(2, local.second_begin, "expected the piece of second")
+		ASSERT_EQUALS(5, local.second_end, "expected the piece of second")
+
+		auto semi_global = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::semi_global);
+		ASSERT_EQUALS(6, semi_global.score, "expected free gaps at the ends of second")
+		ASSERT_TRUE("3M" == semi_global.cigar, "expected 3 matches")
+		ASSERT_EQUALS(0, semi_global.first_begin, "expected the whole of first")
+		ASSERT_EQUALS(3, semi_global.first_end, "expected the whole of first")
+		ASSERT_EQUALS(2, semi_global.second_begin, "expected the piece of second")
+
+		auto global = ghl::align(flat, first, second, ghl::gap_penalty{ -3, -1 }, ghl::alignment_mode::global);
+		ASSERT_EQUALS(6 - 5 - 4, global.score, "expected to pay for the ends of second")
+	}
+
+	// random scores and penalties in every mode, against the full matrices, and the operations against the score
+	{
+		std::mt19937 rng(71);
+		const ghl::alignment_mode modes[] = { ghl::alignment_mode::global, ghl::alignment_mode::local, ghl::alignment_mode::semi_global };
+		for (int round = 0; round != 600; ++round)
+		{
+			const size_t m = rng() % 30, n = rng() % 30;
+			const ghl::gap_penalty gap{ -(int)(rng() % 6), -(int)(rng() % 4) };
+			const ghl::alignment_mode mode = modes[round % 3];
+
+			ghl::vector<int> first(m), second(n), flat(m * n);
+			for (size_t i = 0; i != m; ++i) first.push_back((int)(rng() % 4));
+			for (size_t j = 0; j != n; ++j) second.push_back((int)(rng() % 4));
+			for (size_t i = 0; i != m; ++i)
+			{
+				for (size_t j = 0; j != n; ++j) flat.push_back(first[i] == second[j] ? (int)(rng() % 5) + 1 : -(int)(rng() % 5));
+			}
+
+			const int expected = alignment_score_by_matrix(flat, m, n, gap, mode);
+			auto a = ghl::align(flat, first, second, gap, mode);
+			ASSERT_EQUALS(expected, a.score, "expected the best score")
+			ASSERT_EQUALS(expected, ghl::align(flat, first, second, gap, mode, false).score, "expected the best score")
+			ASSERT_EQUALS(a.score, score_of_cigar(a, flat, n, gap), "expected the operations to score the alignment")
+			if (ghl::alignment_mode::local != mode)
+			{
+				ASSERT_TRUE(0 == a.first_begin && m == a.first_end, "expected to align the whole of first")
+			}
+			if (ghl::alignment_mode::global == mode)
+			{
+				ASSERT_TRUE(0 == a.second_begin && n == a.second_end, "expected to align the whole of second")
+			}
+		}
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_banded_alignment)
+
+	const ghl::alignment_mode modes[] = { ghl::alignment_mode::global, ghl::alignment_mode::local, ghl::alignment_mode::semi_global };
+
+	// a band that covers the matrix gives the alignment of align
+	{
+		std::mt19937 rng(72);
+		for (int round = 0; round != 300; ++round)
+		{
+			const size_t m = rng() % 30, n = rng() % 30;
+			const ghl::gap_penalty gap{ -(int)(rng() % 6), -(int)(rng() % 4) };
+			const ghl::alignment_mode mode = modes[round % 3];
+
+			ghl::vector<int> first(m), second(n);
+			for (size_t i = 0; i != m; ++i) first.push_back((int)(rng() % 4));
+			for (size_t j = 0; j != n; ++j) second.push_back((int)(rng() % 4));
+			const auto flat = random_scores(rng, first, second);
+
+			auto expected = ghl::align(flat, first, second, gap, mode);
+			auto a = ghl::align_banded(flat, first, second, gap, mode, ghl::alignment_band{ m + n });
+			ASSERT_EQUALS(expected.score, a.score, "expected the best score")
+			ASSERT_TRUE(expected.cigar == a.cigar, "expected the same operations")
+			ASSERT_TRUE(expected.first_begin == a.first_begin && expected.first_end == a.first_end, "expected the same range of first")
+			ASSERT_TRUE(expected.second_begin == a.second_begin && expected.second_end == a.second_end, "expected the same range of second")
+		}
+	}
+
+	// narrow bands: the operations score the alignment, which is never better than the one of align
+	{
+		std::mt19937 rng(73);
+		for (int round = 0; round != 300; ++round)
+		{
+			const size_t m = rng() % 40, n = rng() % 40;
+			const ghl::gap_penalty gap{ -(int)(rng() % 6), -(int)(rng() % 4) - 1 };
+			const ghl::alignment_mode mode = modes[round % 3];
+			const ghl::alignment_band band{ rng() % 4 };
+
+			ghl::vector<int> first(m), second(n);
+			for (size_t i = 0; i != m; ++i) first.push_back((int)(rng() % 4));
+			for (size_t j = 0; j != n; ++j) second.push_back((int)(rng() % 4));
+			const auto flat = random_scores(rng, first, second);
+
+			auto a = ghl::align_banded(flat, first, second, gap, mode, band);
+			ASSERT_TRUE(a.score <= ghl::align(flat, first, second, gap, mode, false).score, "expected no better than the best")
+			ASSERT_EQUALS(a.score, ghl::align_banded(flat, first, second, gap, mode, band, false).score, "expected the same score without the traceback")
+			ASSERT_EQUALS(a.score, score_of_cigar(a, flat, n, gap), "expected the operations to score the alignment")
+		}
+	}
+
+	// similar sequences: a narrow band, or an adaptive one from nothing, finds the best score
+	{
+		std::mt19937 rng(74);
+		for (int round = 0; round != 300; ++round)
+		{
+			const size_t m = 50 + rng() % 200;
+			const ghl::gap_penalty gap{ -3, -1 };
+			const ghl::alignment_mode mode = modes[round % 3];
+
+			ghl::vector<int> first(m);
+			for (size_t i = 0; i != m; ++i) first.push_back((int)(rng() % 4));
+			const auto second = mutated(rng, first, 50);
+			const size_t n = second.size();
+			ghl::vector<int> flat(m * n);
+			for (size_t i = 0; i != m; ++i)
+			{
+				for (size_t j = 0; j != n; ++j) flat.push_back(first[i] == second[j] ? 2 : -2);
+			}
+
+			const int expected = ghl::align(flat, first, second, gap, mode, false).score;
+			ASSERT_EQUALS(expected, ghl::align_banded(flat, first, second, gap, mode, ghl::alignment_band{ 16 }, false).score, "expected the best score inside the band")
+			auto a = ghl::align_banded(flat, first, second, gap, mode, ghl::alignment_band{ 0, true });
+			ASSERT_EQUALS(expected, a.score, "expected the adaptive band to grow to the best score")
+			ASSERT_EQUALS(a.score, score_of_cigar(a, flat, n, gap), "expected the operations to score the alignment")
+		}
+	}
+
+	// X-drop stops after the first matching region, when the mismatches between them drop far below it
+	{
+		ghl::vector<int> first, second;
+		for (int k = 0; k != 5; ++k) { first.push_back(k); second.push_back(k); }
+		for (int k = 0; k != 20; ++k) { first.push_back(100 + k); second.push_back(200 + k); }
+		for (int k = 0; k != 10; ++k) { first.push_back(10 + k); second.push_back(10 + k); }
+		ghl::vector<int> flat;
+		for (size_t i = 0; i != first.size(); ++i)
+		{
+			for (size_t j = 0; j != second.size(); ++j) flat.push_back(first[i] == second[j] ? 2 : -1);
+		}
+
+		const ghl::gap_penalty gap{ -3, -1 };
+		auto full = ghl::align_banded(flat, first, second, gap, ghl::alignment_mode::local, ghl::alignment_band{ 8 });
+		ASSERT_EQUALS(20, full.score, "expected the second region")
+		auto dropped = ghl::align_banded(flat, first, second, gap, ghl::alignment_mode::local, ghl::alignment_band{ 8, false, 5 });
+		ASSERT_EQUALS(10, dropped.score, "expected to stop after the first region")
+		ASSERT_TRUE("5M" == dropped.cigar && 0 == dropped.first_begin && 5 == dropped.first_end, "expected the first region")
+		auto loose = ghl::align_banded(flat, first, second, gap, ghl::alignment_mode::local, ghl::alignment_band{ 8, false, 100 });
+		ASSERT_EQUALS(20, loose.score, "expected a large X-drop to drop nothing")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_batch_alignment)
+
+	ghl::thread_pool pool(3);
+
+	// random pairs of all lengths, aligned by align_batch and one by one by align, in every mode
+	{
+		std::mt19937 rng(73);
+		const size_t count = 203, alphabet_size = 5;
+		ghl::vector<int> substitution(alphabet_size * alphabet_size);
+		for (size_t a = 0; a != alphabet_size; ++a)
+		{
+			for (size_t b = 0; b != alphabet_size; ++b) substitution.push_back(a == b ? (int)(rng() % 5) + 1 : -(int)(rng() % 5));
+		}
+
+		ghl::sequence_batch<int> firsts, seconds;
+		firsts.symbols = ghl::vector<int>(count * 40);
+		seconds.symbols = ghl::vector<int>(count * 40);
+		firsts.offsets = ghl::vector<size_t>(count + 1);
+		seconds.offsets = ghl::vector<size_t>(count + 1);
+		firsts.offsets.push_back(0);
+		seconds.offsets.push_back(0);
+		for (size_t k = 0; k != count; ++k)
+		{
+			const size_t m = rng() % 40, n = rng() % 40;
+			for (size_t i = 0; i != m; ++i) firsts.symbols.push_back((int)(rng() % alphabet_size));
+			for (size_t j = 0; j != n; ++j) seconds.symbols.push_back((int)(rng() % alphabet_size));
+			firsts.offsets.push_back(firsts.symbols.size());
+			seconds.offsets.push_back(seconds.symbols.size());
+		}
+
+		const ghl::alignment_mode modes[] = { ghl::alignment_mode::global, ghl::alignment_mode::local, ghl::alignment_mode::semi_global };
+		for (auto mode : modes)
+		{
+			const ghl::gap_penalty gap{ -3, -1 };
+			auto batch = ghl::align_batch(firsts, seconds, substitution, alphabet_size, gap, mode, pool, true);
+			auto scores_only = ghl::align_batch(firsts, seconds, substitution, alphabet_size, gap, mode, pool);
+			ASSERT_EQUALS(count, batch.scores.size(), "expected a score per pair")
+			ASSERT_EQUALS(count + 1, batch.cigar_offsets.size(), "expected a CIGAR per pair")
+			ASSERT_TRUE(scores_only.cigars.empty(), "expected no CIGAR without the traceback")
+
+			for (size_t k = 0; k != count; ++k)
+			{
+				ghl::vector<int> first(firsts.symbols.begin() + firsts.offsets[k], firsts.symbols.begin() + firsts.offsets[k + 1]);
+				ghl::vector<int> second(seconds.symbols.begin() + seconds.offsets[k], seconds.symbols.begin() + seconds.offsets[k + 1]);
+				ghl::vector<int> flat(first.size() * second.size());
+				for (size_t i = 0; i != first.size(); ++i)
+				{
+					for (size_t j = 0; j != second.size(); ++j) flat.push_back(substitution[first[i] * alphabet_size + second[j]]);
+				}
+
+				auto expected = ghl::align(flat, first, second, gap, mode);
+				const std::string cigar(batch.cigars.begin() + batch.cigar_offsets[k], batch.cigars.begin() + batch.cigar_offsets[k + 1]);
+				ASSERT_EQUALS(expected.score, batch.scores[k], "expected the score of align")
+				ASSERT_EQUALS(expected.score, scores_only.scores[k], "expected the score of align")
+				ASSERT_TRUE(expected.cigar == cigar, "expected the operations of align")
+				ASSERT_TRUE(expected.first_begin == batch.ranges[4 * k] && expected.first_end == batch.ranges[4 * k + 1], "expected the range of first of align")
+				ASSERT_TRUE(expected.second_begin == batch.ranges[4 * k + 2] && expected.second_end == batch.ranges[4 * k + 3], "expected the range of second of align")
+			}
+		}
+	}
+
+	// no pairs
+	{
+		ghl::sequence_batch<int> firsts, seconds;
+		firsts.offsets.push_back(0);
+		seconds.offsets.push_back(0);
+		ghl::vector<int> substitution{ 1 };
+		auto batch = ghl::align_batch(firsts, seconds, substitution, 1, ghl::gap_penalty{ -1, -1 }, ghl::alignment_mode::global, pool, true);
+		ASSERT_TRUE(batch.scores.empty() && batch.cigars.empty(), "expected nothing")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dp_lcs_batch)
+
+	ghl::thread_pool pool(3);
+
+	// LCS lengths of random pairs, and one LCS of each, over bytes of both signs
+	{
+		std::mt19937 rng(74);
+		const size_t count = 150;
+		ghl::sequence_batch<char> firsts, seconds;
+		firsts.symbols = ghl::vector<char>(count * 60);
+		seconds.symbols = ghl::vector<char>(count * 60);
+		firsts.offsets = ghl::vector<size_t>(count + 1);
+		seconds.offsets = ghl::vector<size_t>(count + 1);
+		firsts.offsets.push_back(0);
+		seconds.offsets.push_back(0);
+		for (size_t k = 0; k != count; ++k)
+		{
+			const size_t m = rng() % 60, n = rng() % 60;
+			for (size_t i = 0; i != m; ++i) firsts.symbols.push_back((char)(rng() % 3 + 126));
+			for (size_t j = 0; j != n; ++j) seconds.symbols.push_back((char)(rng() % 3 + 126));
+			firsts.offsets.push_back(firsts.symbols.size());
+			seconds.offsets.push_back(seconds.symbols.size());
+		}
+
+		ghl::sequence_batch<char> lcs;
+		auto lengths = ghl::longest_common_subsequence_batch(firsts, seconds, pool, &lcs);
+		auto lengths_only = ghl::longest_common_subsequence_batch(firsts, seconds, pool);
+		for (size_t k = 0; k != count; ++k)
+		{
+			ghl::vector<char> first(firsts.symbols.begin() + firsts.offsets[k], firsts.symbols.begin() + firsts.offsets[k + 1]);
+			ghl::vector<char> second(seconds.symbols.begin() + seconds.offsets[k], seconds.symbols.begin() + seconds.offsets[k + 1]);
+			ghl::vector<char> sub(lcs.symbols.begin() + lcs.offsets[k], lcs.symbols.begin() + lcs.offsets[k + 1]);
+
+			const int expected = lcs_length_by_matrix(first, second);
+			ASSERT_EQUALS(expected, lengths[k], "expected the length of the LCS")
+			ASSERT_EQUALS(expected, lengths_only[k], "expected the length of the LCS")
+			ASSERT_EQUALS(expected, (int)sub.size(), "expected an LCS")
+			ASSERT_TRUE(is_subsequence(sub, first) && is_subsequence(sub, second), "expected a common subsequence")
+		}
+	}
+
+ENDDEF_TEST_CASE
+
 void test_dp()
 {
 	ghl::test_unit fib
@@ -79,9 +756,36 @@ void test_dp()
 		"tests for dp assembly line"
 	};
 
+	ghl::test_unit alignment
+	{
+		{
+			&test_dp_alignment,
+			&test_dp_affine_alignment,
+			&test_dp_banded_alignment,
+			&test_dp_batch_alignment
+		},
+		"tests for dp best alignment"
+	};
+	ghl::test_unit lcs
+	{
+		{
+			&test_dp_lcs_linear_space,
+			&test_dp_lcs_bit_parallel,
+			&test_dp_lcs_batch,
+			&test_dp_lcs_flat_table
+		},
+		"tests for dp longest common subsequence"
+	};
+
 	fib.execute();
 	std::cout << fib.get_msg() << "\n";
 
 	ass_line.execute();
 	std::cout << ass_line.get_msg() << "\n";
+
+	lcs.execute();
+	std::cout << lcs.get_msg() << "\n";
+
+	alignment.execute();
+	std::cout << alignment.get_msg() << "\n";
 }
\ No newline at end of file
@@ -0,0 +1,161 @@
+// tests for class dynamic_graph
+
+#include "../data_structures/dynamic_graph.h"
+#include "../unit_test/test_unit.h"
+
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	// @returns true iff snap has the edge (l, r) of weight w
+	bool has_edge(const ghl::dynamic_graph_snapshot& snap, size_t l, size_t r, float w)
+	{
+		bool found = false;
+		snap.for_each_neighbor(l, [&](size_t u, float wt) { found = found || (u == r && wt == w); });
+		return found;
+	}
+}
+
+DEFINE_TEST_CASE(test_dynamic_graph_ctor)
+
+	ghl::dynamic_graph g;
+	auto snap = g.snapshot();
+
+	ASSERT_TRUE(snap->empty(), "expected to get an empty graph")
+	ASSERT_EQUALS(0, snap->num_edges(), "expected to have no edges")
+	ASSERT_EQUALS(0, snap->version(), "expected to have applied no batches")
+	ASSERT_FALSE(snap->is_undirected(), "expected to be directed by default")
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dynamic_graph_batches)
+
+	ghl::dynamic_graph g(false);
+
+	// inserting edges adds the vertices
+	{
+		g.apply_batch({ {0, 1, .5f}, {0, 2, .25f}, {2, 1} });
+		auto snap = g.snapshot();
+
+		ASSERT_EQUALS(3, snap->num_vertices(), "expected to add vertices up to the largest index")
+		ASSERT_EQUALS(3, snap->num_edges(), "expected to add the edges")
+		ASSERT_EQUALS(2, snap->degree(0), "expected to have the deg right")
+		ASSERT_EQUALS(0, snap->degree(1), "expected to have the deg right")
+		ASSERT_TRUE(has_edge(*snap, 0, 1, .5f) && has_edge(*snap, 0, 2, .25f) && has_edge(*snap, 2, 1, 0.0f), "expected to have the edges")
+		ASSERT_FALSE(has_edge(*snap, 1, 0, .5f), "expected to be directed")
+	}
+
+	// deleting edges, including an absent one, in the same batch as insertions
+	{
+		g.apply_batch({ {0, 1, 0.0f, false}, {1, 0, 0.0f, false}, {1000, 3, 1.0f} });
+		auto snap = g.snapshot();
+
+		ASSERT_EQUALS(1001, snap->num_vertices(), "expected to add vertices across blocks")
+		ASSERT_EQUALS(3, snap->num_edges(), "expected to remove one edge and add one")
+		ASSERT_FALSE(has_edge(*snap, 0, 1, .5f), "expected to remove the edge")
+		ASSERT_TRUE(has_edge(*snap, 0, 2, .25f), "expected to keep the other edges")
+		ASSERT_TRUE(has_edge(*snap, 1000, 3, 1.0f), "expected to add the edge")
+		ASSERT_EQUALS(2, snap->version(), "expected to have applied 2 batches")
+	}
+
+	// updates of the same edge are applied in order
+	{
+		g.apply_batch({ {5, 6, 1.0f}, {5, 6, 0.0f, false}, {5, 6, 2.0f} });
+		auto snap = g.snapshot();
+
+		ASSERT_EQUALS(1, snap->degree(5), "expected to have one edge left")
+		ASSERT_TRUE(has_edge(*snap, 5, 6, 2.0f), "expected to have the last inserted edge")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dynamic_graph_undirected)
+
+	ghl::dynamic_graph g(true);
+
+	g.apply_batch({ {0, 300, 1.0f}, {1, 2, 2.0f} });
+	auto snap = g.snapshot();
+
+	ASSERT_EQUALS(2, snap->num_edges(), "expected to count every edge once")
+	ASSERT_TRUE(has_edge(*snap, 0, 300, 1.0f) && has_edge(*snap, 300, 0, 1.0f), "expected to have the edge in both lists")
+
+	g.apply_batch({ {2, 1, 0.0f, false} });
+	snap = g.snapshot();
+
+	ASSERT_EQUALS(1, snap->num_edges(), "expected to remove the edge")
+	ASSERT_EQUALS(0, snap->degree(1) + snap->degree(2), "expected to remove the edge from both lists")
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_dynamic_graph_snapshot_isolation)
+
+	ghl::dynamic_graph g;
+	g.apply_batch({ {0, 1}, {1, 2} });
+
+	auto old = g.snapshot();
+	g.apply_batch({ {0, 1, 0.0f, false}, {2, 0} });
+	g.add_vertices(10);
+
+	auto latest = g.snapshot();
+
+	ASSERT_EQUALS(3, old->num_vertices(), "expected to not change the held snapshot")
+	ASSERT_EQUALS(2, old->num_edges(), "expected to not change the held snapshot")
+	ASSERT_TRUE(has_edge(*old, 0, 1, 0.0f), "expected to not change the held snapshot")
+	ASSERT_EQUALS(10, latest->num_vertices(), "expected to add the vertices")
+	ASSERT_EQUALS(2, latest->num_edges(), "expected to have the new edges")
+	ASSERT_FALSE(has_edge(*latest, 0, 1, 0.0f), "expected to have the new edges")
+
+	// a reader sees either all or none of a batch while a writer keeps ingesting
+	{
+		ghl::dynamic_graph h;
+		bool consistent = true;
+
+		std::thread writer([&h]()
+		{
+			for (size_t i = 0; i != 200; ++i)
+			{
+				// every batch adds 2 edges
+				h.apply_batch({ {i, i + 1}, {i + 1, i} });
+			}
+		});
+
+		for (int i = 0; i != 200; ++i)
+		{
+			auto snap = h.snapshot();
+			consistent = consistent && snap->num_edges() == 2 * snap->version();
+		}
+
+		writer.join();
+
+		ASSERT_TRUE(consistent, "expected to read consistent snapshots")
+		ASSERT_EQUALS(400, h.snapshot()->num_edges(), "expected to apply all batches")
+	}
+
+ENDDEF_TEST_CASE
+
+void test_dynamic_graph()
+{
+	ghl::test_unit ctor_dtor
+	{
+		{
+			&test_dynamic_graph_ctor
+		},
+		"tests for ctor and dtors of dynamic_graph"
+	};
+
+	ghl::test_unit operations
+	{
+		{
+			&test_dynamic_graph_batches,
+			&test_dynamic_graph_undirected,
+			&test_dynamic_graph_snapshot_isolation
+		},
+		"tests for operations of dynamic_graph"
+	};
+
+	ctor_dtor.execute();
+	std::cout << ctor_dtor.get_msg() << "\n";
+	operations.execute();
+	std::cout << operations.get_msg() << "\n";
+}
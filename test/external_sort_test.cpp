@@ -0,0 +1,162 @@
+// tests for external_sort
+
+#include "../algorithms/external_sort.h"
+#include "../unit_test/test_unit.h"
+
+#include "../data_structures/vector.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+	// a record sorted by its key, whose payload tells the records apart
+	struct record
+	{
+		uint32_t key;
+		uint32_t payload;
+
+		bool operator<(const record& other) const { return key < other.key; }
+	};
+
+	const char* const input_path = "external_sort_test.in";
+	const char* const output_path = "external_sort_test.out";
+
+	void write_records(const ghl::vector<record>& records)
+	{
+		std::ofstream out(input_path, std::ios::binary | std::ios::trunc);
+		out.write((const char*)records.begin(), (std::streamsize)(records.size() * sizeof(record)));
+	}
+
+	ghl::vector<record> read_records()
+	{
+		std::ifstream in(output_path, std::ios::binary | std::ios::ate);
+		const size_t n = in ? (size_t)in.tellg() / sizeof(record) : 0;
+		ghl::vector<record> records(n);
+		records.increase_size(n);
+		in.seekg(0);
+		in.read((char*)records.begin(), (std::streamsize)(n * sizeof(record)));
+		return records;
+	}
+
+	ghl::vector<record> random_records(size_t n, uint32_t max_key)
+	{
+		std::mt19937 rng((unsigned)n);
+		ghl::vector<record> records(n);
+		for (size_t i = 0; i != n; ++i) records.push_back(record{ (uint32_t)(rng() % max_key), (uint32_t)i });
+		return records;
+	}
+
+	// @returns true iff sorted is in ascending order and holds the records of input
+	bool is_sorted_permutation(const ghl::vector<record>& input, const ghl::vector<record>& sorted)
+	{
+		if (input.size() != sorted.size()) return false;
+
+		ghl::vector<bool> b_seen(input.size());
+		for (size_t i = 0; i != input.size(); ++i) b_seen.push_back(false);
+		for (size_t i = 0; i != sorted.size(); ++i)
+		{
+			if (0 != i && sorted[i] < sorted[i - 1]) return false;
+
+			const uint32_t payload = sorted[i].payload;
+			if (payload >= input.size() || b_seen[payload] || input[payload].key != sorted[i].key) return false;
+			b_seen[payload] = true;
+		}
+		return true;
+	}
+
+	bool file_exists(const std::string& path)
+	{
+		return std::ifstream(path).good();
+	}
+}
+
+DEFINE_TEST_CASE(test_external_sort_in_memory)
+
+	// fits in one run
+	{
+		const ghl::vector<record> input = random_records(1000, 100);
+		write_records(input);
+
+		ghl::external_sort_stats stats;
+		ASSERT_TRUE(ghl::external_sort<record>(input_path, output_path, 1 << 20, &stats), "expected to sort")
+		ASSERT_TRUE(is_sorted_permutation(input, read_records()), "expected to sort the records")
+		ASSERT_EQUALS(1000, stats.num_records, "expected to count the records")
+		ASSERT_EQUALS(1, stats.num_runs, "expected to have one run")
+		ASSERT_EQUALS(2, stats.num_passes, "expected to form the run and copy it")
+		ASSERT_EQUALS(2 * 1000 * sizeof(record), stats.bytes_read, "expected to read the records twice")
+		ASSERT_EQUALS(2 * 1000 * sizeof(record), stats.bytes_written, "expected to write the records twice")
+	}
+
+	// empty and single record files, which leave no temporary file either
+	{
+		for (size_t n = 0; n != 2; ++n)
+		{
+			const ghl::vector<record> input = random_records(n, 100);
+			write_records(input);
+			ASSERT_TRUE(ghl::external_sort<record>(input_path, output_path, 1 << 20), "expected to sort")
+			ASSERT_TRUE(is_sorted_permutation(input, read_records()), "expected to sort the records")
+			ASSERT_TRUE(!file_exists(std::string(output_path) + ".runs0"), "expected to remove the runs")
+		}
+	}
+
+	// a missing input
+	{
+		std::remove(input_path);
+		ASSERT_TRUE(!ghl::external_sort<record>(input_path, output_path, 1 << 20), "expected to fail")
+	}
+
+	std::remove(output_path);
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_external_sort_multi_pass)
+
+	// 64 KB of memory: runs of 4096 records merged 2 at a time, in blocks of 1365 records
+	for (size_t n : { 4096, 4097, 50000 })
+	{
+		const ghl::vector<record> input = random_records(n, (uint32_t)n / 3);
+		write_records(input);
+
+		ghl::external_sort_stats stats;
+		ASSERT_TRUE(ghl::external_sort<record>(input_path, output_path, 1 << 16, &stats), "expected to sort")
+		ASSERT_TRUE(is_sorted_permutation(input, read_records()), "expected to sort the records")
+
+		const size_t num_runs = (n + 4095) / 4096;
+		ASSERT_EQUALS(num_runs, stats.num_runs, "expected runs of half the memory")
+		ASSERT_EQUALS(2, stats.fan_in, "expected to merge as many runs as the memory allows")
+
+		size_t num_passes = 2;
+		for (size_t runs = num_runs; runs > 2; runs = (runs + 1) / 2) ++num_passes;
+		ASSERT_EQUALS(num_passes, stats.num_passes, "expected to merge until two runs are left")
+		ASSERT_EQUALS(num_passes * n * sizeof(record), stats.bytes_read, "expected to read every record once per pass")
+		ASSERT_EQUALS(num_passes * n * sizeof(record), stats.bytes_written, "expected to write every record once per pass")
+	}
+
+	// the temporary files are removed
+	ASSERT_TRUE(!file_exists(std::string(output_path) + ".runs0"), "expected to remove the runs")
+	ASSERT_TRUE(!file_exists(std::string(output_path) + ".runs1.0"), "expected to remove the merged runs")
+
+	std::remove(input_path);
+	std::remove(output_path);
+
+ENDDEF_TEST_CASE
+
+void test_external_sort()
+{
+	ghl::test_unit unit
+	{
+		{
+			&test_external_sort_in_memory,
+			&test_external_sort_multi_pass
+		},
+		"tests for external_sort"
+	};
+
+	unit.execute();
+	std::cout << unit.get_msg() << "\n";
+}
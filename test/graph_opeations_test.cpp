@@ -1,3 +1,291 @@
 #include "../algorithms/graph_operations.h"
 #include "../unit_test/test_unit.h"
 
+#include "../data_structures/dynamic_graph.h"
+#include "../data_structures/csr_graph.h"
+
+#include <iostream>
+
+DEFINE_TEST_CASE(test_indexed_bfs)
+
+	// 0 -> 1 -> 2 -> 3, 0 -> 2, and 4 is unreachable
+	ghl::dynamic_graph g;
+	g.apply_batch({ {0, 1}, {1, 2}, {2, 3}, {0, 2}, {4, 0} });
+	auto snap = g.snapshot();
+
+	ghl::vector<unsigned> d;
+	ghl::indexed_breadth_first_search(*snap, 0, d);
+
+	ASSERT_EQUALS(5, d.size(), "expected to have a distance for every vertex")
+	ASSERT_EQUALS(0, d[0], "expected to have the distance right")
+	ASSERT_EQUALS(1, d[1], "expected to have the distance right")
+	ASSERT_EQUALS(1, d[2], "expected to have the distance right")
+	ASSERT_EQUALS(2, d[3], "expected to have the distance right")
+	ASSERT_EQUALS(ghl::bfs_attr::inf, d[4], "expected to not reach the vertex")
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_indexed_page_rank)
+
+	// a directed cycle has equal ranks
+	{
+		ghl::dynamic_graph g;
+		g.apply_batch({ {0, 1}, {1, 2}, {2, 3}, {3, 0} });
+
+		ghl::vector<double> ranks;
+		ghl::indexed_page_rank(*g.snapshot(), ranks);
+
+		ASSERT_EQUALS(4, ranks.size(), "expected to have a rank for every vertex")
+		for (size_t v = 0; v != 4; ++v)
+		{
+			ASSERT_TRUE(ranks[v] > .2499 && ranks[v] < .2501, "expected to have equal ranks")
+		}
+	}
+
+	// a star whose leaves all point to the center (which has no out edges)
+	{
+		ghl::dynamic_graph g;
+		g.apply_batch({ {1, 0}, {2, 0}, {3, 0} });
+
+		ghl::vector<double> ranks;
+		ghl::indexed_page_rank(*g.snapshot(), ranks, .85, 50);
+
+		double sum = ranks[0] + ranks[1] + ranks[2] + ranks[3];
+		ASSERT_TRUE(sum > .9999 && sum < 1.0001, "expected to have the ranks sum up to 1")
+		ASSERT_TRUE(ranks[0] > ranks[1] && ranks[1] == ranks[2] && ranks[2] == ranks[3], "expected to rank the center the highest")
+	}
+
+ENDDEF_TEST_CASE
+
+namespace
+{
+	// @returns true iff new_index is a permutation of [0, n)
+	bool is_permutation(const ghl::vector<size_t>& new_index, size_t n)
+	{
+		if (new_index.size() != n) return false;
+
+		ghl::vector<bool> seen(n);
+		for (size_t i = 0; i != n; ++i) seen.push_back(false);
+		for (const auto& i : new_index)
+		{
+			if (i >= n || seen[i]) return false;
+			seen[i] = true;
+		}
+		return true;
+	}
+
+	// @returns true iff u is adj to v
+	bool has_edge_between(const ghl::csr_graph& g, size_t v, size_t u)
+	{
+		bool found = false;
+		g.for_each_neighbor(v, [&](size_t w, float) { found = found || w == u; });
+		return found;
+	}
+
+	// @returns the max difference between the indices of adj vertices
+	size_t bandwidth(const ghl::csr_graph& g)
+	{
+		size_t res = 0;
+		for (size_t v = 0; v != g.num_vertices(); ++v)
+		{
+			g.for_each_neighbor(v, [&](size_t u, float) { size_t d = u > v ? u - v : v - u; if (d > res) res = d; });
+		}
+		return res;
+	}
+}
+
+DEFINE_TEST_CASE(test_reordering)
+
+	// a path of 64 vertices whose indices are scattered
+	ghl::dynamic_graph d(true);
+	{
+		ghl::vector<ghl::edge_update> batch;
+		for (size_t i = 0; i + 1 != 64; ++i) batch.emplace_back((i * 37) % 64, ((i + 1) * 37) % 64);
+		d.apply_batch(batch);
+	}
+	ghl::csr_graph g(*d.snapshot());
+	ASSERT_TRUE(bandwidth(g) > 1, "expected to start with scattered indices")
+
+	// degree sort
+	{
+		ghl::vector<size_t> new_index;
+		ghl::degree_sort_order(g, new_index);
+
+		ASSERT_TRUE(is_permutation(new_index, 64), "expected to get a permutation")
+		auto r = g.relabeled(new_index);
+		for (size_t v = 0; v + 1 != 64; ++v)
+		{
+			ASSERT_TRUE(r.degree(v) >= r.degree(v + 1), "expected to order by degree")
+		}
+	}
+
+	// (reverse) Cuthill-McKee
+	{
+		ghl::vector<size_t> new_index;
+		ghl::cuthill_mckee_order(g, new_index);
+
+		ASSERT_TRUE(is_permutation(new_index, 64), "expected to get a permutation")
+		auto r = g.relabeled(new_index);
+		ASSERT_EQUALS(1, bandwidth(r), "expected to number the path in order")
+		ASSERT_EQUALS(63, r.num_edges(), "expected to keep the edges")
+	}
+
+	// Gorder
+	{
+		ghl::vector<size_t> new_index;
+		ghl::gorder_order(g, new_index, 3);
+
+		ASSERT_TRUE(is_permutation(new_index, 64), "expected to get a permutation")
+
+		// siblings count as much as neighbors, so the path is not necessarily followed all the way
+		auto r = g.relabeled(new_index);
+		size_t adjacent = 0;
+		for (size_t v = 0; v + 1 != 64; ++v) if (has_edge_between(r, v, v + 1)) ++adjacent;
+		ASSERT_TRUE(adjacent >= 42, "expected to place most neighbors next to each other")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_multilevel_partition)
+
+	// two cliques of 40 vertices joined by one edge
+	ghl::dynamic_graph d(true);
+	{
+		ghl::vector<ghl::edge_update> batch;
+		for (size_t c = 0; c != 2; ++c)
+		{
+			for (size_t i = 0; i != 40; ++i)
+			{
+				for (size_t j = i + 1; j != 40; ++j)
+				{
+					// interleave the indices of the two cliques
+					batch.emplace_back(2 * i + c, 2 * j + c);
+				}
+			}
+		}
+		batch.emplace_back(0, 1);
+		d.apply_batch(batch);
+	}
+	ghl::csr_graph g(*d.snapshot());
+
+	ghl::vector<unsigned> part;
+	ghl::multilevel_partition(g, 2, part);
+
+	ASSERT_EQUALS(80, part.size(), "expected to assign every vertex")
+	ASSERT_EQUALS(1, ghl::edge_cut(g, part), "expected to cut only the joining edge")
+
+	size_t size0 = 0;
+	for (const auto& p : part) if (0 == p) ++size0;
+	ASSERT_EQUALS(40, size0, "expected to have balanced parts")
+
+	// more parts
+	ghl::vector<unsigned> part4;
+	ghl::multilevel_partition(g, 4, part4);
+	size_t sizes[4] = { 0, 0, 0, 0 };
+	for (const auto& p : part4) ++sizes[p];
+	for (size_t p = 0; p != 4; ++p)
+	{
+		ASSERT_TRUE(sizes[p] >= 18 && sizes[p] <= 21, "expected to have balanced parts")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_count_triangles)
+
+	// K4 has 4 triangles, plus a pendant vertex, a self loop, and a parallel edge, which add none
+	{
+		ghl::dynamic_graph d(true);
+		d.apply_batch({ {0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}, {3, 4}, {4, 4}, {1, 0} });
+		auto snap = d.snapshot();
+
+		ASSERT_EQUALS(4, ghl::count_triangles(*snap, 1), "expected to count every triangle once")
+		ASSERT_EQUALS(4, ghl::count_triangles(*snap, 3), "expected to count the same with multiple threads")
+	}
+
+	// directions are ignored
+	{
+		ghl::dynamic_graph d;
+		d.apply_batch({ {0, 1}, {1, 2}, {2, 0}, {2, 3} });
+		ASSERT_EQUALS(1, ghl::count_triangles(*d.snapshot()), "expected to ignore the directions")
+	}
+
+	// a clique of 30 vertices, whose lists are long enough to be intersected in blocks, has C(30, 3) triangles
+	{
+		ghl::dynamic_graph d(true);
+		ghl::vector<ghl::edge_update> batch;
+		for (size_t i = 0; i != 30; ++i)
+		{
+			for (size_t j = i + 1; j != 30; ++j) batch.emplace_back(i, j);
+		}
+		d.apply_batch(batch);
+		ASSERT_EQUALS(4060, ghl::count_triangles(ghl::csr_graph(*d.snapshot()), 2), "expected to count every triangle once")
+	}
+
+	// a grid has no triangles
+	{
+		ghl::dynamic_graph d(true);
+		ghl::vector<ghl::edge_update> batch;
+		for (size_t i = 0; i != 20; ++i)
+		{
+			for (size_t j = 0; j != 20; ++j)
+			{
+				if (i + 1 != 20) batch.emplace_back(i * 20 + j, (i + 1) * 20 + j);
+				if (j + 1 != 20) batch.emplace_back(i * 20 + j, i * 20 + j + 1);
+			}
+		}
+		d.apply_batch(batch);
+		ASSERT_EQUALS(0, ghl::count_triangles(*d.snapshot()), "expected to find no triangle")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_k_core_decomposition)
+
+	// K4 (0-3) joined to a triangle (5-7) by a path 3-4-5, with a leaf 9 attached to 0, and an isolated vertex 8 with a self loop
+	ghl::dynamic_graph d(true);
+	d.apply_batch({ {0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 7}, {7, 5}, {8, 8}, {0, 9} });
+
+	ghl::vector<size_t> core;
+	ASSERT_EQUALS(3, ghl::k_core_decomposition(*d.snapshot(), core), "expected to have the degeneracy right")
+
+	const size_t expected[10] = { 3, 3, 3, 3, 2, 2, 2, 2, 0, 1 };
+	ASSERT_EQUALS(10, core.size(), "expected to have a core number for every vertex")
+	for (size_t v = 0; v != 10; ++v)
+	{
+		ASSERT_EQUALS(expected[v], core[v], "expected to have the core number right")
+	}
+
+	// an empty graph
+	ghl::csr_graph empty;
+	ghl::vector<size_t> none;
+	ASSERT_EQUALS(0, ghl::k_core_decomposition(empty, none), "expected to have no core")
+
+ENDDEF_TEST_CASE
+
+void test_graph_operations()
+{
+	ghl::test_unit indexed
+	{
+		{
+			&test_indexed_bfs,
+			&test_indexed_page_rank,
+			&test_count_triangles,
+			&test_k_core_decomposition
+		},
+		"tests for algorithms on indexed graphs"
+	};
+	ghl::test_unit locality
+	{
+		{
+			&test_reordering,
+			&test_multilevel_partition
+		},
+		"tests for reordering and partitioning"
+	};
+
+	indexed.execute();
+	std::cout << indexed.get_msg() << "\n";
+
+	locality.execute();
+	std::cout << locality.get_msg() << "\n";
+}
@@ -9,6 +9,12 @@ void test_bst();
 void test_avl_tree();
 void test_tree_set();
 void test_binary_heap();
+void test_dynamic_graph();
+void test_graph_operations();
+void test_csr_graph();
+void test_thread_pool();
+void test_external_sort();
+void test_matrix();
 
 int main()
 {
@@ -42,5 +48,23 @@ int main()
 	// passed
 	test_binary_heap();
 
+	// passed
+	//test_dynamic_graph();
+
+	// passed
+	//test_graph_operations();
+
+	// passed
+	//test_csr_graph();
+
+	// passed
+	//test_thread_pool();
+
+	// passed
+	//test_external_sort();
+
+	// passed
+	//test_matrix();
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,196 @@
+// tests for class matrix, matrix_view and packed_matrix
+
+#include "../data_structures/matrix.h"
+#include "../unit_test/test_unit.h"
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+DEFINE_TEST_CASE(test_matrix_layout)
+
+	// the rows start at multiples of the alignment, and the padding is counted by the row stride
+	{
+		ghl::matrix<int> m(5, 7, 3);
+		ASSERT_EQUALS(5, m.rows(), "expected 5 rows")
+		ASSERT_EQUALS(7, m.columns(), "expected 7 columns")
+		ASSERT_EQUALS(16, m.row_stride(), "expected the rows padded to 64 bytes")
+
+		bool b_aligned = true, b_filled = true;
+		for (size_t i = 0; i != 5; ++i)
+		{
+			b_aligned = b_aligned && 0 == (uintptr_t)m[i] % ghl::matrix<int>::alignment;
+			for (size_t j = 0; j != 7; ++j) b_filled = b_filled && 3 == m[i][j];
+		}
+		ASSERT_TRUE(b_aligned, "expected aligned rows")
+		ASSERT_TRUE(b_filled, "expected every element to be the value")
+
+		m(2, 4) = 10;
+		ASSERT_EQUALS(10, m[2][4], "expected (i, j) to be m[i][j]")
+		ASSERT_EQUALS(10, m.data()[2 * m.row_stride() + 4], "expected (i, j) to be at i * row_stride + j")
+	}
+
+	// types that do not divide the alignment are not padded, and empty matrices allocate nothing
+	{
+		struct three_bytes { char c[3]; };
+		ghl::matrix<three_bytes> m(2, 5);
+		ASSERT_EQUALS(5, m.row_stride(), "expected no padding")
+
+		ghl::matrix<int> empty(0, 10), none;
+		ASSERT_TRUE(empty.empty() && nullptr == empty.data(), "expected nothing allocated")
+		ASSERT_TRUE(none.empty() && nullptr == none.data(), "expected nothing allocated")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_matrix_copy_move)
+
+	ghl::matrix<int> m(3, 4);
+	for (size_t i = 0; i != 3; ++i)
+	{
+		for (size_t j = 0; j != 4; ++j) m[i][j] = (int)(i * 4 + j);
+	}
+
+	ghl::matrix<int> copy(m);
+	copy[1][1] = -1;
+	ASSERT_EQUALS(5, m[1][1], "expected the copy not to share the elements")
+	ASSERT_EQUALS(11, copy[2][3], "expected the elements copied")
+
+	ghl::matrix<int> moved(std::move(copy));
+	ASSERT_TRUE(copy.empty() && nullptr == copy.data(), "expected the moved matrix to be empty")
+	ASSERT_EQUALS(-1, moved[1][1], "expected the elements moved")
+
+	moved = m;
+	ASSERT_EQUALS(5, moved[1][1], "expected the elements assigned")
+	m = ghl::matrix<int>(1, 1, 9);
+	ASSERT_TRUE(1 == m.rows() && 9 == m[0][0], "expected the matrix move assigned")
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_matrix_view)
+
+	ghl::matrix<int> m(6, 5);
+	for (size_t i = 0; i != 6; ++i)
+	{
+		for (size_t j = 0; j != 5; ++j) m[i][j] = (int)(i * 10 + j);
+	}
+	auto v = m.view();
+
+	// strides, rows, columns and the transpose
+	{
+		ASSERT_EQUALS(23, v(2, 3), "expected the element (2, 3)")
+		ASSERT_EQUALS(1, v.column_stride(), "expected contiguous rows")
+		ASSERT_EQUALS(41, v.row(4)(0, 1), "expected the row 4")
+		ASSERT_EQUALS(52, v.column(2)(5, 0), "expected the column 2")
+
+		auto t = v.transposed();
+		ASSERT_TRUE(5 == t.rows() && 6 == t.columns(), "expected the dimensions swapped")
+		ASSERT_EQUALS(23, t(3, 2), "expected (i, j) to be (j, i)")
+	}
+
+	// tiles cover the view once, the last ones smaller
+	{
+		int visits[6][5] = {};
+		size_t num_tiles = 0;
+		bool b_elements = true;
+		v.for_each_tile(4, 2, [&](ghl::matrix_view<int> tile, size_t i, size_t j)
+		{
+			++num_tiles;
+			for (size_t a = 0; a != tile.rows(); ++a)
+			{
+				for (size_t b = 0; b != tile.columns(); ++b)
+				{
+					++visits[i + a][j + b];
+					b_elements = b_elements && tile(a, b) == m[i + a][j + b];
+				}
+			}
+		});
+
+		bool b_once = true;
+		for (auto& row : visits)
+		{
+			for (int count : row) b_once = b_once && 1 == count;
+		}
+		ASSERT_EQUALS(6, num_tiles, "expected 2 x 3 tiles")
+		ASSERT_TRUE(b_once, "expected to visit every element once")
+		ASSERT_TRUE(b_elements, "expected the tiles to view the elements")
+	}
+
+	// writing through a view
+	{
+		v.block(1, 1, 2, 2)(1, 1) = -7;
+		ASSERT_EQUALS(-7, m[2][2], "expected to write the element (2, 2)")
+
+		const ghl::matrix<int>& c = m;
+		ASSERT_EQUALS(-7, c.view()(2, 2), "expected the const view to read it")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_packed_matrix)
+
+	// rows stored at once read the same as elements set one by one, for every length around the words and vectors
+	{
+		std::mt19937 rng(75);
+		bool b_same = true;
+		for (size_t columns = 1; columns != 300; ++columns)
+		{
+			ghl::packed_matrix<unsigned char> stored(3, columns), set(3, columns);
+			std::vector<unsigned char> values(columns);
+			for (size_t i = 0; i != 3; ++i)
+			{
+				for (size_t j = 0; j != columns; ++j)
+				{
+					values[j] = (unsigned char)(rng() % 4);
+					set.set(i, j, values[j]);
+				}
+				stored.store_row(i, values.data());
+
+				for (size_t j = 0; j != columns; ++j) b_same = b_same && values[j] == stored[i][j] && values[j] == set(i, j);
+			}
+
+			// the words past the columns stay 0
+			const auto& words = stored.words();
+			for (size_t i = 0; i != 3; ++i)
+			{
+				for (size_t w = columns / 32; w != words.row_stride(); ++w)
+				{
+					const uint64_t used = w == columns / 32 && 0 != columns % 32 ? ((uint64_t)1 << (columns % 32 * 2)) - 1 : 0;
+					b_same = b_same && 0 == (words[i][w] & ~used);
+				}
+			}
+		}
+		ASSERT_TRUE(b_same, "expected the elements stored")
+	}
+
+	// a quarter of the memory of a matrix, and set changes one element
+	{
+		ghl::packed_matrix<unsigned char> large(1, 1024);
+		ASSERT_EQUALS(1024 / 4, large.words().row_stride() * sizeof(uint64_t), "expected 2 bits per element")
+
+		ghl::packed_matrix<unsigned char> m(2, 40);
+		m.set(1, 33, 3);
+		m.set(1, 33, 1);
+		ASSERT_TRUE(1 == m(1, 33) && 0 == m(1, 32) && 0 == m(1, 34) && 0 == m(0, 33), "expected only the element (1, 33) set")
+	}
+
+ENDDEF_TEST_CASE
+
+void test_matrix()
+{
+	ghl::test_unit unit
+	{
+		{
+			&test_matrix_layout,
+			&test_matrix_copy_move,
+			&test_matrix_view,
+			&test_packed_matrix
+		},
+		"tests for matrix"
+	};
+
+	unit.execute();
+	std::cout << unit.get_msg() << "\n";
+}
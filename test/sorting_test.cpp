@@ -3,7 +3,66 @@
 
 #include "../data_structures/vector.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// @returns true iff [begin, end) is sorted in ascending order
+	template <typename T>
+	bool is_ascending(T begin, T end)
+	{
+		for (T i = begin; i != end && i + 1 != end; ++i)
+		{
+			if (*(i + 1) < *i) return false;
+		}
+		return true;
+	}
+
+	/*
+	* Lists of n elements that are hard or special for sorts:
+	* 0 random, 1 sorted, 2 reversed, 3 few distinct values, 4 organ pipe, 5 sorted with a few swaps, 6 all equal
+	*/
+	ghl::vector<int> make_pattern(size_t pattern, size_t n)
+	{
+		std::mt19937 rng((unsigned)(pattern * 1000 + n));
+		ghl::vector<int> v(n);
+		for (size_t i = 0; i != n; ++i)
+		{
+			switch (pattern)
+			{
+			case 0: v.push_back((int)(rng() % 1000000)); break;
+			case 1: v.push_back((int)i); break;
+			case 2: v.push_back((int)(n - i)); break;
+			case 3: v.push_back((int)(rng() % 4)); break;
+			case 4: v.push_back((int)(i < n / 2 ? i : n - i)); break;
+			case 5: v.push_back((int)i); break;
+			default: v.push_back(7); break;
+			}
+		}
+		if (5 == pattern && n > 1)
+		{
+			for (size_t k = 0; k != 5; ++k) std::swap(v[rng() % n], v[rng() % n]);
+		}
+		return v;
+	}
+
+	const size_t num_patterns = 7;
+
+	// compared only by key, to tell whether a sort is stable
+	struct keyed
+	{
+		int key = 0;
+		size_t index = 0;
+
+		bool operator<(const keyed& other) const { return key < other.key; }
+	};
+}
 
 DEFINE_TEST_CASE(test_sorting_bubble)
 
@@ -215,6 +274,929 @@ DEFINE_TEST_CASE(test_sorting_merge)
 	ASSERT_EQUALS(8, v_pt[7], "expected to sort the list")
 }
 
+// all patterns, with sizes around the threshold of insertion sort, and long runs for galloping
+{
+	const size_t sizes[] = { 31, 32, 33, 100, 1000, 100000 };
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto v = make_pattern(p, n);
+			ghl::merge_sort(v);
+			ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+		}
+	}
+}
+
+// stability
+{
+	ghl::vector<keyed> v(10000);
+	for (size_t i = 0; i != 10000; ++i)
+	{
+		keyed k;
+		k.key = (int)((i * 7919) % 13);
+		k.index = i;
+		v.push_back(k);
+	}
+	ghl::merge_sort(v);
+
+	bool b_stable = true;
+	for (size_t i = 0; i + 1 != 10000; ++i)
+	{
+		b_stable = b_stable && (v[i].key < v[i + 1].key || (v[i].key == v[i + 1].key && v[i].index < v[i + 1].index));
+	}
+	ASSERT_TRUE(b_stable, "expected to keep the order of equal elements")
+}
+
+// merging two sorted sublists of different lengths
+{
+	ghl::vector<int> v{ 1, 4, 4, 9, 0, 2, 4, 5, 6, 7, 8, 10, 11 };
+	ghl::merge(v.begin(), v.begin() + 4, v.end());
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to merge the lists")
+	ASSERT_EQUALS(13, v.size(), "expected to have the size unchanged")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_natural_merge)
+
+// sort an empty set or a list with one element
+{
+	ghl::vector<int> v_empty;
+	ghl::natural_merge_sort(v_empty);
+	ASSERT_TRUE(v_empty.empty(), "expected to do nothing")
+
+	v_empty.push_back(2);
+	ghl::natural_merge_sort(v_empty);
+	ASSERT_EQUALS(1, v_empty.size(), "expected to do nothing")
+	ASSERT_EQUALS(2, v_empty[0], "expected to do nothing")
+}
+
+// all patterns, with sizes around minrun and enough runs to exercise the merge stack
+{
+	const size_t sizes[] = { 31, 32, 63, 64, 65, 100, 1000, 100000 };
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto v = make_pattern(p, n);
+			ghl::natural_merge_sort(v);
+			ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+		}
+	}
+}
+
+// sorted and reversed lists take n - 1 comparisons
+{
+	for (size_t p : { 1, 2 })
+	{
+		auto v = make_pattern(p, 100000);
+		size_t num_comparisons = 0;
+		ghl::natural_merge_sort(v, [&](int a, int b) { ++num_comparisons; return a < b; });
+		ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+		ASSERT_EQUALS(100000 - 1, num_comparisons, "expected to find a single run")
+	}
+}
+
+// runs of random lengths, ascending, descending and interleaved with random blocks
+{
+	std::mt19937 rng(66);
+	ghl::vector<int> v(200000);
+	while (v.size() != 200000)
+	{
+		const size_t len = std::min<size_t>(rng() % 3000 + 1, 200000 - v.size());
+		const int start = (int)(rng() % 1000000);
+		const unsigned kind = rng() % 3;
+		for (size_t i = 0; i != len; ++i)
+		{
+			v.push_back(0 == kind ? start + (int)i : 1 == kind ? start - (int)i : (int)(rng() % 1000000));
+		}
+	}
+	auto expected = v;
+	std::sort(expected.begin(), expected.end());
+	ghl::natural_merge_sort(v);
+	ASSERT_TRUE(std::equal(v.begin(), v.end(), expected.begin()), "expected to sort the list")
+}
+
+// stability, with descending runs of equal keys that must not be reversed
+{
+	ghl::vector<keyed> v(10000);
+	for (size_t i = 0; i != 10000; ++i)
+	{
+		keyed k;
+		k.key = (i < 5000) ? (int)((5000 - i) / 100) : (int)((i * 7919) % 13);
+		k.index = i;
+		v.push_back(k);
+	}
+	ghl::natural_merge_sort(v);
+
+	bool b_stable = true;
+	for (size_t i = 0; i + 1 != 10000; ++i)
+	{
+		b_stable = b_stable && (v[i].key < v[i + 1].key || (v[i].key == v[i + 1].key && v[i].index < v[i + 1].index));
+	}
+	ASSERT_TRUE(b_stable, "expected to keep the order of equal elements")
+}
+
+// a comparator and a projection
+{
+	auto v = make_pattern(0, 5000);
+	ghl::natural_merge_sort(v, std::greater<int>());
+	ASSERT_TRUE(std::is_sorted(v.begin(), v.end(), std::greater<int>()), "expected to sort in descending order")
+
+	ghl::vector<keyed> w(3000);
+	for (size_t i = 0; i != 3000; ++i)
+	{
+		keyed k;
+		k.key = (int)(i % 17);
+		k.index = 3000 - i;
+		w.push_back(k);
+	}
+	ghl::natural_merge_sort(w.begin(), w.end(), ghl::detail::less(), &keyed::index);
+	bool b_sorted = true;
+	for (size_t i = 0; i != 3000; ++i) b_sorted = b_sorted && w[i].index == i + 1;
+	ASSERT_TRUE(b_sorted, "expected to sort by the projection")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_heap)
+
+// small lists
+{
+	ghl::vector<int> v_empty;
+	ghl::heap_sort(v_empty);
+	ASSERT_TRUE(v_empty.empty(), "expected to do nothing")
+
+	ghl::vector<int> v_pt{ 1,7,2,3,5,4,6,8 };
+	ghl::heap_sort(v_pt);
+	ASSERT_EQUALS(8, v_pt.size(), "expected to have the size unchanged")
+	for (int i = 0; i != 8; ++i)
+	{
+		ASSERT_EQUALS(i + 1, v_pt[i], "expected to sort the list")
+	}
+}
+
+// all patterns
+for (size_t p = 0; p != num_patterns; ++p)
+{
+	auto v = make_pattern(p, 1000);
+	ghl::heap_sort(v.begin(), v.end());
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_introsort)
+
+// sort an empty set or a list with one element
+{
+	ghl::vector<int> v_empty;
+	ghl::introsort(v_empty);
+	ASSERT_TRUE(v_empty.empty(), "expected to do nothing")
+
+	v_empty.push_back(2);
+	ghl::introsort(v_empty);
+	ASSERT_EQUALS(1, v_empty.size(), "expected to do nothing")
+	ASSERT_EQUALS(2, v_empty[0], "expected to do nothing")
+}
+
+// sort a partially sorted list
+{
+	ghl::vector<int> v_pt{ 1,7,2,3,5,4,6,8 };
+	ghl::introsort(v_pt);
+	ASSERT_EQUALS(8, v_pt.size(), "expected to have the size unchanged")
+	for (int i = 0; i != 8; ++i)
+	{
+		ASSERT_EQUALS(i + 1, v_pt[i], "expected to sort the list")
+	}
+}
+
+// all patterns, with sizes around the thresholds of insertion sort and the ninther, and large enough for the branchless partition
+{
+	const size_t sizes[] = { 2, 23, 24, 25, 128, 129, 1000, 100000 };
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto v = make_pattern(p, n);
+
+			long long sum_before = 0, sum_after = 0;
+			for (auto x : v) sum_before += x;
+
+			ghl::introsort(v.begin(), v.end());
+
+			for (auto x : v) sum_after += x;
+			ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+			ASSERT_EQUALS(sum_before, sum_after, "expected to keep the elements")
+		}
+	}
+}
+
+// a type that is not arithmetic, which takes the partition with branches
+{
+	ghl::vector<std::pair<int, int>> v(1000);
+	for (int i = 0; i != 1000; ++i) v.push_back(std::make_pair((i * 7919) % 100, i));
+	ghl::introsort(v);
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_parallel)
+
+ghl::thread_pool pool(4);
+
+// all patterns, with grains small enough to get many tasks and parallel merges
+{
+	const size_t sizes[] = { 0, 1, 100, 5000, 100000 };
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto v = make_pattern(p, n);
+			ghl::parallel_merge_sort(v.begin(), v.end(), pool, 64);
+			ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+
+			auto w = make_pattern(p, n);
+			long long sum_before = 0, sum_after = 0;
+			for (auto x : w) sum_before += x;
+
+			ghl::parallel_sample_sort(w, pool, 64);
+
+			for (auto x : w) sum_after += x;
+			ASSERT_TRUE(is_ascending(w.begin(), w.end()), "expected to sort the list")
+			ASSERT_EQUALS(sum_before, sum_after, "expected to keep the elements")
+		}
+	}
+}
+
+// parallel_merge_sort is stable
+{
+	ghl::vector<keyed> v(10000);
+	for (size_t i = 0; i != 10000; ++i)
+	{
+		keyed k;
+		k.key = (int)((i * 7919) % 13);
+		k.index = i;
+		v.push_back(k);
+	}
+	ghl::parallel_merge_sort(v, pool, 100);
+
+	bool b_stable = true;
+	for (size_t i = 0; i + 1 != 10000; ++i)
+	{
+		b_stable = b_stable && (v[i].key < v[i + 1].key || (v[i].key == v[i + 1].key && v[i].index < v[i + 1].index));
+	}
+	ASSERT_TRUE(b_stable, "expected to keep the order of equal elements")
+}
+
+// a type that owns memory, which has to be moved around correctly
+{
+	ghl::vector<std::string> v(3000);
+	for (size_t i = 0; i != 3000; ++i) v.push_back(std::to_string((i * 7919) % 3000));
+	auto w = v;
+	ghl::parallel_merge_sort(v, pool, 50);
+	ghl::parallel_sample_sort(w, pool, 50);
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+	ASSERT_TRUE(is_ascending(w.begin(), w.end()), "expected to sort the list")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_radix)
+
+// all patterns, with sizes around the threshold of merge sort and the 8-bit digits
+{
+	const size_t sizes[] = { 0, 1, 255, 256, 1000, 70000 };
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto v = make_pattern(p, n);
+			for (size_t i = 0; i != v.size(); ++i) v[i] -= 500000; // negative keys, whose sign bit has to be flipped
+
+			long long sum_before = 0, sum_after = 0;
+			for (auto x : v) sum_before += x;
+
+			ghl::radix_sort(v.begin(), v.end());
+
+			for (auto x : v) sum_after += x;
+			ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+			ASSERT_EQUALS(sum_before, sum_after, "expected to keep the elements")
+		}
+	}
+}
+
+// 64-bit keys with 16-bit digits, and keys that only use their low bits, whose other passes are skipped
+{
+	for (size_t n : { (size_t)1 << 12, (size_t)1 << 22 })
+	{
+		std::mt19937_64 rng(n);
+		ghl::vector<uint64_t> wide(n), narrow(n);
+		for (size_t i = 0; i != n; ++i)
+		{
+			wide.push_back(rng());
+			narrow.push_back(rng() % 1000);
+		}
+		ghl::radix_sort(wide);
+		ghl::radix_sort(narrow);
+		ASSERT_TRUE(is_ascending(wide.begin(), wide.end()), "expected to sort the list")
+		ASSERT_TRUE(is_ascending(narrow.begin(), narrow.end()), "expected to sort the list")
+	}
+}
+
+// floats, including negative ones, zeros and infinities
+{
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+	ghl::vector<float> v(5000);
+	for (size_t i = 0; i != 4990; ++i) v.push_back(dist(rng));
+	const float specials[] = { 0.0f, -0.0f, 1e30f * 1e30f, -1e30f * 1e30f, 1e-40f, -1e-40f, 0.0f, -1.0f, 1.0f, 3.5f };
+	for (auto x : specials) v.push_back(x);
+
+	ghl::radix_sort(v);
+	ASSERT_EQUALS(5000, v.size(), "expected to keep the elements")
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+	ASSERT_TRUE(v[0] < -1e30f && v[4999] > 1e30f, "expected the infinities at the ends")
+}
+
+// records by an extracted key, which is stable
+{
+	ghl::vector<keyed> v(10000);
+	for (size_t i = 0; i != 10000; ++i)
+	{
+		keyed k;
+		k.key = (int)((i * 7919) % 13) - 6;
+		k.index = i;
+		v.push_back(k);
+	}
+	ghl::radix_sort(v.begin(), v.end(), [](const keyed& k) { return k.key; });
+
+	bool b_stable = true;
+	for (size_t i = 0; i + 1 != 10000; ++i)
+	{
+		b_stable = b_stable && (v[i].key < v[i + 1].key || (v[i].key == v[i + 1].key && v[i].index < v[i + 1].index));
+	}
+	ASSERT_TRUE(b_stable, "expected to sort by the key and keep the order of equal keys")
+}
+
+// a type that owns memory, sorted by a key, which has to be moved around correctly
+{
+	ghl::vector<std::string> v(3000);
+	for (size_t i = 0; i != 3000; ++i) v.push_back(std::to_string((i * 7919) % 3000));
+	ghl::radix_sort(v.begin(), v.end(), [](const std::string& s) { return std::stoi(s); });
+	bool b_sorted = true;
+	for (size_t i = 0; i != 3000; ++i) b_sorted = b_sorted && std::to_string(i) == v[i];
+	ASSERT_TRUE(b_sorted, "expected to sort the list")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_american_flag)
+
+// sort an empty set or a list with one element
+{
+	ghl::vector<std::string> v_empty;
+	ghl::american_flag_sort(v_empty);
+	ASSERT_TRUE(v_empty.empty(), "expected to do nothing")
+
+	v_empty.push_back("a");
+	ghl::american_flag_sort(v_empty);
+	ASSERT_EQUALS(1, v_empty.size(), "expected to do nothing")
+}
+
+// strings with long common prefixes, empty strings, duplicates, and chars above 127
+{
+	std::mt19937 rng(11);
+	ghl::vector<std::string> v(20000);
+	for (size_t i = 0; i != 20000; ++i)
+	{
+		std::string s;
+		switch (i % 5)
+		{
+		case 0: break;
+		case 1: s = std::string(100, 'x'); break;
+		case 2: s = "prefix/common/" + std::to_string(rng() % 3000); break;
+		case 3: s.push_back((char)(rng() % 256)); s.push_back((char)(rng() % 256)); break;
+		default: for (size_t k = rng() % 20; k != 0; --k) s.push_back((char)('a' + rng() % 3)); break;
+		}
+		v.push_back(s);
+	}
+	auto w = v;
+
+	ghl::american_flag_sort(v);
+	ghl::introsort(w);
+	bool b_same = true;
+	for (size_t i = 0; i != 20000; ++i) b_same = b_same && v[i] == w[i];
+	ASSERT_TRUE(b_same, "expected to sort the list as the comparison sorts")
+}
+
+// records by an extracted key
+{
+	ghl::vector<std::pair<std::string, int>> v(1000);
+	for (int i = 0; i != 1000; ++i) v.push_back(std::make_pair(std::to_string((i * 7919) % 1000), i));
+	ghl::american_flag_sort(v.begin(), v.end(), [](const std::pair<std::string, int>& p) -> const std::string& { return p.first; });
+	bool b_sorted = true;
+	for (size_t i = 0; i + 1 != 1000; ++i) b_sorted = b_sorted && !(v[i + 1].first < v[i].first);
+	ASSERT_TRUE(b_sorted, "expected to sort the list by the key")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_network)
+
+// every size that the sorting networks of the base cases may get, for keys of 32 and 64 bits, integers and floats
+{
+	std::mt19937_64 rng(5);
+	bool b_sorted = true, b_kept = true;
+	for (size_t n = 0; n != 300; ++n)
+	{
+		ghl::vector<int> ints(n + 1), ints_merge(n + 1);
+		ghl::vector<uint64_t> wide(n + 1);
+		ghl::vector<float> floats(n + 1);
+		ghl::vector<double> doubles(n + 1);
+		long long sum = 0;
+		for (size_t i = 0; i != n; ++i)
+		{
+			const int x = (int)(rng() % 201) - 100;
+			sum += x;
+			ints.push_back(x);
+			ints_merge.push_back(x);
+			wide.push_back(rng());
+			floats.push_back((float)x / 3.0f);
+			doubles.push_back((double)(int64_t)rng());
+		}
+
+		ghl::introsort(ints);
+		ghl::merge_sort(ints_merge);
+		ghl::introsort(wide);
+		ghl::introsort(floats);
+		ghl::introsort(doubles);
+
+		b_sorted = b_sorted && is_ascending(ints.begin(), ints.end()) && is_ascending(ints_merge.begin(), ints_merge.end());
+		b_sorted = b_sorted && is_ascending(wide.begin(), wide.end()) && is_ascending(floats.begin(), floats.end()) && is_ascending(doubles.begin(), doubles.end());
+		for (auto x : ints) sum -= x;
+		b_kept = b_kept && 0 == sum;
+	}
+	ASSERT_TRUE(b_sorted, "expected to sort the lists")
+	ASSERT_TRUE(b_kept, "expected to keep the elements")
+}
+
+// negative zeros and infinities among the floats
+{
+	ghl::vector<float> v{ 0.0f, -0.0f, 1.0f, -1e30f * 1e30f, -0.0f, 1e30f * 1e30f, -2.5f, 0.0f };
+	ghl::introsort(v);
+	ASSERT_TRUE(is_ascending(v.begin(), v.end()), "expected to sort the list")
+	ASSERT_TRUE(v[0] < -1e30f && v[7] > 1e30f, "expected the infinities at the ends")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_partial)
+
+// nth_element puts the nth element in place, and the others on its sides, for all patterns and several n
+{
+	const size_t sizes[] = { 1, 2, 23, 24, 65, 129, 1000, 100000 };
+	bool b_placed = true, b_split = true;
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		for (auto n : sizes)
+		{
+			auto sorted = make_pattern(p, n);
+			ghl::introsort(sorted);
+			for (size_t nth : { (size_t)0, n / 3, n / 2, n - 1 })
+			{
+				auto v = make_pattern(p, n);
+				ghl::nth_element(v, nth);
+				b_placed = b_placed && sorted[nth] == v[nth];
+				for (size_t i = 0; i != n; ++i) b_split = b_split && (i < nth ? !(v[nth] < v[i]) : !(v[i] < v[nth]));
+			}
+		}
+	}
+	ASSERT_TRUE(b_placed, "expected to put the nth element in place")
+	ASSERT_TRUE(b_split, "expected no greater element before it and no lesser one after it")
+}
+
+// nth_element on a list that makes the partitions unbalanced (many equal elements around a few distinct ones), and on strings
+{
+	ghl::vector<int> v(10000);
+	for (int i = 0; i != 10000; ++i) v.push_back(0 == i % 100 ? i : 5);
+	ghl::nth_element(v, 9000);
+	ASSERT_EQUALS(5, v[9000], "expected to put the nth element in place")
+
+	ghl::vector<std::string> s(500);
+	for (int i = 0; i != 500; ++i) s.push_back(std::to_string((i * 7919) % 500));
+	ghl::nth_element(s, 250);
+	ghl::vector<std::string> sorted(s);
+	ghl::introsort(sorted);
+	ASSERT_EQUALS(sorted[250], s[250], "expected to put the nth element in place")
+}
+
+// partial_sort sorts the smallest k elements into the prefix, through the heap for small k and nth_element otherwise
+{
+	bool b_sorted = true, b_kept = true;
+	for (size_t p = 0; p != num_patterns; ++p)
+	{
+		auto sorted = make_pattern(p, 5000);
+		ghl::introsort(sorted);
+		for (size_t k : { 0, 1, 10, 100, 624, 626, 2500, 5000 })
+		{
+			auto v = make_pattern(p, 5000);
+			long long sum = 0;
+			for (auto x : v) sum += x;
+
+			ghl::partial_sort(v, k);
+			for (size_t i = 0; i != k; ++i) b_sorted = b_sorted && sorted[i] == v[i];
+			for (auto x : v) sum -= x;
+			b_kept = b_kept && 0 == sum;
+		}
+	}
+	ASSERT_TRUE(b_sorted, "expected to sort the smallest elements into the prefix")
+	ASSERT_TRUE(b_kept, "expected to keep the elements")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_top_k)
+
+// the top 100 of random floats, ints, int64s and doubles, pushed as arrays (vectorized) and one by one
+{
+	std::mt19937_64 rng(9);
+	ghl::vector<float> floats(100000);
+	ghl::vector<int> ints(100000);
+	ghl::vector<int64_t> wide(100000);
+	ghl::vector<double> doubles(100000);
+	for (size_t i = 0; i != 100000; ++i)
+	{
+		floats.push_back((float)(rng() % 1000000) / 7.0f);
+		ints.push_back((int)(rng() % 2000000) - 1000000);
+		wide.push_back((int64_t)rng());
+		doubles.push_back((double)(int64_t)rng());
+	}
+
+	ghl::top_k<float> top_floats(100), top_floats_one(100);
+	top_floats.push(floats.begin(), floats.end());
+	for (auto x : floats) top_floats_one.push(x);
+	ghl::top_k<int> top_ints(100);
+	top_ints.push(ints.begin(), ints.end());
+	ghl::top_k<int64_t> top_wide(100);
+	top_wide.push(wide.begin(), wide.end());
+	ghl::top_k<double> top_doubles(100);
+	top_doubles.push(doubles.begin(), doubles.end());
+
+	ghl::introsort(floats);
+	ghl::introsort(ints);
+	ghl::introsort(wide);
+	ghl::introsort(doubles);
+
+	ASSERT_EQUALS(100, top_floats.size(), "expected to keep k elements")
+	ASSERT_EQUALS(floats[99900], top_floats.threshold(), "expected the least kept as the threshold")
+	auto f = top_floats.sorted(), f_one = top_floats_one.sorted();
+	auto i = top_ints.sorted();
+	auto w = top_wide.sorted();
+	auto d = top_doubles.sorted();
+	bool b_top = true;
+	for (size_t j = 0; j != 100; ++j)
+	{
+		b_top = b_top && floats[99999 - j] == f[j] && f[j] == f_one[j] && ints[99999 - j] == i[j];
+		b_top = b_top && wide[99999 - j] == w[j] && doubles[99999 - j] == d[j];
+	}
+	ASSERT_TRUE(b_top, "expected the greatest elements from the greatest down")
+}
+
+// fewer elements than k, k = 0, a comparison that keeps the least elements, and clear
+{
+	ghl::top_k<int> top(10);
+	ghl::vector<int> v{ 3, 1, 2 };
+	top.push(v.begin(), v.end());
+	auto res = top.sorted();
+	ASSERT_EQUALS(3, res.size(), "expected to keep all elements")
+	ASSERT_TRUE(3 == res[0] && 2 == res[1] && 1 == res[2], "expected them from the greatest down")
+
+	top.clear();
+	ASSERT_EQUALS(0, top.size(), "expected to be empty")
+
+	ghl::top_k<int> none(0);
+	none.push(v.begin(), v.end());
+	ASSERT_EQUALS(0, none.size(), "expected to keep nothing")
+
+	auto greater = [](int a, int b) { return a > b; };
+	ghl::top_k<int, decltype(greater)> least(2, greater);
+	for (int x : { 5, 9, 4, 7, 1, 8 }) least.push(x);
+	res = least.sorted();
+	ASSERT_TRUE(2 == res.size() && 1 == res[0] && 4 == res[1], "expected the least elements from the least up")
+}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_sorting_projection)
+
+// every sort in descending order by std::greater, on lists long enough for the fast paths
+{
+	auto input = make_pattern(0, 3000);
+	auto sorted = input;
+	ghl::introsort(sorted);
+	auto is_descending = [&sorted](const ghl::vector<int>& v)
+	{
+		for (size_t i = 0; i != v.size(); ++i)
+		{
+			if (v[i] != sorted[v.size() - 1 - i]) return false;
+		}
+		return true;
+	};
+
+	std::greater<> greater;
+	ghl::thread_pool pool(2);
+	ghl::vector<int> v(input);
+	ghl::introsort(v, greater);
+	ASSERT_TRUE(is_descending(v), "expected introsort to sort in descending order")
+	v = input;
+	ghl::merge_sort(v, greater);
+	ASSERT_TRUE(is_descending(v), "expected merge_sort to sort in descending order")
+	v = input;
+	ghl::heap_sort(v, greater);
+	ASSERT_TRUE(is_descending(v), "expected heap_sort to sort in descending order")
+	v = input;
+	ghl::insertion_sort(v, std::greater<int>());
+	ASSERT_TRUE(is_descending(v), "expected insertion_sort to sort in descending order")
+	v = input;
+	ghl::bubble_sort(v.begin(), v.begin() + 300, [](int a, int b) { return a > b; });
+	ghl::selection_sort(v.begin() + 300, v.begin() + 600, greater);
+	bool b_descending = true;
+	for (size_t i = 1; i != 600; ++i) b_descending = b_descending && (300 == i || !(v[i - 1] < v[i]));
+	ASSERT_TRUE(b_descending, "expected the elementary sorts to sort in descending order")
+	v = input;
+	ghl::partial_sort(v, 100, greater);
+	ASSERT_TRUE(sorted[2999] == v[0] && sorted[2900] == v[99], "expected partial_sort to take the greatest elements")
+	v = input;
+	ghl::nth_element(v, 10, greater);
+	ASSERT_EQUALS(sorted[2989], v[10], "expected nth_element to take the nth greatest element")
+	v = input;
+	ghl::parallel_merge_sort(v, pool, 256, greater);
+	ASSERT_TRUE(is_descending(v), "expected parallel_merge_sort to sort in descending order")
+	v = input;
+	ghl::parallel_sample_sort(v, pool, 256, greater);
+	ASSERT_TRUE(is_descending(v), "expected parallel_sample_sort to sort in descending order")
+}
+
+// records by a field, through a pointer to the data member and a lambda, which are stable for the stable sorts
+{
+	ghl::vector<keyed> records(5000);
+	ghl::vector<double> doubles(5000);
+	for (size_t i = 0; i != 5000; ++i)
+	{
+		records.push_back(keyed{ (int)((i * 7919) % 101) - 50, i });
+		doubles.push_back((double)((i * 7919) % 101) - 50.5);
+	}
+
+	// radix sorted, as the key is arithmetic
+	auto by_member = records;
+	ghl::merge_sort(by_member, ghl::detail::less(), &keyed::key);
+	bool b_stable = true;
+	for (size_t i = 1; i != by_member.size(); ++i)
+	{
+		b_stable = b_stable && (by_member[i - 1].key < by_member[i].key || (by_member[i - 1].key == by_member[i].key && by_member[i - 1].index < by_member[i].index));
+	}
+	ASSERT_TRUE(b_stable, "expected merge_sort by a member to sort stably")
+
+	auto descending = records;
+	ghl::merge_sort(descending, std::greater<>(), [](const keyed& r) { return r.key; });
+	b_stable = true;
+	for (size_t i = 1; i != descending.size(); ++i)
+	{
+		b_stable = b_stable && (descending[i - 1].key > descending[i].key || (descending[i - 1].key == descending[i].key && descending[i - 1].index < descending[i].index));
+	}
+	ASSERT_TRUE(b_stable, "expected merge_sort by a descending key to sort stably")
+
+	// a comparison the fast paths do not know, which merge sorts
+	auto by_abs = records;
+	ghl::merge_sort(by_abs, [](int a, int b) { return std::abs(a) < std::abs(b); }, &keyed::key);
+	bool b_sorted = true;
+	for (size_t i = 1; i != by_abs.size(); ++i) b_sorted = b_sorted && std::abs(by_abs[i - 1].key) <= std::abs(by_abs[i].key);
+	ASSERT_TRUE(b_sorted, "expected merge_sort to sort by the comparison")
+
+	auto by_index = records;
+	ghl::introsort(by_index, std::greater<>(), &keyed::index);
+	b_sorted = true;
+	for (size_t i = 0; i != by_index.size(); ++i) b_sorted = b_sorted && by_index[i].index == by_index.size() - 1 - i;
+	ASSERT_TRUE(b_sorted, "expected introsort by a member to sort")
+
+	ghl::introsort(doubles, std::greater<double>());
+	ASSERT_TRUE(doubles[0] == 49.5 && doubles[4999] == -50.5 && !(doubles[0] < doubles[1]), "expected introsort to sort doubles in descending order")
+}
+
+// top_k by a projection
+{
+	ghl::vector<keyed> records(100);
+	for (size_t i = 0; i != 100; ++i) records.push_back(keyed{ (int)((i * 37) % 100), i });
+	ghl::top_k<keyed, ghl::detail::less, int keyed::*> top(3, ghl::detail::less(), &keyed::key);
+	top.push(records.begin(), records.end());
+	auto res = top.sorted();
+	ASSERT_TRUE(3 == res.size() && 99 == res[0].key && 98 == res[1].key && 97 == res[2].key, "expected the records of the greatest keys")
+}
+
+// records by float and double keys, where -0 and +0 compare equal and so keep their order
+{
+	struct float_keyed
+	{
+		float key;
+		double wide_key;
+		size_t index;
+	};
+
+	ghl::vector<float_keyed> records(600);
+	for (size_t i = 0; i != 600; ++i)
+	{
+		const float key = 0 == i % 3 ? 1.5f : 0 == i % 2 ? -0.0f : 0.0f;
+		records.push_back(float_keyed{ key, (double)key, i });
+	}
+
+	auto is_stable = [](const ghl::vector<float_keyed>& v, bool b_descending)
+	{
+		bool b_stable = true;
+		for (size_t i = 1; i != v.size(); ++i)
+		{
+			const float a = v[i - 1].key, b = v[i].key;
+			b_stable = b_stable && ((b_descending ? a > b : a < b) || (a == b && v[i - 1].index < v[i].index));
+		}
+		return b_stable;
+	};
+
+	auto v = records;
+	ghl::merge_sort(v, ghl::detail::less(), &float_keyed::key);
+	ASSERT_TRUE(is_stable(v, false), "expected merge_sort by a float to keep -0 and +0 in order")
+	v = records;
+	ghl::merge_sort(v, std::greater<>(), &float_keyed::key);
+	ASSERT_TRUE(is_stable(v, true), "expected merge_sort by a descending float to keep -0 and +0 in order")
+	v = records;
+	ghl::merge_sort(v, ghl::detail::less(), &float_keyed::wide_key);
+	ASSERT_TRUE(is_stable(v, false), "expected merge_sort by a double to keep -0 and +0 in order")
+}
+
+// records by a bool key, which radix_sort does not take, are merge sorted
+{
+	struct flagged
+	{
+		bool flag;
+		size_t index;
+	};
+
+	ghl::vector<flagged> records(300);
+	for (size_t i = 0; i != 300; ++i) records.push_back(flagged{ 0 != i % 3, i });
+
+	auto v = records;
+	ghl::merge_sort(v, ghl::detail::less(), &flagged::flag);
+	bool b_stable = true;
+	for (size_t i = 1; i != v.size(); ++i)
+	{
+		b_stable = b_stable && (v[i - 1].flag < v[i].flag || (v[i - 1].flag == v[i].flag && v[i - 1].index < v[i].index));
+	}
+	ASSERT_TRUE(b_stable, "expected merge_sort by a bool to sort stably")
+
+	auto perm = ghl::argsort(records, ghl::detail::less(), &flagged::flag);
+	ASSERT_TRUE(300 == perm.size() && 0 == perm[0] && 3 == perm[1] && 1 == perm[100] && 299 == perm[299], "expected argsort by a bool to sort stably")
+}
+
+ENDDEF_TEST_CASE
+
+namespace
+{
+	// a large record that counts how many times it is moved, and that cannot be copied
+	struct heavy
+	{
+		int key = 0;
+		size_t index = 0;
+		size_t moves = 0;
+		char payload[200] = {};
+
+		heavy(int key, size_t index) : key(key), index(index) {}
+		heavy(const heavy&) = delete;
+		heavy(heavy&& other) : key(other.key), index(other.index), moves(other.moves + 1) {}
+		heavy& operator=(heavy&& other)
+		{
+			key = other.key;
+			index = other.index;
+			moves = other.moves + 1;
+			return *this;
+		}
+	};
+}
+
+DEFINE_TEST_CASE(test_sorting_argsort)
+
+// the permutation that sorts, stable, by arithmetic keys (radix sorted) and by other comparisons (merge sorted)
+{
+	auto v = make_pattern(3, 1000);
+	auto perm = ghl::argsort(v);
+	bool b_sorted = perm.size() == v.size();
+	for (size_t i = 1; i < perm.size(); ++i) b_sorted = b_sorted && (v[perm[i - 1]] < v[perm[i]] || (v[perm[i - 1]] == v[perm[i]] && perm[i - 1] < perm[i]));
+	ASSERT_TRUE(b_sorted, "expected the indices in stable sorted order")
+
+	perm = ghl::argsort(v, std::greater<>());
+	b_sorted = true;
+	for (size_t i = 1; i < perm.size(); ++i) b_sorted = b_sorted && (v[perm[i - 1]] > v[perm[i]] || (v[perm[i - 1]] == v[perm[i]] && perm[i - 1] < perm[i]));
+	ASSERT_TRUE(b_sorted, "expected the indices in stable descending order")
+
+	ghl::vector<std::string> s{ "pear", "apple", "fig", "apple", "banana" };
+	perm = ghl::argsort(s);
+	ASSERT_TRUE(1 == perm[0] && 3 == perm[1] && 4 == perm[2] && 2 == perm[3] && 0 == perm[4], "expected the indices in stable sorted order")
+	perm = ghl::argsort(s.begin(), s.end(), ghl::detail::less(), [](const std::string& x) { return x.size(); });
+	ASSERT_TRUE(2 == perm[0] && 0 == perm[1] && 1 == perm[2] && 3 == perm[3] && 4 == perm[4], "expected the indices sorted by the projection")
+
+	ghl::vector<int> empty;
+	ASSERT_TRUE(ghl::argsort(empty).empty(), "expected no indices")
+}
+
+// floats, where -0 and +0 compare equal and so keep their order, by value, by a member, and for large records
+{
+	struct large_float_keyed
+	{
+		float key;
+		size_t index;
+		char payload[200];
+	};
+
+	ghl::vector<float> v(600);
+	std::vector<large_float_keyed> records; // as ghl::vector copies its elements when it grows
+	records.reserve(600);
+	for (size_t i = 0; i != 600; ++i)
+	{
+		const float key = 0 == i % 3 ? -2.0f : 0 == i % 2 ? -0.0f : 0.0f;
+		v.push_back(key);
+		records.push_back(large_float_keyed{ key, i, {} });
+	}
+
+	auto is_stable = [&v](const ghl::vector<size_t>& perm)
+	{
+		bool b_stable = perm.size() == v.size();
+		for (size_t i = 1; i < perm.size(); ++i) b_stable = b_stable && (v[perm[i - 1]] < v[perm[i]] || (v[perm[i - 1]] == v[perm[i]] && perm[i - 1] < perm[i]));
+		return b_stable;
+	};
+	ASSERT_TRUE(is_stable(ghl::argsort(v)), "expected argsort of floats to keep -0 and +0 in order")
+	ASSERT_TRUE(is_stable(ghl::argsort(records.begin(), records.end(), ghl::detail::less(), &large_float_keyed::key)), "expected argsort by a float member to keep -0 and +0 in order")
+
+	auto records_stable = [&records]()
+	{
+		bool b_stable = true;
+		for (size_t i = 1; i != records.size(); ++i)
+		{
+			const auto& a = records[i - 1];
+			const auto& b = records[i];
+			b_stable = b_stable && (a.key < b.key || (a.key == b.key && a.index < b.index));
+		}
+		return b_stable;
+	};
+	auto original = records;
+	ghl::indirect_sort(records.begin(), records.end(), ghl::detail::less(), &large_float_keyed::key);
+	ASSERT_TRUE(records_stable(), "expected indirect_sort by a float to keep -0 and +0 in order")
+	records = original;
+	ghl::merge_sort(records.begin(), records.begin() + 300, records.end(), ghl::detail::less(), &large_float_keyed::key);
+	ASSERT_TRUE(records_stable(), "expected merge_sort of large records by a float to keep -0 and +0 in order")
+}
+
+// apply_permutation reorders in place, moves every element once (and the first of a cycle twice), and restores the permutation
+{
+	ghl::vector<size_t> perm{ 2, 0, 1, 3, 5, 4 };
+	ghl::vector<int> v{ 10, 11, 12, 13, 14, 15 };
+	ghl::apply_permutation(v, perm);
+	ASSERT_TRUE(12 == v[0] && 10 == v[1] && 11 == v[2] && 13 == v[3] && 15 == v[4] && 14 == v[5], "expected the element at i to be the one at perm[i]")
+	ASSERT_TRUE(2 == perm[0] && 0 == perm[1] && 1 == perm[2] && 3 == perm[3] && 5 == perm[4] && 4 == perm[5], "expected the permutation restored")
+}
+
+// indirect_sort of large records, which are moved at most twice
+{
+	const size_t n = 5000;
+	std::mt19937 rng(3);
+	std::vector<heavy> records; // as ghl::vector copies its elements when it grows
+	records.reserve(n);
+	for (size_t i = 0; i != n; ++i) records.emplace_back((int)(rng() % 100), i);
+	for (auto& r : records) r.moves = 0;
+
+	ghl::indirect_sort(records.begin(), records.end(), ghl::detail::less(), &heavy::key);
+	bool b_sorted = true, b_few_moves = true;
+	for (size_t i = 0; i != n; ++i)
+	{
+		if (0 != i) b_sorted = b_sorted && (records[i - 1].key < records[i].key || (records[i - 1].key == records[i].key && records[i - 1].index < records[i].index));
+		b_few_moves = b_few_moves && records[i].moves <= 2;
+	}
+	ASSERT_TRUE(b_sorted, "expected to sort stably")
+	ASSERT_TRUE(b_few_moves, "expected every record to be moved at most twice")
+
+	// which merge_sort also does for large records by an arithmetic key, here in descending order
+	for (auto& r : records) r.moves = 0;
+	ghl::merge_sort(records.begin(), records.begin() + n / 2, records.end(), std::greater<>(), &heavy::key);
+	b_sorted = true;
+	b_few_moves = true;
+	for (size_t i = 0; i != n; ++i)
+	{
+		if (0 != i) b_sorted = b_sorted && (records[i - 1].key > records[i].key || (records[i - 1].key == records[i].key && records[i - 1].index < records[i].index));
+		b_few_moves = b_few_moves && records[i].moves <= 2;
+	}
+	ASSERT_TRUE(b_sorted, "expected merge_sort to sort stably")
+	ASSERT_TRUE(b_few_moves, "expected merge_sort to move every record at most twice")
+}
+
 ENDDEF_TEST_CASE
 
 void test_sortings()
@@ -225,7 +1207,18 @@ void test_sortings()
 			&test_sorting_bubble,
 			&test_sorting_insertion,
 			&test_sorting_selection,
-			&test_sorting_merge
+			&test_sorting_merge,
+			&test_sorting_natural_merge,
+			&test_sorting_heap,
+			&test_sorting_introsort,
+			&test_sorting_parallel,
+			&test_sorting_radix,
+			&test_sorting_american_flag,
+			&test_sorting_network,
+			&test_sorting_partial,
+			&test_sorting_top_k,
+			&test_sorting_projection,
+			&test_sorting_argsort
 		},
 		"test for sortings" 
 	};
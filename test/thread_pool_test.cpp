@@ -0,0 +1,92 @@
+// tests for class thread_pool and task_group
+
+#include "../data_structures/thread_pool.h"
+#include "../unit_test/test_unit.h"
+
+#include <atomic>
+#include <iostream>
+
+namespace
+{
+	// sums [lo, hi) by forking until the ranges are small, to test nested tasks
+	size_t fork_join_sum(ghl::thread_pool& pool, size_t lo, size_t hi)
+	{
+		if (hi - lo <= 100)
+		{
+			size_t sum = 0;
+			for (size_t i = lo; i != hi; ++i) sum += i;
+			return sum;
+		}
+
+		size_t mid = lo + (hi - lo) / 2, left = 0;
+		ghl::task_group group(pool);
+		group.run([&]() { left = fork_join_sum(pool, lo, mid); });
+		size_t right = fork_join_sum(pool, mid, hi);
+		group.wait();
+		return left + right;
+	}
+}
+
+DEFINE_TEST_CASE(test_thread_pool_tasks)
+
+	// tasks submitted are all run
+	{
+		std::atomic<size_t> count(0);
+		{
+			ghl::thread_pool pool(3);
+			ASSERT_EQUALS(3, pool.num_threads(), "expected to have the threads asked for")
+
+			for (size_t i = 0; i != 1000; ++i) pool.submit([&count]() { ++count; });
+		}
+		ASSERT_EQUALS(1000, count.load(), "expected to run every task before being destroyed")
+	}
+
+	// nested fork-join does not deadlock, even with one worker
+	{
+		ghl::thread_pool pool(1);
+		ASSERT_EQUALS((size_t)100000 * 99999 / 2, fork_join_sum(pool, 0, 100000), "expected to get the sum right")
+	}
+
+ENDDEF_TEST_CASE
+
+DEFINE_TEST_CASE(test_thread_pool_parallel_for)
+
+	ghl::thread_pool pool(4);
+
+	// every index is visited once, in blocks of at most grain
+	const size_t n = 10007;
+	std::atomic<unsigned char> visits[n];
+	for (auto& v : visits) v = 0;
+	std::atomic<bool> b_small_blocks(true);
+	pool.parallel_for(0, n, 64, [&](size_t lo, size_t hi)
+	{
+		if (hi - lo > 64) b_small_blocks = false;
+		for (size_t i = lo; i != hi; ++i) ++visits[i];
+	});
+
+	bool b_once = true;
+	for (auto& v : visits) b_once = b_once && 1 == v;
+	ASSERT_TRUE(b_once, "expected to visit every index once")
+	ASSERT_TRUE(b_small_blocks, "expected to keep the blocks within grain")
+
+	// an empty range does nothing
+	bool b_called = false;
+	pool.parallel_for(5, 5, 64, [&](size_t, size_t) { b_called = true; });
+	ASSERT_TRUE(!b_called, "expected to do nothing")
+
+ENDDEF_TEST_CASE
+
+void test_thread_pool()
+{
+	ghl::test_unit unit
+	{
+		{
+			&test_thread_pool_tasks,
+			&test_thread_pool_parallel_for
+		},
+		"tests for thread_pool"
+	};
+
+	unit.execute();
+	std::cout << unit.get_msg() << "\n";
+}